@@ -10,9 +10,26 @@ the results required for program execution. Function includes:
  - ALU Operation: The ALU performs various operations, such as ADD, SUB, SLT, SLTU, XOR, OR, 
     AND, SLL, SRL, SRA, EQ, NEQ, GE, and GEU, depending on the instruction type. The result 
     of the ALU operation is stored in the y_d register.
+ - Multiply and Divide (M_EXTENSION): MUL, MULH, MULHSU, and MULHU are computed in a single 
+    clock cycle by a 33x33 signed multiplier (inferred as DSP blocks). DIV, DIVU, REM, and REMU
+    use a radix-2 restoring divider which stalls the pipeline (o_stall) until the result is 
+    ready. The leading zeros of the dividend are skipped (early termination) so small dividends 
+    take only a few clock cycles, and division by zero takes a single clock cycle.
+ - Bit Manipulation (ZB_EXTENSION): The Zba address generation (SH1ADD, SH2ADD, SH3ADD) and
+    the Zbb basic bit-manipulation operations (ANDN, ORN, XNOR, CLZ, CTZ, CPOP, MIN, MAX, 
+    sign/zero extension, ROL, ROR, ORC.B, and REV8) are all computed in a single clock cycle.
 - Handling Branches and Jumps: The module computes the next PC value based on the instruction 
-    type (e.g., branch, jump, or jump-and-link). It also generates the o_change_pc signal to 
-    indicate whether the PC needs to jump to a new address.
+    type (e.g., branch, jump, or jump-and-link), where the address of the next instruction is PC+2
+    for compressed instructions (i_compressed). The next PC is compared against the prediction
+    made by the fetch stage (i_pred_taken and i_pred_pc) and the o_change_pc signal is generated 
+    only on a misprediction. Resolved branches and jumps are reported back to the branch 
+    predictor via o_branch_resolved and o_branch_taken.
+- Early Trap: ECALL, EBREAK, and illegal instructions always trap, so the fetch stage is 
+    redirected to the trap address (i_trap_address) right away like a taken jump, unless the
+    trap address may still be changed by the instruction at the next stage (i_trap_address_valid
+    is low). The trap itself is still taken at the memory-access stage (exceptions stay precise)
+    and o_trap_fetched tells that its trap handler is already fetched. The rd of the trapping
+    instruction is not written so it is never forwarded to the trap handler.
 - Register Writeback: The module computes the value to be written back to the destination 
     register (rd) and sets the appropriate control signals (o_wr_rd and o_rd_valid) based on
     the instruction type. For example, it disables writing to the destination register for 
@@ -21,6 +38,12 @@ the results required for program execution. Function includes:
     the o_stall_from_alu signal to stall the memory-access stage for load/store instructions 
     since accessing data memory may take multiple cycles. It also handles pipeline stalls 
     and flushes based on the input signals (i_stall, i_force_stall, and i_flush).
+ - Registered Redirect (REGISTER_REDIRECT): The misprediction (o_change_pc and o_next_pc) is 
+    registered so the branch comparison does not drive the next-PC logic of the fetch stage 
+    in the same clock cycle. The redirect is sent while the branch is at the memory-access 
+    stage, and the wrong-path instruction which entered this stage is flushed along with 
+    the previous stages. The branch predictor is still updated at this stage with the 
+    resolved target (o_branch_target).
 */
 
 
@@ -28,7 +51,9 @@ the results required for program execution. Function includes:
 `default_nettype none
 `include "rv32i_header.vh"
 
-module rv32i_alu(
+module rv32i_alu #(parameter M_EXTENSION = 0, ZB_EXTENSION = 0, C_EXTENSION = 0,
+                   REGISTER_REDIRECT = 0 //1 = o_change_pc and o_next_pc are registered (misprediction is sent to fetch stage one clock cycle later)
+                   ) (
     input wire i_clk,i_rst_n,
     input wire[`ALU_WIDTH-1:0] i_alu, //alu operation type from previous stage
     input wire[4:0] i_rs1_addr, //address for register source 1
@@ -44,13 +69,26 @@ module rv32i_alu(
     input wire[`OPCODE_WIDTH-1:0] i_opcode, //opcode type from previous stage
     output reg[`OPCODE_WIDTH-1:0] o_opcode, //opcode type 
     input wire[`EXCEPTION_WIDTH-1:0] i_exception, //exception from decoder stage
-    output reg[`EXCEPTION_WIDTH-1:0] o_exception, //exception: illegal inst,ecall,ebreak,mret
+    output reg[`EXCEPTION_WIDTH-1:0] o_exception, //exception: illegal inst,ecall,ebreak,mret,wfi
     output reg[31:0] o_y, //result of arithmetic operation
     // PC Control
     input wire[31:0] i_pc, //Program Counter
+    input wire i_compressed, //high if instruction is an expanded compressed instruction
     output reg[31:0] o_pc, //pc register in pipeline
+    output reg o_compressed, //high if instruction is an expanded compressed instruction
     output reg[31:0] o_next_pc, //new pc value
     output reg o_change_pc, //high if PC needs to jump
+    output reg o_change_pc_trap, //high if o_change_pc fetches the trap handler (not a misprediction)
+    // Early Trap
+    input wire[31:0] i_trap_address, //trap address of synchronous exceptions (mtvec)
+    input wire i_trap_address_valid, //high if i_trap_address can be used (not changed by an instruction at next stage)
+    output reg o_trap_fetched, //instruction at next stage already redirected the fetch stage to its trap address
+    // Branch Prediction
+    input wire i_pred_taken, //high if instruction was predicted as a taken branch/jump by fetch stage
+    input wire[31:0] i_pred_pc, //predicted target address
+    output reg o_branch_resolved, //high when a branch/jump is resolved at this stage (update branch predictor)
+    output reg o_branch_taken, //high if the resolved branch/jump is taken
+    output reg[31:0] o_branch_target, //target address of the resolved branch/jump (not registered even with REGISTER_REDIRECT)
     // Basereg Control
     output reg o_wr_rd, //write rd to the base reg if enabled
     input wire[4:0] i_rd_addr, //address for destination register (from previous stage)
@@ -61,6 +99,7 @@ module rv32i_alu(
     output reg o_stall_from_alu, //prepare to stall next stage(memory-access stage) for load/store instruction
     input wire i_ce, // input clk enable for pipeline stalling of this stage
     output reg o_ce, // output clk enable for pipeline stalling of next stage
+    output reg o_done, //high when the instruction at this stage moves to the next stage (not flushed)
     input wire i_stall, //informs this stage to stall
     input wire i_force_stall, //force this stage to stall
     output reg o_stall, //informs pipeline to stall
@@ -82,6 +121,35 @@ module rv32i_alu(
     wire alu_neq = i_alu[`NEQ];
     wire alu_ge = i_alu[`GE];
     wire alu_geu = i_alu[`GEU];
+    wire alu_mul = i_alu[`MUL];
+    wire alu_mulh = i_alu[`MULH];
+    wire alu_mulhsu = i_alu[`MULHSU];
+    wire alu_mulhu = i_alu[`MULHU];
+    wire alu_div = i_alu[`DIV];
+    wire alu_divu = i_alu[`DIVU];
+    wire alu_rem = i_alu[`REM];
+    wire alu_remu = i_alu[`REMU];
+    wire alu_sh1add = i_alu[`SH1ADD];
+    wire alu_sh2add = i_alu[`SH2ADD];
+    wire alu_sh3add = i_alu[`SH3ADD];
+    wire alu_andn = i_alu[`ANDN];
+    wire alu_orn = i_alu[`ORN];
+    wire alu_xnor = i_alu[`XNOR];
+    wire alu_clz = i_alu[`CLZ];
+    wire alu_ctz = i_alu[`CTZ];
+    wire alu_cpop = i_alu[`CPOP];
+    wire alu_min = i_alu[`MIN];
+    wire alu_minu = i_alu[`MINU];
+    wire alu_max = i_alu[`MAX];
+    wire alu_maxu = i_alu[`MAXU];
+    wire alu_sextb = i_alu[`SEXTB];
+    wire alu_sexth = i_alu[`SEXTH];
+    wire alu_zexth = i_alu[`ZEXTH];
+    wire alu_rol = i_alu[`ROL];
+    wire alu_ror = i_alu[`ROR];
+    wire alu_orcb = i_alu[`ORCB];
+    wire alu_rev8 = i_alu[`REV8];
+    wire alu_bitmanip = alu_sh1add || alu_sh2add || alu_sh3add || alu_andn || alu_orn || alu_xnor || alu_clz || alu_ctz || alu_cpop || alu_min || alu_minu || alu_max || alu_maxu || alu_sextb || alu_sexth || alu_zexth || alu_rol || alu_ror || alu_orcb || alu_rev8;
     wire opcode_rtype = i_opcode[`RTYPE];
     wire opcode_itype = i_opcode[`ITYPE];
     wire opcode_load = i_opcode[`LOAD];
@@ -89,6 +157,8 @@ module rv32i_alu(
     wire opcode_branch = i_opcode[`BRANCH];
     wire opcode_jal = i_opcode[`JAL];
     wire opcode_jalr = i_opcode[`JALR];
+    wire opcode_amo = i_opcode[`AMO];
+    wire opcode_custom = i_opcode[`CUSTOM];
     wire opcode_lui = i_opcode[`LUI];
     wire opcode_auipc = i_opcode[`AUIPC];
     wire opcode_system = i_opcode[`SYSTEM];
@@ -102,7 +172,22 @@ module rv32i_alu(
     reg rd_valid_d; //high if rd is valid (not load nor csr instruction)
     reg[31:0] a_pc;
     wire[31:0] sum;
+    wire[31:0] pc_next = i_pc + ((C_EXTENSION != 0 && i_compressed)? 32'd2 : 32'd4); //address of next instruction when branch is not taken
     wire stall_bit = o_stall || i_stall;
+    reg redirect_q; //registered misprediction (REGISTER_REDIRECT)
+    reg[31:0] redirect_pc_q; //registered new pc value (REGISTER_REDIRECT)
+    reg redirect_d; //misprediction of the instruction at this stage
+    reg[31:0] redirect_pc_d; //new pc value of the instruction at this stage
+    reg redirect_trap_q; //registered misprediction is a trap redirect (REGISTER_REDIRECT)
+    reg redirect_trap_d; //redirect of the instruction at this stage is a trap redirect
+    wire trap_d = (i_exception[`ILLEGAL] || i_exception[`ECALL] || i_exception[`EBREAK]) && i_trap_address_valid; //instruction at this stage fetches its trap handler
+    wire flush_bit = i_flush || redirect_q; //flush this stage (instruction after a registered misprediction is on the wrong path)
+    //multiplier and divider
+    wire[63:0] product; //product of operands (signed or unsigned based on operation)
+    wire[31:0] div_result; //quotient or remainder
+    wire div_stall; //high while the divider is still computing
+    //bit manipulation
+    wire[31:0] bitmanip_y; //result of Zba/Zbb operation
 
     //register the output of i_alu
     always @(posedge i_clk, negedge i_rst_n) begin
@@ -110,6 +195,9 @@ module rv32i_alu(
             o_exception <= 0;
             o_ce <= 0;
             o_stall_from_alu <= 0;
+            o_trap_fetched <= 0;
+            redirect_q <= 0;
+            redirect_trap_q <= 0;
         end
         else begin
             if(i_ce && !stall_bit) begin //update register only if this stage is enabled
@@ -127,8 +215,15 @@ module rv32i_alu(
                 o_wr_rd <= wr_rd_d;
                 o_stall_from_alu <= i_opcode[`STORE] || i_opcode[`LOAD]; //stall next stage(memory-access stage) when need to store/load 
                 o_pc <= i_pc;                                               //since accessing data memory always takes more than 1 cycle
+                o_compressed <= i_compressed;
+                o_trap_fetched <= trap_d;
             end
-            if(i_flush && !stall_bit) begin //flush this stage so clock-enable of next stage is disabled at next clock cycle
+            if(!stall_bit) begin //misprediction is held while stalled since fetch stage only changes PC when not stalled
+                redirect_q <= REGISTER_REDIRECT != 0 && redirect_d;
+                redirect_pc_q <= redirect_pc_d;
+                redirect_trap_q <= redirect_trap_d;
+            end
+            if(flush_bit && !stall_bit) begin //flush this stage so clock-enable of next stage is disabled at next clock cycle
                 o_ce <= 0;
             end
             else if(!stall_bit) begin //clock-enable will change only when not stalled
@@ -146,6 +241,7 @@ module rv32i_alu(
         
         a = (opcode_jal || opcode_auipc)? i_pc:i_rs1;  // a can either be pc or rs1
         b = (opcode_rtype || opcode_branch)? i_rs2:i_imm; // b can either be rs2 or imm 
+        if(opcode_amo || opcode_custom) b = 0; //address of atomic instruction and rs1 of custom instruction are passed unchanged (immediate holds funct5/funct7)
         
         if(alu_add) y_d = a + b;
         if(alu_sub) y_d = a - b;
@@ -167,51 +263,231 @@ module rv32i_alu(
             y_d = {31'b0, (a >= b)};
             if(alu_ge) y_d = (a[31] ^ b[31])? {31'b0, b[31]}:y_d;
         end
+        if(alu_mul) y_d = product[31:0];
+        if(alu_mulh || alu_mulhsu || alu_mulhu) y_d = product[63:32];
+        if(alu_div || alu_divu || alu_rem || alu_remu) y_d = div_result;
+        if(alu_bitmanip) y_d = bitmanip_y;
     end
 
     
     //determine o_rd to be saved to baseg and next value of PC
     always @* begin
-        o_flush = i_flush; //flush this stage along with the previous stages
+        //stall logic (stall when upper stages are stalled, when forced to stall, or when needs to flush previous stages but are still stalled)
+        o_stall = (i_stall || i_force_stall || div_stall) && !flush_bit; //stall when alu needs wait time
+        o_flush = flush_bit; //flush this stage along with the previous stages
+        o_done = i_ce && !stall_bit && !flush_bit;
         rd_d = 0;
         rd_valid_d = 0;
         o_change_pc = 0;
+        o_change_pc_trap = 0;
         o_next_pc = 0;
+        o_branch_taken = 0;
+        o_branch_resolved = 0;
+        o_branch_target = 0;
         wr_rd_d = 0;
         a_pc = i_pc;
-        if(!i_flush) begin
+        if(!flush_bit) begin
             if(opcode_rtype || opcode_itype) rd_d = y_d;
             if(opcode_branch && y_d[0]) begin
                     o_next_pc = sum; //branch iff value of ALU is 1(true)
-                    o_change_pc = i_ce; //change PC when ce of this stage is high (o_change_pc is valid)
-                    o_flush = i_ce;
+                    o_branch_taken = 1;
             end
             if(opcode_jal || opcode_jalr) begin
                 if(opcode_jalr) a_pc = i_rs1;
                 o_next_pc = sum; //jump to new PC
-                o_change_pc = i_ce; //change PC when ce of this stage is high (o_change_pc is valid)
-                o_flush = i_ce;
-                rd_d = i_pc + 4; //register the next pc value to destination register
+                if(opcode_jalr) o_next_pc[0] = 1'b0; //least-significant bit of JALR target is cleared
+                o_branch_taken = 1;
+                rd_d = pc_next; //register the next pc value to destination register
             end 
+            if(!o_branch_taken) o_next_pc = pc_next; 
+            o_branch_target = o_next_pc;
+            //change PC only when fetch stage predicted the wrong next PC (operands are only valid when this stage is not stalled)
+            if((o_branch_taken != i_pred_taken) || (o_branch_taken && o_next_pc != i_pred_pc)) begin
+                o_change_pc = i_ce && !o_stall; //change PC when ce of this stage is high (o_change_pc is valid)
+                o_flush = i_ce && !o_stall;
+            end
+            //update branch predictor once for every branch/jump (or an instruction wrongly predicted as taken)
+            o_branch_resolved = i_ce && !stall_bit && (opcode_branch || opcode_jal || opcode_jalr || i_pred_taken);
+            //ECALL, EBREAK, and illegal instruction fetch their trap handler right away (trap is taken at memory-access stage)
+            if(trap_d) begin
+                o_next_pc = i_trap_address;
+                o_change_pc = i_ce && !o_stall;
+                o_change_pc_trap = 1;
+                o_flush = i_ce && !o_stall;
+            end
         end
         if(opcode_lui) rd_d = i_imm;
         if(opcode_auipc) rd_d = sum;
 
         if(opcode_branch || opcode_store || (opcode_system && i_funct3 == 0) || opcode_fence ) wr_rd_d = 0; //i_funct3==0 are the non-csr system instructions 
         else wr_rd_d = 1; //always write to the destination reg except when instruction is BRANCH or STORE or SYSTEM(except CSR system instruction)  
+        if(trap_d) wr_rd_d = 0; //rd of trapping instruction is not forwarded to the trap handler
 
         if(opcode_load || (opcode_system && i_funct3!=0)) rd_valid_d = 0;  //value of o_rd for load and CSR write is not yet available at this stage
         else rd_valid_d = 1;
 
-        //stall logic (stall when upper stages are stalled, when forced to stall, or when needs to flush previous stages but are still stalled)
-        o_stall = (i_stall || i_force_stall) && !i_flush; //stall when alu needs wait time
+        redirect_d = o_change_pc;
+        redirect_pc_d = o_next_pc;
+        redirect_trap_d = o_change_pc_trap;
+        if(REGISTER_REDIRECT != 0) begin //send the registered misprediction instead (previous stages are flushed at the same time)
+            o_change_pc = redirect_q && !i_stall; //fetch stage changes PC as soon as this is high
+            o_change_pc_trap = redirect_trap_q;
+            o_next_pc = redirect_pc_q;
+            o_flush = flush_bit;
+        end
     end
         
     assign sum = a_pc + i_imm; //share adder for all addition operation for less resource utilization
 
+    // M extension: single-cycle multiplier and multi-cycle divider
+    if(M_EXTENSION != 0) begin: muldiv
+        //operands are sign-extended to 33 bits so a single signed multiplier handles all multiply operations
+        wire signed[32:0] mul_a = {(alu_mulh || alu_mulhsu) && a[31], a};
+        wire signed[32:0] mul_b = {alu_mulh && b[31], b};
+        wire signed[65:0] mul_y = mul_a * mul_b;
+        assign product = mul_y[63:0];
+
+        reg div_busy; //divider is computing
+        reg div_done; //result is ready (cleared once the instruction leaves this stage)
+        reg[5:0] div_count; //number of quotient bits left to compute
+        reg[31:0] div_quotient; //dividend bits not yet processed which are shifted out as quotient bits are shifted in
+        reg[31:0] div_remainder; //partial remainder
+        reg[31:0] div_divisor; //magnitude of divisor
+        reg div_negate_quotient, div_negate_remainder; //sign of result for signed division
+        reg[5:0] div_lz; //leading zeros of dividend magnitude
+        wire div_op = alu_div || alu_divu || alu_rem || alu_remu;
+        wire div_signed = alu_div || alu_rem;
+        wire[31:0] div_dividend_abs = (div_signed && a[31])? -a : a; //magnitude of dividend
+        wire[31:0] div_divisor_abs = (div_signed && b[31])? -b : b; //magnitude of divisor
+        //operands are only valid when not forced to stall (forwarded operand not yet available)
+        wire div_start = i_ce && div_op && !div_busy && !div_done && !i_force_stall && !flush_bit;
+        wire[32:0] div_diff = {div_remainder[31:0], div_quotient[31]} - {1'b0, div_divisor}; //trial subtraction
+        integer i;
+
+        assign div_stall = i_ce && div_op && !div_done;
+        assign div_result = (alu_div || alu_divu)? (div_negate_quotient? -div_quotient : div_quotient) : (div_negate_remainder? -div_remainder : div_remainder);
+
+        //count leading zeros of dividend so the zero quotient bits are skipped
+        always @* begin
+            div_lz = 32;
+            for(i = 0; i < 32; i = i + 1) begin
+                if(div_dividend_abs[i]) div_lz = 31 - i;
+            end
+        end
+
+        always @(posedge i_clk, negedge i_rst_n) begin
+            if(!i_rst_n) begin
+                div_busy <= 0;
+                div_done <= 0;
+            end
+            else begin
+                if(div_start) begin
+                    div_remainder <= 0;
+                    div_divisor <= div_divisor_abs;
+                    div_negate_quotient <= div_signed && (a[31] ^ b[31]) && b != 0; //quotient of division by zero is all ones
+                    div_negate_remainder <= div_signed && a[31]; //remainder has the same sign as dividend
+                    if(b == 0) begin //division by zero: quotient is all ones and remainder is the dividend
+                        div_quotient <= {32{1'b1}};
+                        div_remainder <= div_dividend_abs;
+                        div_done <= 1;
+                    end
+                    else if(div_lz == 32) begin //dividend is zero
+                        div_quotient <= 0;
+                        div_done <= 1;
+                    end
+                    else begin
+                        div_quotient <= div_dividend_abs << div_lz; //skip leading zeros (early termination)
+                        div_count <= 32 - div_lz;
+                        div_busy <= 1;
+                    end
+                end
+                else if(div_busy) begin //compute one quotient bit per clock cycle
+                    if(!div_diff[32]) begin //partial remainder is greater than or equal to divisor
+                        div_remainder <= div_diff[31:0];
+                        div_quotient <= {div_quotient[30:0], 1'b1};
+                    end
+                    else begin
+                        div_remainder <= {div_remainder[30:0], div_quotient[31]};
+                        div_quotient <= {div_quotient[30:0], 1'b0};
+                    end
+                    div_count <= div_count - 1;
+                    if(div_count == 1) begin
+                        div_busy <= 0;
+                        div_done <= 1;
+                    end
+                end
+                //result is consumed when the instruction leaves this stage
+                if(div_done && i_ce && !stall_bit) div_done <= 0;
+                if(flush_bit) begin
+                    div_busy <= 0;
+                    div_done <= 0;
+                end
+            end
+        end
+    end
+    else begin: muldiv
+        assign product = 0;
+        assign div_result = 0;
+        assign div_stall = 0;
+    end
+
+    // Zba/Zbb extension: single-cycle bit-manipulation operations
+    if(ZB_EXTENSION != 0) begin: bitmanip
+        reg[31:0] y; 
+        reg[5:0] count; //number of leading/trailing zeros or set bits
+        wire[63:0] rotate_left = {a, a} << b[4:0]; 
+        wire[63:0] rotate_right = {a, a} >> b[4:0];
+        wire less_than = (a[31] ^ b[31])? ((alu_min || alu_max)? a[31] : b[31]) : a < b; //signed or unsigned comparison 
+        integer i;
+
+        assign bitmanip_y = y;
+
+        always @* begin
+            count = 0;
+            if(alu_clz) begin 
+                count = 32;
+                for(i = 0; i < 32; i = i + 1) begin
+                    if(a[i]) count = 31 - i;
+                end
+            end
+            if(alu_ctz) begin
+                count = 32;
+                for(i = 31; i >= 0; i = i - 1) begin
+                    if(a[i]) count = i;
+                end
+            end
+            if(alu_cpop) begin
+                for(i = 0; i < 32; i = i + 1) begin
+                    count = count + a[i];
+                end
+            end
+
+            y = 0;
+            if(alu_sh1add) y = b + {a[30:0], 1'b0};
+            if(alu_sh2add) y = b + {a[29:0], 2'b0};
+            if(alu_sh3add) y = b + {a[28:0], 3'b0};
+            if(alu_andn) y = a & ~b;
+            if(alu_orn) y = a | ~b;
+            if(alu_xnor) y = ~(a ^ b);
+            if(alu_clz || alu_ctz || alu_cpop) y = {26'b0, count};
+            if(alu_min || alu_minu) y = less_than? a : b;
+            if(alu_max || alu_maxu) y = less_than? b : a;
+            if(alu_sextb) y = {{24{a[7]}}, a[7:0]};
+            if(alu_sexth) y = {{16{a[15]}}, a[15:0]};
+            if(alu_zexth) y = {16'b0, a[15:0]};
+            if(alu_rol) y = rotate_left[63:32];
+            if(alu_ror) y = rotate_right[31:0];
+            if(alu_orcb) y = {{8{|a[31:24]}}, {8{|a[23:16]}}, {8{|a[15:8]}}, {8{|a[7:0]}}};
+            if(alu_rev8) y = {a[7:0], a[15:8], a[23:16], a[31:24]};
+        end
+    end
+    else begin: bitmanip
+        assign bitmanip_y = 0;
+    end
+
     `ifdef FORMAL
         // assumption on inputs(not more than one opcode and alu operation is high)
-        wire[4:0] f_alu=i_alu[`ADD]+i_alu[`SUB]+i_alu[`SLT]+i_alu[`SLTU]+i_alu[`XOR]+i_alu[`OR]+i_alu[`AND]+i_alu[`SLL]+i_alu[`SRL]+i_alu[`SRA]+i_alu[`EQ]+i_alu[`NEQ]+i_alu[`GE]+i_alu[`GEU]+0;
+        wire[5:0] f_alu=i_alu[`ADD]+i_alu[`SUB]+i_alu[`SLT]+i_alu[`SLTU]+i_alu[`XOR]+i_alu[`OR]+i_alu[`AND]+i_alu[`SLL]+i_alu[`SRL]+i_alu[`SRA]+i_alu[`EQ]+i_alu[`NEQ]+i_alu[`GE]+i_alu[`GEU]+i_alu[`MUL]+i_alu[`MULH]+i_alu[`MULHSU]+i_alu[`MULHU]+i_alu[`DIV]+i_alu[`DIVU]+i_alu[`REM]+i_alu[`REMU]+i_alu[`SH1ADD]+i_alu[`SH2ADD]+i_alu[`SH3ADD]+i_alu[`ANDN]+i_alu[`ORN]+i_alu[`XNOR]+i_alu[`CLZ]+i_alu[`CTZ]+i_alu[`CPOP]+i_alu[`MIN]+i_alu[`MINU]+i_alu[`MAX]+i_alu[`MAXU]+i_alu[`SEXTB]+i_alu[`SEXTH]+i_alu[`ZEXTH]+i_alu[`ROL]+i_alu[`ROR]+i_alu[`ORCB]+i_alu[`REV8]+0;
         wire[4:0] f_opcode=i_opcode[`RTYPE]+i_opcode[`ITYPE]+i_opcode[`LOAD]+i_opcode[`STORE]+i_opcode[`BRANCH]+i_opcode[`JAL]+i_opcode[`JALR]+i_opcode[`LUI]+i_opcode[`AUIPC]+i_opcode[`SYSTEM]+i_opcode[`FENCE];
 
         always @* begin
@@ -228,6 +504,10 @@ module rv32i_alu(
             if(i_alu[`SRA]) assert($signed(y_d) == ($signed(a) >>> $unsigned(b[4:0])));
             if(i_alu[`GEU]) assert(y_d[0] == ($unsigned(a) >= $unsigned(b)));
             if(i_alu[`GE]) assert(y_d[0] == ($signed(a) >= $signed(b)));
+            if(i_alu[`MUL] && M_EXTENSION != 0) assert(y_d == a * b);
+            if(i_alu[`MULHU] && M_EXTENSION != 0) assert(y_d == ({32'b0, a} * {32'b0, b}) >> 32);
+            if(i_alu[`MIN] && ZB_EXTENSION != 0) assert(y_d == (($signed(a) < $signed(b))? a : b));
+            if(i_alu[`MAXU] && ZB_EXTENSION != 0) assert(y_d == (($unsigned(a) > $unsigned(b))? a : b));
         end
         
     `endif
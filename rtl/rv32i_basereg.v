@@ -1,38 +1,76 @@
-//regfile controller for the 32 integer base registers
-
-`timescale 1ns / 1ps
-`default_nettype none
-
-module rv32i_basereg
-    (
-        input wire i_clk,
-        input wire i_ce_read, //clock enable for reading from basereg [STAGE 2]
-        input wire[4:0] i_rs1_addr, //source register 1 address
-        input wire[4:0] i_rs2_addr, //source register 2 address
-        input wire[4:0] i_rd_addr, //destination register address
-        input wire[31:0] i_rd, //data to be written to destination register
-        input wire i_wr, //write enable
-        output wire[31:0] o_rs1, //source register 1 value
-        output wire[31:0] o_rs2 //source register 2 value
-    );
-    
-    reg[4:0] rs1_addr_q, rs2_addr_q;
-    reg[31:0] base_regfile[31:1]; //base register file (base_regfile[0] is hardwired to zero)
-    wire write_to_basereg;
-    
-    always @(posedge i_clk) begin
-        if(write_to_basereg) begin //only write to register if stage 5 is previously enabled (output of stage 5[WRITEBACK] is registered so delayed by 1 clk)
-           base_regfile[i_rd_addr] <= i_rd; //synchronous write
-        end
-        if(i_ce_read) begin //only read the register if stage 2 is enabled [DECODE]
-            rs1_addr_q <= i_rs1_addr; //synchronous read
-            rs2_addr_q <= i_rs2_addr; //synchronous read
-        end
-    end
-    
-    assign write_to_basereg = i_wr && i_rd_addr!=0; //no need to write to basereg 0 (hardwired to zero) 
-    assign o_rs1 = rs1_addr_q==0? 0: base_regfile[rs1_addr_q]; // if regfile is about to be written at the same time we read it
-    assign o_rs2 = rs2_addr_q==0? 0: base_regfile[rs2_addr_q];    //then return the next value to be written to that address
-    
-endmodule
-
+//regfile controller for the 32 integer base registers (plus a second bank of 31 shadow 
+//registers when SHADOW_REGS is enabled, selected by i_bank for both read and write). Each of the
+//THREADS threads has its own registers (and shadow registers) selected by i_thread. The second
+//pair of read ports and the second write port are for the second issue slot (dual issue) and
+//are removed by synthesis when unused. The second write port wins when both write the same register.
+//The third write port writes the data of a parked load to the registers of its thread (multithreading).
+
+`timescale 1ns / 1ps
+`default_nettype none
+
+module rv32i_basereg #(parameter SHADOW_REGS = 0, THREADS = 1)
+    (
+        input wire i_clk,
+        input wire i_bank, //register bank used by both read and write (0 = base registers, 1 = shadow registers)
+        input wire[1:0] i_thread, //thread whose registers are used by both read and write (0 when THREADS = 1)
+        input wire i_ce_read, //clock enable for reading from basereg [STAGE 2]
+        input wire[4:0] i_rs1_addr, //source register 1 address
+        input wire[4:0] i_rs2_addr, //source register 2 address
+        input wire[4:0] i_rd_addr, //destination register address
+        input wire[31:0] i_rd, //data to be written to destination register
+        input wire i_wr, //write enable
+        output wire[31:0] o_rs1, //source register 1 value
+        output wire[31:0] o_rs2, //source register 2 value
+        output wire[31:0] o_rs1_early, //source register 1 value read at decode stage (for early branch resolution)
+        output wire[31:0] o_rs2_early, //source register 2 value read at decode stage (for early branch resolution)
+        // Second issue slot (dual issue)
+        input wire[4:0] i_slot1_rs1_addr, //source register 1 address
+        input wire[4:0] i_slot1_rs2_addr, //source register 2 address
+        input wire[4:0] i_slot1_rd_addr, //destination register address
+        input wire[31:0] i_slot1_rd, //data to be written to destination register
+        input wire i_slot1_wr, //write enable (instruction is younger than the one written by i_wr)
+        output wire[31:0] o_slot1_rs1, //source register 1 value
+        output wire[31:0] o_slot1_rs2, //source register 2 value
+        // Parked load (multithreading)
+        input wire[2:0] i_park_bank, //{thread, bank} of the registers written by the parked load
+        input wire[4:0] i_park_rd_addr, //destination register address
+        input wire[31:0] i_park_rd, //data to be written to destination register
+        input wire i_park_wr //write enable
+    );
+    
+    reg[4:0] rs1_addr_q, rs2_addr_q;
+    reg[4:0] slot1_rs1_addr_q, slot1_rs2_addr_q;
+    localparam BANKS = (THREADS > 1)? THREADS : 1; 
+    reg[31:0] base_regfile[32*BANKS*((SHADOW_REGS != 0)? 2:1)-1 : 1]; //base register file (base_regfile[0] is hardwired to zero), shadow registers at base_regfile[63:33] (of each thread)
+    wire write_to_basereg;
+    wire[2:0] bank = (SHADOW_REGS != 0)? {i_thread, i_bank} : {1'b0, (THREADS > 1)? i_thread : 2'b00}; //registers of thread (and shadow registers)
+    wire[2:0] park_bank = (SHADOW_REGS != 0)? i_park_bank : {1'b0, i_park_bank[2:1]};
+    
+    always @(posedge i_clk) begin
+        if(write_to_basereg) begin //only write to register if stage 5 is previously enabled (output of stage 5[WRITEBACK] is registered so delayed by 1 clk)
+           base_regfile[{bank,i_rd_addr}] <= i_rd; //synchronous write
+        end
+        if(i_slot1_wr && i_slot1_rd_addr != 0) begin
+           base_regfile[{bank,i_slot1_rd_addr}] <= i_slot1_rd; 
+        end
+        if(THREADS > 1 && i_park_wr && i_park_rd_addr != 0) begin //registers of another thread (never written at the same time by the other ports)
+           base_regfile[{park_bank,i_park_rd_addr}] <= i_park_rd; 
+        end
+        if(i_ce_read) begin //only read the register if stage 2 is enabled [DECODE]
+            rs1_addr_q <= i_rs1_addr; //synchronous read
+            rs2_addr_q <= i_rs2_addr; //synchronous read
+            slot1_rs1_addr_q <= i_slot1_rs1_addr;
+            slot1_rs2_addr_q <= i_slot1_rs2_addr;
+        end
+    end
+    
+    assign write_to_basereg = i_wr && i_rd_addr!=0; //no need to write to basereg 0 (hardwired to zero) 
+    assign o_rs1 = rs1_addr_q==0? 0: base_regfile[{bank,rs1_addr_q}]; // if regfile is about to be written at the same time we read it
+    assign o_rs2 = rs2_addr_q==0? 0: base_regfile[{bank,rs2_addr_q}];    //then return the next value to be written to that address
+    assign o_rs1_early = i_rs1_addr==0? 0: base_regfile[{bank,i_rs1_addr}]; //read ports for decode stage (removed by synthesis
+    assign o_rs2_early = i_rs2_addr==0? 0: base_regfile[{bank,i_rs2_addr}]; //when early branch resolution is disabled)
+    assign o_slot1_rs1 = slot1_rs1_addr_q==0? 0: base_regfile[{bank,slot1_rs1_addr_q}];
+    assign o_slot1_rs2 = slot1_rs2_addr_q==0? 0: base_regfile[{bank,slot1_rs2_addr_q}];
+    
+endmodule
+
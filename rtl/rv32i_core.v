@@ -12,43 +12,138 @@ sub-modules that carry out various functions within the processor:
  - rv32i_basereg: This sub-module serves as a controller for the 32 integer 
     base registers. It manages reading from and writing to the register file, 
     with read operations occurring during the Decode stage and write operations 
-    during the Writeback stage.
+    during the Writeback stage. When SHADOW_REGS is enabled, it also holds a
+    second register bank used by trap handlers (selected by the mbank CSR).
  - rv32i_fetch: This sub-module is responsible for fetching instructions from
     the instruction memory. It generates the instruction address, retrieves 
-    the instruction, and controls the program counter (PC). It also manages 
-    the pipeline stall and flush signals for the Fetch stage.
+    the instruction, and controls the program counter (PC). It also predicts
+    the next PC of branches and jumps (static BTFN or a BTB with 2-bit counters
+    as selected by BRANCH_PREDICTOR, and a return address stack for returns),
+    keeps on fetching ahead into a prefetch queue (PREFETCH_DEPTH) while the
+    next stages are stalled, and manages the pipeline stall and flush signals
+    for the Fetch stage. When C_EXTENSION is enabled, it also splits the fetched
+    words into 16-bit and 32-bit instructions and expands the compressed
+    instructions (rv32i_expander) to their 32-bit equivalent.
+ - rv32i_skid: This sub-module is a skid buffer between the Fetch and Decode
+    stages. The fetch stage hands over its instruction with a ready/valid
+    handshake where the stall is a register (the skid buffer is full), so the
+    stall of the next stages (e.g. waiting for the data memory ack) does not
+    reach the PC and prefetch logic of the fetch stage in the same clock cycle.
+    Only the Fetch/Decode boundary has a skid buffer: the later stages keep
+    the fixed-distance stall since operand forwarding and the regfile read
+    latch rely on each producer being a fixed number of stages away.
  - rv32i_decoder: This sub-module takes care of decoding the fetched 32-bit
     instruction. It extracts various fields from the instruction, such as opcode,
     function type, immediate value, and register addresses. The sub-module also 
-    detects exceptions, manages pipeline stall and flush signals for the Decode 
-    stage, and provides a clock enable signal for the next stage.
+    detects exceptions, resolves JAL and branches early when their operands are
+    available (EARLY_BRANCH), manages pipeline stall and flush signals for the 
+    Decode stage, and provides a clock enable signal for the next stage.
  - rv32i_alu: This sub-module is the Arithmetic Logic Unit (ALU) of the core.
     It performs arithmetic and logical operations based on the opcode and 
-    function type provided by the decoder. It also controls the program counter
-    for branches and jumps, manages register write enable signals, and handles 
-    pipeline stall and flush signals for the Execute stage.
+    function type provided by the decoder, including the multiply/divide
+    operations of the M extension (M_EXTENSION) and the Zba/Zbb bit-manipulation
+    operations (ZB_EXTENSION). It also resolves branches and jumps
+    (changing the program counter only on a misprediction), fetches the trap
+    handler of ECALL, EBREAK, and illegal instructions early (EARLY_TRAP),
+    manages register write enable signals, and handles pipeline stall and flush
+    signals for the Execute stage.
  - rv32i_memoryaccess: This sub-module controls data memory access for load and 
     store operations. It computes the memory address based on the ALU output 
     and provides the appropriate signals for reading from or writing to the data
-    memory. The sub-module also manages pipeline stall and flush signals for 
-    the Memory Access stage.
+    memory using pipelined wishbone with up to DATA_MAX_REQUESTS outstanding 
+    requests. Stores are posted to a store buffer (STORE_BUFFER_DEPTH) which 
+    also forwards data to later loads. When A_EXTENSION is enabled, it also
+    keeps the LR/SC reservation and performs the read-modify-write of AMOs as
+    a locked wishbone sequence (with MULTI_HART, writes of other harts clear the
+    reservation and SC is also locked). When COPROCESSOR is enabled, it also sends the
+    custom instructions to the coprocessor interface and loads the response to rd.
+    A WFI holds the pipeline at this stage until the CSRs report an enabled
+    pending interrupt. The sub-module also manages pipeline stall and flush
+    signals for the Memory Access stage.
  - rv32i_writeback: This sub-module is responsible for writing the results of ALU 
     and load operations back to the register file. It also manages the program 
     counter for returning from traps and provides clock enable signals for the 
     Writeback stage.
+ - rv32i_icache: This optional sub-module (ICACHE_WAYS) caches the instructions
+    between the fetch stage and the instruction memory. Cache lines are refilled
+    by a burst of back-to-back requests and invalidated by FENCE.I.
+ - rv32i_dcache: This optional sub-module (DCACHE_WAYS) is a write-back, 
+    write-allocate data cache between the memory access stage and the data 
+    memory. Peripherals (address MSB is high) bypass the cache. Dirty lines
+    are written back to memory by FENCE.I.
  - rv32i_csr: This sub-module manages the Control and Status Registers (CSRs) in 
     the core. It handles traps and exceptions, updates CSR values, and controls 
-    the program counter for trap handling.
+    the program counter for trap handling. When CLIC is enabled, it also serves
+    as a CLIC-style interrupt controller which takes the pending interrupt with 
+    the highest level and lets higher-level interrupts preempt a running 
+    handler. It also implements HPM_COUNTERS 
+    hardware performance-monitoring counters (mhpmcounter3..) which count the 
+    pipeline event (stall, misprediction, memory wait, trap) selected by mhpmevent.
+ - Dual issue: When DUAL_ISSUE is enabled (C_EXTENSION must be disabled), the 
+    instruction memory is 64 bits wide and the fetch stage issues two instructions
+    at a time when the second one is a base ALU instruction which does not depend on
+    the first one. The second issue slot has its own decoder (m9) and ALU (m10) and
+    follows the first slot through the memory access and writeback stages, where both
+    rd are written to the base registers (two write ports) at the same clock cycle. 
+    The pair stalls and is flushed as one, so traps stay precise.
+ - Deeper pipeline: When DEEP_PIPELINE is enabled, the execute stage is split
+    into an operand stage (rv32i_operand, m11) which does the operand forwarding
+    and an ALU stage which computes and resolves branches, and the misprediction
+    of the ALU stage is registered before reaching the fetch stage. This shortens
+    the longest paths (forwarding to ALU to next PC) for a higher fmax at the cost
+    of 2 more clock cycles per misprediction and 1 more per load-use dependency.
+    EARLY_BRANCH and DUAL_ISSUE are not supported with the deeper pipeline.
+ - rv32i_threads: When THREADS > 1, the core runs 2 to 4 hardware threads, each with
+    its own registers (rv32i_basereg), CSRs (one rv32i_csr per thread, mhartid is
+    HART_ID + thread), PC, and interrupts, so each thread is a hart of its own. The
+    pipeline runs one thread at a time and this sub-module switches to the next ready
+    thread when a load waits THREAD_SWITCH_LATENCY clock cycles for a slow device (the
+    load is parked and writes its rd later), when a WFI waits for an interrupt, and
+    round-robin every THREAD_QUANTUM clock cycles. The switch flushes the pipeline like a trap and fetches the next thread.
 */
 
 `timescale 1ns / 1ps
 `default_nettype none
 `include "rv32i_header.vh"
 
-module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICSR_EXTENSION = 1) ( 
+module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICSR_EXTENSION = 1,
+                    M_EXTENSION = 0, //1 = enable multiply/divide instructions (RV32M), 0 = multiply/divide instructions are illegal
+                    ZB_EXTENSION = 0, //1 = enable Zba/Zbb bit-manipulation instructions, 0 = bit-manipulation instructions are illegal (less LUTs)
+                    C_EXTENSION = 0, //1 = enable compressed instructions (RV32C), 0 = instructions must be 4-byte aligned (less LUTs)
+                    A_EXTENSION = 0, //1 = enable atomic instructions (RV32A: LR/SC and AMOs), 0 = atomic instructions are illegal (less LUTs)
+                    COPROCESSOR = 0, //1 = custom-0/custom-1 instructions are sent to the coprocessor interface, 0 = custom instructions are illegal
+                    HART_ID = 0, //value of mhartid (every hart of a multi-hart system needs a distinct ID, one of them zero)
+                    MULTI_HART = 0, //1 = data bus is shared with other harts (i_snoop_we clears the LR reservation, SC reads before writing under the bus lock), 0 = single hart
+                    THREADS = 1, //number of hardware threads (1 to 4, each thread is a hart with mhartid HART_ID + thread)
+                    THREAD_SWITCH_LATENCY = 2, //clock cycles a load waits for its ack before switching thread (0 = never switch on loads)
+                    THREAD_QUANTUM = 256, //clock cycles a thread runs before switching thread round-robin (0 = never switch round-robin)
+                    CLIC = 0, //1 = enable CLIC interrupt mode (mtvec.mode = 3: per-interrupt level/enable/trigger, level threshold, preemption by higher level, vectored jump table), 0 = CLINT interrupt mode only
+                    CLIC_INTERRUPTS = 0, //number of local interrupts i_clic_interrupt (0 to 16, CLIC interrupt id 16 to 31)
+                    SHADOW_REGS = 0, //1 = trap handlers use a second (shadow) register bank switched on trap entry and mret (no register save/restore needed), 0 = single register bank
+                    HPM_COUNTERS = 0, //number of implemented hardware performance-monitoring counters mhpmcounter3.. (0 to 29, the rest read as zero)
+                    BRANCH_PREDICTOR = 0, //0 = none, 1 = static BTFN, 2 = BTB with 2-bit counters (static BTFN on BTB miss)
+                    BTB_INDEX_WIDTH = 6, //BTB has 2**BTB_INDEX_WIDTH entries (more entries = more LUTs but higher accuracy)
+                    RAS_DEPTH = 0, //number of entries of return address stack (power of 2, 0 = no RAS)
+                    RAS_OVERFLOW = 0, //0 = call overwrites oldest entry when RAS is full, 1 = call is not pushed when RAS is full
+                    RAS_FLUSH = 2, //0 = keep RAS on pipeline flush, 1 = clear RAS on pipeline flush, 2 = restore checkpoint of mispredicted instruction and clear on trap
+                    EARLY_BRANCH = 0, //1 = resolve JAL and branches (when operands are available) at decode stage, 0 = resolve at ALU stage only (better fmax)
+                    EARLY_TRAP = 0, //1 = ECALL, EBREAK, and illegal instructions fetch their trap handler from the ALU stage, 0 = trap handler is fetched after the flush of the writeback stage
+                    PREFETCH_DEPTH = 1, //number of fetched instructions that can be queued while the decode stage is stalled (at least 1)
+                    INST_MAX_REQUESTS = 1, //maximum number of outstanding instruction memory requests (>1 needs a memory that accepts a request every clock cycle, forced to 1 with instruction cache)
+                    DATA_MAX_REQUESTS = 1, //maximum number of outstanding data memory requests (pipelined wishbone, 1 = wait ack before next request)
+                    STORE_BUFFER_DEPTH = 0, //number of posted stores that can wait for the data memory without stalling the pipeline (0 = no store buffer)
+                    ICACHE_WAYS = 0, //0 = no instruction cache, 1 = direct-mapped instruction cache, 2 = 2-way set-associative instruction cache
+                    ICACHE_INDEX_WIDTH = 6, //instruction cache has 2**ICACHE_INDEX_WIDTH sets
+                    ICACHE_LINE_WORDS = 4, //number of 32-bit words per instruction cache line (burst length of refill)
+                    DCACHE_WAYS = 0, //0 = no data cache, 1 = direct-mapped data cache, 2 = 2-way set-associative data cache
+                    DCACHE_INDEX_WIDTH = 6, //data cache has 2**DCACHE_INDEX_WIDTH sets
+                    DCACHE_LINE_WORDS = 4, //number of 32-bit words per data cache line (burst length of refill and writeback)
+                    DUAL_ISSUE = 0, //1 = issue two instructions at a time (needs C_EXTENSION = 0 and DEEP_PIPELINE = 0, and a 64-bit instruction memory), 0 = single issue
+                    DEEP_PIPELINE = 0 //1 = 6-stage pipeline with separate operand forwarding and ALU stages and a registered misprediction (higher fmax), 0 = 5-stage pipeline
+                    ) ( 
     input wire i_clk, i_rst_n,
-    //Instruction Memory Interface (32 bit rom)
-    input wire[31:0] i_inst, //32-bit instruction
+    //Instruction Memory Interface (32 bit rom, 64 bit when DUAL_ISSUE)
+    input wire[(DUAL_ISSUE != 0 && C_EXTENSION == 0 && DEEP_PIPELINE == 0)? 63:31 : 0] i_inst, //32-bit instruction (64-bit doubleword at o_iaddr[31:3] when DUAL_ISSUE)
     output wire[31:0] o_iaddr, //address of instruction 
     output wire o_stb_inst, //request for read access to instruction memory
     input wire i_ack_inst, //ack (high if new instruction is ready)
@@ -62,35 +157,94 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
     input wire i_wb_ack_data, //ack by data memory (high when read data is ready or when write data is already written)
     input wire i_wb_stall_data, //stall by data memory 
     input wire[31:0] i_wb_data_data, //data retrieve from memory
-    //Interrupts
-    input wire i_external_interrupt, //interrupt from external source
-    input wire i_software_interrupt, //interrupt from software (inter-processor interrupt)
-    input wire i_timer_interrupt //interrupt from timer
+    input wire i_snoop_we, //write of another hart is accepted by the data memory (only used when MULTI_HART is enabled)
+    input wire[31:0] i_snoop_addr, //address of the write of another hart
+    //Interrupts (one per thread)
+    input wire[THREADS-1:0] i_external_interrupt, //interrupt from external source
+    input wire[THREADS-1:0] i_software_interrupt, //interrupt from software (inter-processor interrupt)
+    input wire[THREADS-1:0] i_timer_interrupt, //interrupt from timer
+    input wire[15:0] i_clic_interrupt, //local interrupts (CLIC interrupt id 16 to 31, only used when CLIC is enabled)
+    //Coprocessor Interface (custom-0/custom-1 instructions, only used when COPROCESSOR is enabled)
+    output wire o_cop_req_valid, //request to coprocessor (held until accepted)
+    input wire i_cop_req_ready, //coprocessor accepts the request
+    output wire o_cop_custom1, //opcode of custom instruction (0 = custom-0, 1 = custom-1)
+    output wire[2:0] o_cop_funct3, //funct3 of custom instruction
+    output wire[6:0] o_cop_funct7, //funct7 of custom instruction
+    output wire[31:0] o_cop_rs1, //rs1 value of custom instruction
+    output wire[31:0] o_cop_rs2, //rs2 value of custom instruction
+    input wire i_cop_rsp_valid, //response of coprocessor (any number of clock cycles after the request is accepted)
+    input wire[31:0] i_cop_rsp_data //value to be written to rd of custom instruction
 );
+    localparam DUAL = DUAL_ISSUE != 0 && C_EXTENSION == 0 && DEEP_PIPELINE == 0; //dual issue is only supported for 4-byte aligned instructions on the 5-stage pipeline
+    localparam DEEP = DEEP_PIPELINE != 0; //operand stage between decode and ALU stages
     
    
     //wires for basereg
-    wire[31:0] rs1_orig,rs2_orig;   
+    wire[31:0] rs1_orig,rs2_orig;
+    wire[31:0] rs1_early_orig,rs2_early_orig;   
     wire[31:0] rs1,rs2;  
     wire ce_read;
 
     //wires for rv32i_fetch
      wire[31:0] fetch_pc;
      wire[31:0] fetch_inst;
+     wire[31:0] fetch_inst1;
+     wire fetch_ce1;
+     wire fetch_compressed;
+     wire[31:0] fetch_iaddr;
+     wire fetch_stb_inst;
+     wire[DUAL? 63:31 : 0] icache_inst;
+     wire icache_ack_inst;
+     wire fetch_pred_taken;
+     wire[31:0] fetch_pred_pc;
+     wire fetch_ce;
+
+    //wires for rv32i_skid (fetch to decode stage)
+    wire[31:0] skid_pc;
+    wire[31:0] skid_inst;
+    wire[31:0] skid_inst1;
+    wire skid_ce1;
+    wire skid_compressed;
+    wire skid_pred_taken;
+    wire[31:0] skid_pred_pc;
 
     //wires for rv32i_decoder
     wire[`ALU_WIDTH-1:0] decoder_alu;
     wire[`OPCODE_WIDTH-1:0] decoder_opcode;
     wire[31:0] decoder_pc;
+    wire decoder_compressed;
     wire[4:0] decoder_rs1_addr, decoder_rs2_addr;
     wire[4:0] decoder_rs1_addr_q, decoder_rs2_addr_q;
     wire[4:0] decoder_rd_addr; 
     wire[31:0] decoder_imm; 
     wire[2:0] decoder_funct3;
     wire[`EXCEPTION_WIDTH-1:0] decoder_exception;
+    wire decoder_pred_taken;
+    wire[31:0] decoder_pred_pc;
+    wire[31:0] decoder_rs1, decoder_rs2;
+    wire decoder_rs_valid;
+    wire decoder_branch_resolved;
+    wire decoder_branch_taken;
+    wire[31:0] decoder_next_pc;
     wire decoder_ce;
     wire decoder_flush;
 
+    //wires for rv32i_operand (deeper pipeline)
+    wire[`ALU_WIDTH-1:0] operand_alu;
+    wire[`OPCODE_WIDTH-1:0] operand_opcode;
+    wire[31:0] operand_pc;
+    wire operand_compressed;
+    wire[4:0] operand_rs1_addr;
+    wire[4:0] operand_rd_addr;
+    wire[31:0] operand_imm;
+    wire[2:0] operand_funct3;
+    wire[`EXCEPTION_WIDTH-1:0] operand_exception;
+    wire operand_pred_taken;
+    wire[31:0] operand_pred_pc;
+    wire[31:0] operand_rs1, operand_rs2;
+    wire operand_ce;
+    wire operand_flush;
+
     //wires for rv32i_alu
     wire[`OPCODE_WIDTH-1:0] alu_opcode;
     wire[4:0] alu_rs1_addr;
@@ -100,8 +254,16 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
     wire[2:0] alu_funct3;
     wire[31:0] alu_y;
     wire[31:0] alu_pc;
+    wire alu_compressed;
     wire[31:0] alu_next_pc;
     wire alu_change_pc;
+    wire alu_change_pc_trap;
+    wire alu_trap_fetched;
+    wire alu_trap_address_valid;
+    wire alu_branch_resolved;
+    wire alu_branch_taken;
+    wire[31:0] alu_branch_target;
+    wire alu_done;
     wire alu_wr_rd;
     wire[4:0] alu_rd_addr;
     wire[31:0] alu_rd;
@@ -119,9 +281,17 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
     wire[4:0] memoryaccess_rd_addr;
     wire[31:0] memoryaccess_rd;
     wire[31:0] memoryaccess_data_load;
+    wire[31:0] memoryaccess_data_load_bypass;
+    wire memoryaccess_data_load_bypass_valid;
     wire memoryaccess_wr_mem;
     wire memoryaccess_ce;
     wire memoryaccess_flush;
+    wire memoryaccess_load_wait;
+    wire memoryaccess_park_wr_rd;
+    wire[4:0] memoryaccess_park_rd_addr;
+    wire[31:0] memoryaccess_park_rd;
+    wire memoryaccess_reserved;
+    wire memoryaccess_sleep;
     wire o_stall_from_alu;
     //wires for rv32i_writeback
     wire writeback_wr_rd; 
@@ -129,21 +299,72 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
     wire[31:0] writeback_rd;
     wire[31:0] writeback_next_pc;
     wire writeback_change_pc;
+    wire writeback_fence_i;
+    wire writeback_thread_switch;
+
+    //wires for second issue slot (dual issue)
+    wire[4:0] decoder_slot1_rs1_addr, decoder_slot1_rs2_addr;
+    wire[4:0] decoder_slot1_rd_addr;
+    wire[31:0] rs1_slot1_orig, rs2_slot1_orig;
+    wire alu_slot1_ce;
+    wire alu_slot1_force_stall;
+    wire alu_slot1_wr_rd;
+    wire[4:0] alu_slot1_rd_addr;
+    wire[31:0] alu_slot1_rd;
+    wire memoryaccess_slot1_ce_d;
+    wire memoryaccess_slot1_ce;
+    wire memoryaccess_slot1_wr_rd;
+    wire[4:0] memoryaccess_slot1_rd_addr;
+    wire[31:0] memoryaccess_slot1_rd;
+    wire writeback_slot1_wr_rd;
+
+    //wires for rv32i_dcache
+    wire memoryaccess_wb_cyc_data;
+    wire memoryaccess_wb_stb_data;
+    wire memoryaccess_wb_we_data;
+    wire[31:0] memoryaccess_wb_addr_data;
+    wire[31:0] memoryaccess_wb_data_data;
+    wire[3:0] memoryaccess_wb_sel_data;
+    wire dcache_wb_ack_data;
+    wire dcache_wb_stall_data;
+    wire[31:0] dcache_wb_data_data;
+    wire memoryaccess_dcache_clean;
+    wire dcache_clean_done;
     wire writeback_ce;
     wire writeback_flush;
 
     //wires for rv32i_csr
     wire[31:0] csr_out; //CSR value to be stored to basereg
+    wire[31:0] csr_data; //CSR value read at memory access stage (forwarded)
     wire[31:0] csr_return_address; //mepc CSR
     wire[31:0] csr_trap_address; //mtvec CSR
     wire csr_go_to_trap; //high before going to trap (if exception/interrupt detected)
+    wire csr_trap_fetched; //trap handler is already fetched by ALU stage
+    wire[31:0] csr_exception_address; //trap address of synchronous exceptions
     wire csr_return_from_trap; //high before returning from trap (via mret)
+    wire csr_bank; //register bank used by the core (1 = shadow registers)
+    wire csr_bank_switch; //high before switching the register bank by a CSR write
+    wire csr_wake; //an enabled interrupt is pending (ends WFI)
+
+    //wires for rv32i_threads
+    wire[1:0] thread; //thread running on the pipeline
+    wire thread_park; //park the load at memory access stage
+    wire[2:0] thread_park_bank; //{thread, bank} of the registers written by the parked load
+    wire thread_switch; //high before switching thread
+    wire thread_squash; //instruction at writeback stage is executed again (not retired)
+    wire[31:0] thread_next_pc; //PC where the next thread resumes
+    wire thread_wfi_switch; //switch thread at the WFI of memory access stage
     
-    wire stall_decoder,
+    wire stall_fetch,
+         stall_decoder,
+         stall_operand,
          stall_alu,
          stall_memoryaccess,
          stall_writeback; //control stall of each pipeline stages
     assign ce_read = decoder_ce && !stall_decoder; //reads basereg only decoder is not stalled 
+    //trap handler is fetched early unless a CSR instruction at memory access stage may still change mtvec (or an 
+    //instruction issued together at second issue slot must not execute)
+    assign alu_trap_address_valid = EARLY_TRAP != 0 && ZICSR_EXTENSION == 1 && !(memoryaccess_ce && alu_opcode[`SYSTEM] && alu_funct3 != 0) && !alu_slot1_ce;
 
     //module instantiations
     rv32i_forwarding operand_forwarding ( //logic for operand forwarding
@@ -159,16 +380,42 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         .i_alu_wr_rd(alu_wr_rd), //high if rd_addr will be written
         .i_alu_rd_valid(alu_rd_valid), //high if rd is already valid at this stage (not LOAD nor CSR instruction)
         .i_alu_rd(alu_rd), //rd value in stage 4
+        .i_alu_csr(alu_opcode[`SYSTEM] && alu_funct3 != 0), //high if instruction at stage 4 is a CSR instruction
+        .i_csr_data(csr_data), //CSR value read at stage 4
         .i_memoryaccess_ce(memoryaccess_ce), //high if stage 4 is enabled
+        .i_memoryaccess_data_load_bypass(memoryaccess_data_load_bypass), //load data in stage 4 that is still on the data bus
+        .i_memoryaccess_data_load_bypass_valid(memoryaccess_data_load_bypass_valid), //high if load data is acknowledged at this clock cycle
         // Stage 5 [WRITEBACK]
         .i_memoryaccess_rd_addr(memoryaccess_rd_addr), //destination register address
         .i_memoryaccess_wr_rd(memoryaccess_wr_rd), //high if rd_addr will be written
         .i_writeback_rd(writeback_rd), //rd value in stage 5
-        .i_writeback_ce(writeback_ce) //high if stage 4 is enabled
+        .i_writeback_ce(writeback_ce), //high if stage 4 is enabled
+        // Second issue slot (dual issue)
+        .i_alu_slot1_rd_addr(alu_slot1_rd_addr), //destination register address at stage 4
+        .i_alu_slot1_wr_rd(alu_slot1_wr_rd), //high if rd_addr at stage 4 will be written
+        .i_alu_slot1_rd(alu_slot1_rd), //rd value in stage 4
+        .i_memoryaccess_slot1_rd_addr(memoryaccess_slot1_rd_addr), //destination register address at stage 5
+        .i_memoryaccess_slot1_wr_rd(memoryaccess_slot1_wr_rd), //high if rd_addr at stage 5 will be written
+        .i_writeback_slot1_rd(memoryaccess_slot1_rd), //rd value in stage 5
+        .i_decoder_slot1_rd_addr(decoder_slot1_rd_addr), //destination register address at stage 3
+        .i_alu_slot1_ce(alu_slot1_ce), //high if second issue slot at stage 3 is enabled
+        // Stage 2 [DECODE]
+        .i_decoder_rs1_orig(rs1_early_orig), //current rs1 value saved in basereg (read at decode stage)
+        .i_decoder_rs2_orig(rs2_early_orig), //current rs2 value saved in basereg (read at decode stage)
+        .i_decoder_rs1_addr(decoder_rs1_addr), //address of operand rs1 used in decode stage
+        .i_decoder_rs2_addr(decoder_rs2_addr), //address of operand rs2 used in decode stage
+        .o_decoder_rs1(decoder_rs1), //rs1 value at decode stage with Operand Forwarding
+        .o_decoder_rs2(decoder_rs2), //rs2 value at decode stage with Operand Forwarding
+        .o_decoder_rs_valid(decoder_rs_valid), //high if both rs1 and rs2 at decode stage are already the most updated value
+        // Stage 3 [ALU]
+        .i_decoder_rd_addr(decoder_rd_addr), //destination register address
+        .i_alu_ce(alu_ce) //high if stage 3 is enabled
     );
 
-    rv32i_basereg m0( //regfile controller for the 32 integer base registers
+    rv32i_basereg #(.SHADOW_REGS(SHADOW_REGS), .THREADS(THREADS)) m0( //regfile controller for the 32 integer base registers
         .i_clk(i_clk),
+        .i_bank(csr_bank), //register bank used by both read and write (1 = shadow registers)
+        .i_thread(thread), //thread whose registers are used by both read and write
         .i_ce_read(ce_read), //clock enable for reading from basereg [STAGE 2]
         .i_rs1_addr(decoder_rs1_addr), //source register 1 address
         .i_rs2_addr(decoder_rs2_addr), //source register 2 address
@@ -176,35 +423,83 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         .i_rd(writeback_rd), //data to be written to destination register
         .i_wr(writeback_wr_rd), //write enable
         .o_rs1(rs1_orig), //source register 1 value
-        .o_rs2(rs2_orig) //source register 2 value
+        .o_rs2(rs2_orig), //source register 2 value
+        .o_rs1_early(rs1_early_orig), //source register 1 value read at decode stage
+        .o_rs2_early(rs2_early_orig), //source register 2 value read at decode stage
+        // Second issue slot (dual issue)
+        .i_slot1_rs1_addr(decoder_slot1_rs1_addr), //source register 1 address
+        .i_slot1_rs2_addr(decoder_slot1_rs2_addr), //source register 2 address
+        .i_slot1_rd_addr(memoryaccess_slot1_rd_addr), //destination register address
+        .i_slot1_rd(memoryaccess_slot1_rd), //data to be written to destination register
+        .i_slot1_wr(writeback_slot1_wr_rd), //write enable
+        .o_slot1_rs1(rs1_slot1_orig), //source register 1 value
+        .o_slot1_rs2(rs2_slot1_orig), //source register 2 value
+        // Parked load (multithreading)
+        .i_park_bank(thread_park_bank), //{thread, bank} of the registers written by the parked load
+        .i_park_rd_addr(memoryaccess_park_rd_addr), //destination register address
+        .i_park_rd(memoryaccess_park_rd), //data to be written to destination register
+        .i_park_wr(memoryaccess_park_wr_rd) //write enable
     );
     
-    rv32i_fetch #(.PC_RESET(PC_RESET)) m1( // logic for fetching instruction [FETCH STAGE , STAGE 1]
+    rv32i_fetch #(.PC_RESET(PC_RESET), .BRANCH_PREDICTOR(BRANCH_PREDICTOR), .BTB_INDEX_WIDTH(BTB_INDEX_WIDTH),
+                  .RAS_DEPTH(RAS_DEPTH), .RAS_OVERFLOW(RAS_OVERFLOW), .RAS_FLUSH(RAS_FLUSH),
+                  .PREFETCH_DEPTH(PREFETCH_DEPTH), .MAX_REQUESTS((ICACHE_WAYS != 0)? 1 : INST_MAX_REQUESTS), .C_EXTENSION(C_EXTENSION), .DUAL_ISSUE(DUAL)) m1( // logic for fetching instruction [FETCH STAGE , STAGE 1]
         .i_clk(i_clk),
         .i_rst_n(i_rst_n),
-        .o_iaddr(o_iaddr), //Instruction address
+        .o_iaddr(fetch_iaddr), //Instruction address
         .o_pc(fetch_pc), //PC value of o_inst
-        .i_inst(i_inst), // retrieved instruction from Memory
+        .i_inst(icache_inst), // retrieved instruction from Memory
         .o_inst(fetch_inst), // instruction
-        .o_stb_inst(o_stb_inst), // request for instruction
-        .i_ack_inst(i_ack_inst), //ack (high if new instruction is ready)
+        .o_compressed(fetch_compressed), //high if instruction is an expanded compressed instruction
+        .o_inst1(fetch_inst1), //instruction at PC+4 issued together with o_inst (dual issue)
+        .o_stb_inst(fetch_stb_inst), // request for instruction
+        .i_ack_inst(icache_ack_inst), //ack (high if new instruction is ready)
         // PC Control
         .i_writeback_change_pc(writeback_change_pc), //high when PC needs to change when going to trap or returning from trap
         .i_writeback_next_pc(writeback_next_pc), //next PC due to trap
-        .i_alu_change_pc(alu_change_pc), //high when PC needs to change for taken branches and jumps
+        .i_alu_change_pc(alu_change_pc), //high when PC needs to change for mispredicted branches and jumps
         .i_alu_next_pc(alu_next_pc), //next PC due to branch or jump
+        // Branch Prediction
+        .o_pred_taken(fetch_pred_taken), //high if instruction is predicted as a taken branch/jump
+        .o_pred_pc(fetch_pred_pc), //predicted target address
+        .i_alu_branch_resolved(alu_branch_resolved), //high when a branch/jump is resolved at ALU stage (update branch predictor)
+        .i_alu_branch_taken(alu_branch_taken), //high if the resolved branch/jump is taken
+        .i_alu_branch_target(alu_branch_target), //target address of the resolved branch/jump
+        .i_alu_pc(operand_pc), //PC of the resolved branch/jump
+        .i_alu_compressed(operand_compressed), //high if the resolved branch/jump is a compressed instruction
+        .i_alu_done(alu_done), //high when an instruction leaves the ALU stage
+        .i_decoder_branch_resolved(decoder_branch_resolved), //high if branch/jump is already resolved at decode stage
+        .i_decoder_branch_taken(decoder_branch_taken), //high if the branch/jump resolved at decode stage is taken
+        .i_decoder_next_pc(decoder_next_pc), //target address of the branch/jump resolved at decode stage
         /// Pipeline Control ///
-        .o_ce(decoder_ce), // output clk enable for pipeline stalling of next stage
-        .i_stall((stall_decoder || stall_alu || stall_memoryaccess || stall_writeback)), //informs this stage to stall
+        .o_ce(fetch_ce), // output clk enable for pipeline stalling of next stage
+        .o_ce1(fetch_ce1), //high if o_inst1 is issued together with o_inst
+        .i_stall(stall_fetch), //informs this stage to stall (registered)
         .i_flush(decoder_flush) //flush this stage
     ); 
+
+    rv32i_skid #(.WIDTH(32*4 + 3)) m12( //skid buffer between fetch and decode stages (stall reaches fetch stage one clock cycle later)
+        .i_clk(i_clk),
+        .i_rst_n(i_rst_n),
+        //Previous Stage Interface
+        .i_data({fetch_pc, fetch_inst, fetch_inst1, fetch_pred_pc, fetch_ce1, fetch_compressed, fetch_pred_taken}), //instruction from fetch stage
+        .i_ce(fetch_ce), //high if instruction from fetch stage is valid
+        .o_stall(stall_fetch), //stall fetch stage (skid buffer is full)
+        //Next Stage Interface
+        .o_data({skid_pc, skid_inst, skid_inst1, skid_pred_pc, skid_ce1, skid_compressed, skid_pred_taken}), //instruction to decode stage
+        .o_ce(decoder_ce), //clk enable of decode stage
+        .i_stall((stall_decoder || stall_operand || stall_alu || stall_memoryaccess || stall_writeback)), //decode stage is stalled
+        .i_flush(decoder_flush) //discard buffered instruction
+    );
   
-    rv32i_decoder m2( //logic for the decoding of the 32 bit instruction [DECODE STAGE , STAGE 2]
+    rv32i_decoder #(.EARLY_BRANCH(DEEP? 0 : EARLY_BRANCH), .M_EXTENSION(M_EXTENSION), .ZB_EXTENSION(ZB_EXTENSION), .A_EXTENSION(A_EXTENSION), .COPROCESSOR(COPROCESSOR)) m2( //logic for the decoding of the 32 bit instruction [DECODE STAGE , STAGE 2]
         .i_clk(i_clk),
         .i_rst_n(i_rst_n),
-        .i_inst(fetch_inst), //32 bit instruction
-        .i_pc(fetch_pc), //PC value from fetch stage
+        .i_inst(skid_inst), //32 bit instruction
+        .i_pc(skid_pc), //PC value from fetch stage
         .o_pc(decoder_pc), //PC value
+        .i_compressed(skid_compressed), //high if instruction is an expanded compressed instruction
+        .o_compressed(decoder_compressed), //high if instruction is an expanded compressed instruction
         .o_rs1_addr(decoder_rs1_addr),// address for register source 1
         .o_rs1_addr_q(decoder_rs1_addr_q), // registered address for register source 1
         .o_rs2_addr(decoder_rs2_addr), // address for register source 2
@@ -214,62 +509,154 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         .o_funct3(decoder_funct3), // function type
         .o_alu(decoder_alu), //alu operation type
         .o_opcode(decoder_opcode), //opcode type
-        .o_exception(decoder_exception), //exceptions: illegal inst, ecall, ebreak, mret
+        .o_exception(decoder_exception), //exceptions: illegal inst, ecall, ebreak, mret, wfi
+        /// Branch Prediction ///
+        .i_pred_taken(skid_pred_taken), //high if instruction is predicted as a taken branch/jump by fetch stage
+        .o_pred_taken(decoder_pred_taken), //high if instruction is predicted as a taken branch/jump
+        .i_pred_pc(skid_pred_pc), //predicted target address from fetch stage
+        .o_pred_pc(decoder_pred_pc), //predicted target address
+        /// Early Branch Resolution ///
+        .i_rs1(decoder_rs1), //rs1 value at decode stage (with operand forwarding)
+        .i_rs2(decoder_rs2), //rs2 value at decode stage (with operand forwarding)
+        .i_rs_valid(decoder_rs_valid), //high if rs1 and rs2 are already the most updated values
+        .o_branch_resolved(decoder_branch_resolved), //high if branch/jump is resolved at decode stage
+        .o_branch_taken(decoder_branch_taken), //high if the resolved branch/jump is taken
+        .o_next_pc(decoder_next_pc), //target address of branch/jump
          /// Pipeline Control ///
         .i_ce(decoder_ce), // input clk enable for pipeline stalling of this stage
         .o_ce(alu_ce), // output clk enable for pipeline stalling of next stage
-        .i_stall((stall_alu || stall_memoryaccess || stall_writeback)), //informs this stage to stall
+        .i_stall((stall_operand || stall_alu || stall_memoryaccess || stall_writeback)), //informs this stage to stall
         .o_stall(stall_decoder), //informs pipeline to stall
-        .i_flush(alu_flush), //flush this stage
+        .i_flush(operand_flush), //flush this stage
         .o_flush(decoder_flush) //flushes previous stages
     );
 
-    rv32i_alu m3( //ALU combinational logic [EXECUTE STAGE , STAGE 3]
+    if(DEEP) begin: deep //operand stage between decode and ALU stages (deeper pipeline)
+        rv32i_operand m11( //logic for operand forwarding of the deeper pipeline [OPERAND STAGE]
+            .i_clk(i_clk),
+            .i_rst_n(i_rst_n),
+            .i_alu(decoder_alu), //alu operation type from previous stage
+            .o_alu(operand_alu), //alu operation type
+            .i_opcode(decoder_opcode), //opcode type from previous stage
+            .o_opcode(operand_opcode), //opcode type
+            .i_pc(decoder_pc), //PC value from previous stage
+            .o_pc(operand_pc), //PC value
+            .i_compressed(decoder_compressed), //high if instruction is an expanded compressed instruction
+            .o_compressed(operand_compressed), //high if instruction is an expanded compressed instruction
+            .i_rs1_addr(decoder_rs1_addr_q), //address for register source 1 (from previous stage)
+            .o_rs1_addr(operand_rs1_addr), //address for register source 1
+            .i_rs2_addr(decoder_rs2_addr_q), //address for register source 2 (from previous stage)
+            .o_rs2_addr(),
+            .i_rd_addr(decoder_rd_addr), //address for destination register (from previous stage)
+            .o_rd_addr(operand_rd_addr), //address for destination register
+            .i_imm(decoder_imm), //immediate value from previous stage
+            .o_imm(operand_imm), //immediate value
+            .i_funct3(decoder_funct3), //function type from previous stage
+            .o_funct3(operand_funct3), //function type
+            .i_exception(decoder_exception), //exception from decoder stage
+            .o_exception(operand_exception), //exceptions: illegal inst, ecall, ebreak, mret, wfi
+            /// Branch Prediction ///
+            .i_pred_taken(decoder_pred_taken), //high if instruction is predicted as a taken branch/jump by fetch stage
+            .o_pred_taken(operand_pred_taken), //high if instruction is predicted as a taken branch/jump
+            .i_pred_pc(decoder_pred_pc), //predicted target address from fetch stage
+            .o_pred_pc(operand_pred_pc), //predicted target address
+            /// Operands ///
+            .i_rs1(rs1), //rs1 value with operand forwarding from memory-access and writeback stages
+            .i_rs2(rs2), //rs2 value with operand forwarding from memory-access and writeback stages
+            .i_alu_rd(alu_rd), //registered result of the ALU stage
+            .o_rs1(operand_rs1), //rs1 value for the ALU stage
+            .o_rs2(operand_rs2), //rs2 value for the ALU stage
+             /// Pipeline Control ///
+            .i_ce(alu_ce), // input clk enable for pipeline stalling of this stage
+            .o_ce(operand_ce), // output clk enable for pipeline stalling of next stage
+            .i_stall((stall_alu || stall_memoryaccess || stall_writeback)), //informs this stage to stall
+            .i_force_stall(alu_force_stall), //force this stage to stall
+            .o_stall(stall_operand), //informs pipeline to stall
+            .i_flush(alu_flush), //flush this stage
+            .o_flush(operand_flush) //flushes previous stages
+        );
+    end
+    else begin: deep //decode stage is followed by the ALU stage
+        assign operand_alu = decoder_alu;
+        assign operand_opcode = decoder_opcode;
+        assign operand_pc = decoder_pc;
+        assign operand_compressed = decoder_compressed;
+        assign operand_rs1_addr = decoder_rs1_addr_q;
+        assign operand_rd_addr = decoder_rd_addr;
+        assign operand_imm = decoder_imm;
+        assign operand_funct3 = decoder_funct3;
+        assign operand_exception = decoder_exception;
+        assign operand_pred_taken = decoder_pred_taken;
+        assign operand_pred_pc = decoder_pred_pc;
+        assign operand_rs1 = rs1;
+        assign operand_rs2 = rs2;
+        assign operand_ce = alu_ce;
+        assign stall_operand = 0;
+        assign operand_flush = alu_flush;
+    end
+
+    rv32i_alu #(.M_EXTENSION(M_EXTENSION), .ZB_EXTENSION(ZB_EXTENSION), .C_EXTENSION(C_EXTENSION), .REGISTER_REDIRECT(DEEP)) m3( //ALU combinational logic [EXECUTE STAGE , STAGE 3]
         .i_clk(i_clk),
         .i_rst_n(i_rst_n),
-        .i_alu(decoder_alu), //alu operation type
-        .i_rs1_addr(decoder_rs1_addr_q), //address for register source 1
+        .i_alu(operand_alu), //alu operation type
+        .i_rs1_addr(operand_rs1_addr), //address for register source 1
         .o_rs1_addr(alu_rs1_addr), //address for register source 1
-        .i_rs1(rs1), //Source register 1 value
+        .i_rs1(operand_rs1), //Source register 1 value
         .o_rs1(alu_rs1), //Source register 1 value
-        .i_rs2(rs2), //Source Register 2 value
+        .i_rs2(operand_rs2), //Source Register 2 value
         .o_rs2(alu_rs2), //Source Register 2 value
-        .i_imm(decoder_imm), //Immediate value from previous stage
+        .i_imm(operand_imm), //Immediate value from previous stage
         .o_imm(alu_imm), //Immediate value
-        .i_funct3(decoder_funct3), //function type from decoder stage
+        .i_funct3(operand_funct3), //function type from decoder stage
         .o_funct3(alu_funct3), //function type
-        .i_opcode(decoder_opcode), //opcode type from previous stage
+        .i_opcode(operand_opcode), //opcode type from previous stage
         .o_opcode(alu_opcode), //opcode type
-        .i_exception(decoder_exception), //exception from decoder stage
-        .o_exception(alu_exception), //exception: illegal inst,ecall,ebreak,mret
+        .i_exception(operand_exception), //exception from decoder stage
+        .o_exception(alu_exception), //exception: illegal inst,ecall,ebreak,mret,wfi
         .o_y(alu_y), //result of arithmetic operation
         // PC Control
-        .i_pc(decoder_pc), //pc from decoder stage
+        .i_pc(operand_pc), //pc from previous stage
+        .i_compressed(operand_compressed), //high if instruction is an expanded compressed instruction
         .o_pc(alu_pc), // current pc 
+        .o_compressed(alu_compressed), //high if instruction is an expanded compressed instruction
         .o_next_pc(alu_next_pc), //next pc 
         .o_change_pc(alu_change_pc), //change pc if high
+        .o_change_pc_trap(alu_change_pc_trap), //change pc fetches the trap handler
+        // Early Trap
+        .i_trap_address(csr_exception_address), //trap address of synchronous exceptions (mtvec)
+        .i_trap_address_valid(alu_trap_address_valid), //high if trap address is not changed by the instruction at memory access stage
+        .o_trap_fetched(alu_trap_fetched), //instruction at memory access stage already fetched its trap handler
+        // Branch Prediction
+        .i_pred_taken(operand_pred_taken), //high if instruction was predicted as a taken branch/jump by fetch stage
+        .i_pred_pc(operand_pred_pc), //predicted target address
+        .o_branch_resolved(alu_branch_resolved), //high when a branch/jump is resolved at this stage (update branch predictor)
+        .o_branch_taken(alu_branch_taken), //high if the resolved branch/jump is taken
+        .o_branch_target(alu_branch_target), //target address of the resolved branch/jump
         // Basereg Control
         .o_wr_rd(alu_wr_rd), //write rd to basereg if enabled
-        .i_rd_addr(decoder_rd_addr), //address for destination register (from previous stage)
+        .i_rd_addr(operand_rd_addr), //address for destination register (from previous stage)
         .o_rd_addr(alu_rd_addr), //address for destination register
         .o_rd(alu_rd), //value to be written back to destination register
         .o_rd_valid(alu_rd_valid), //high if o_rd is valid (not load nor csr instruction)
          /// Pipeline Control ///
         .o_stall_from_alu(o_stall_from_alu), //prepare to stall next stage(memory-access stage) for load/store instruction
-        .i_ce(alu_ce), // input clk enable for pipeline stalling of this stage
+        .i_ce(operand_ce), // input clk enable for pipeline stalling of this stage
         .o_ce(memoryaccess_ce), // output clk enable for pipeline stalling of next stage
+        .o_done(alu_done), //high when the instruction at this stage moves to the next stage
         .i_stall((stall_memoryaccess || stall_writeback)), //informs this stage to stall
-        .i_force_stall(alu_force_stall), //force this stage to stall
+        .i_force_stall(!DEEP && (alu_force_stall || alu_slot1_force_stall)), //force this stage to stall (operand stage is stalled instead on deeper pipeline)
         .o_stall(stall_alu), //informs pipeline to stall
         .i_flush(memoryaccess_flush), //flush this stage
         .o_flush(alu_flush) //flushes previous stages
     );
     
-    rv32i_memoryaccess m4( //logic controller for data memory access (load/store) [MEMORY STAGE , STAGE 4]
+    rv32i_memoryaccess #(.MAX_REQUESTS(DATA_MAX_REQUESTS), .STORE_BUFFER_DEPTH(STORE_BUFFER_DEPTH), .MULTI_HART(MULTI_HART)) m4( //logic controller for data memory access (load/store) [MEMORY STAGE , STAGE 4]
         .i_clk(i_clk),
         .i_rst_n(i_rst_n),
         .i_rs2(alu_rs2), //data to be stored to memory is always rs2
         .i_y(alu_y), //y value from ALU (address of data to memory be stored or loaded)
+        .i_amo_op(alu_imm[11:7]), //funct5 of atomic instruction (LR, SC, or AMO operation)
+        .i_cop_funct({alu_imm[0],alu_imm[11:5]}), //{custom-1, funct7} of custom instruction
         .i_funct3(alu_funct3), //funct3 from previous stage
         .o_funct3(memoryaccess_funct3), //funct3 (byte,halfword,word)
         .i_opcode(alu_opcode), //opcode type from previous stage
@@ -283,17 +670,52 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         .o_rd_addr(memoryaccess_rd_addr), //address for destination register
         .i_rd(alu_rd), //value to be written back to destination reg
         .o_rd(memoryaccess_rd), //value to be written back to destination register
+        .i_slot1_ce(memoryaccess_slot1_ce_d), //high if an instruction is issued together at second issue slot (from previous stage)
+        .o_slot1_ce(memoryaccess_slot1_ce), //high if an instruction is issued together at second issue slot
+        .i_slot1_wr_rd(alu_slot1_wr_rd), //write rd of second issue slot to base reg is enabled (from previous stage)
+        .o_slot1_wr_rd(memoryaccess_slot1_wr_rd), //write rd of second issue slot to the base reg if enabled
+        .i_slot1_rd_addr(alu_slot1_rd_addr), //address for destination register of second issue slot (from previous stage)
+        .o_slot1_rd_addr(memoryaccess_slot1_rd_addr), //address for destination register of second issue slot
+        .i_slot1_rd(alu_slot1_rd), //value to be written back to destination reg of second issue slot
+        .o_slot1_rd(memoryaccess_slot1_rd), //value to be written back to destination register of second issue slot
         // Data Memory Control
-        .o_wb_cyc_data(o_wb_cyc_data), //bus cycle active (1 = normal operation, 0 = all ongoing transaction are to be cancelled)
-        .o_wb_stb_data(o_wb_stb_data), //request for read/write access to data memory
-        .o_wb_we_data(o_wb_we_data),  //write-enable (1 = write, 0 = read)
-        .o_wb_addr_data(o_wb_addr_data), //data memory address
-        .o_wb_data_data(o_wb_data_data), //data to be stored to memory (mask-aligned)
-        .o_wb_sel_data(o_wb_sel_data), //byte strobe for write (1 = write the byte) {byte3,byte2,byte1,byte0}
-        .i_wb_ack_data(i_wb_ack_data), //ack by data memory (high when read data is ready or when write data is already written
-        .i_wb_stall_data(i_wb_stall_data), //stall by data memory (1 = data memory is busy)
-        .i_wb_data_data(i_wb_data_data), //data retrieve from data memory 
+        .o_wb_cyc_data(memoryaccess_wb_cyc_data), //bus cycle active (1 = normal operation, 0 = all ongoing transaction are to be cancelled)
+        .o_wb_stb_data(memoryaccess_wb_stb_data), //request for read/write access to data memory
+        .o_wb_we_data(memoryaccess_wb_we_data),  //write-enable (1 = write, 0 = read)
+        .o_wb_addr_data(memoryaccess_wb_addr_data), //data memory address
+        .o_wb_data_data(memoryaccess_wb_data_data), //data to be stored to memory (mask-aligned)
+        .o_wb_sel_data(memoryaccess_wb_sel_data), //byte strobe for write (1 = write the byte) {byte3,byte2,byte1,byte0}
+        .i_wb_ack_data(dcache_wb_ack_data), //ack by data memory (high when read data is ready or when write data is already written
+        .i_wb_stall_data(dcache_wb_stall_data), //stall by data memory (1 = data memory is busy)
+        .i_wb_data_data(dcache_wb_data_data), //data retrieve from data memory 
         .o_data_load(memoryaccess_data_load), //data to be loaded to base reg (z-or-s extended) 
+        .o_data_load_bypass(memoryaccess_data_load_bypass), //data to be loaded to base reg while still on the bus (load-to-use bypass)
+        .o_data_load_bypass_valid(memoryaccess_data_load_bypass_valid), //high if load data is acknowledged at this clock cycle
+        .o_dcache_clean(memoryaccess_dcache_clean), //request data cache to write back all dirty lines (FENCE.I)
+        .i_dcache_clean_done(dcache_clean_done), //all dirty lines of data cache are already written back
+        .i_snoop_we(i_snoop_we), //write of another hart is accepted by the data memory
+        .i_snoop_addr(i_snoop_addr), //address of the write of another hart
+        // Parked Load (multithreading)
+        .o_load_wait(memoryaccess_load_wait), //load at this stage is waiting for its ack
+        .i_park(thread_park), //park the load at this stage
+        .o_park_wr_rd(memoryaccess_park_wr_rd), //data of the parked load is acknowledged
+        .o_park_rd_addr(memoryaccess_park_rd_addr), //address for destination register of the parked load
+        .o_park_rd(memoryaccess_park_rd), //data of the parked load
+        .o_reserved(memoryaccess_reserved), //reservation set by LR is valid
+        // Coprocessor Interface
+        .o_cop_req_valid(o_cop_req_valid), //request to coprocessor (held until accepted)
+        .i_cop_req_ready(i_cop_req_ready), //coprocessor accepts the request
+        .o_cop_custom1(o_cop_custom1), //opcode of custom instruction (0 = custom-0, 1 = custom-1)
+        .o_cop_funct3(o_cop_funct3), //funct3 of custom instruction
+        .o_cop_funct7(o_cop_funct7), //funct7 of custom instruction
+        .o_cop_rs1(o_cop_rs1), //rs1 value of custom instruction
+        .o_cop_rs2(o_cop_rs2), //rs2 value of custom instruction
+        .i_cop_rsp_valid(i_cop_rsp_valid), //response of coprocessor (i_cop_rsp_data is valid)
+        .i_cop_rsp_data(i_cop_rsp_data), //value to be loaded to rd of custom instruction
+        // Wait For Interrupt
+        .i_wfi(alu_exception[`WFI]), //instruction at this stage is WFI
+        .i_wake(csr_wake || thread_wfi_switch), //an enabled interrupt is pending or the thread switches at the WFI
+        .o_sleep(memoryaccess_sleep), //WFI at this stage waits for an interrupt
          /// Pipeline Control ///   
         .i_stall_from_alu(o_stall_from_alu), //stalls this stage when incoming instruction is a load/store
         .i_ce(memoryaccess_ce), // input clk enable for pipeline stalling of this stage
@@ -310,6 +732,7 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         .i_csr_out(csr_out), //CSR value to be loaded to basereg
         .i_opcode_load(memoryaccess_opcode[`LOAD]),
         .i_opcode_system(memoryaccess_opcode[`SYSTEM]), 
+        .i_opcode_fence(memoryaccess_opcode[`FENCE]),
         // Basereg Control
         .i_wr_rd(memoryaccess_wr_rd), //write rd to base reg is enabled (from memoryaccess stage)
         .o_wr_rd(writeback_wr_rd), //write rd to the base reg if enabled
@@ -317,15 +740,24 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         .o_rd_addr(writeback_rd_addr), //address for destination register
         .i_rd(memoryaccess_rd), //value to be written back to destination reg
         .o_rd(writeback_rd), //value to be written back to destination register
+        .i_slot1_wr_rd(memoryaccess_slot1_wr_rd), //write rd of second issue slot to base reg is enabled (from memoryaccess stage)
+        .o_slot1_wr_rd(writeback_slot1_wr_rd), //write rd of second issue slot to the base reg if enabled
         // PC Control
         .i_pc(memoryaccess_pc), //pc value
         .o_next_pc(writeback_next_pc), //new PC value
         .o_change_pc(writeback_change_pc), //high if PC needs to jump
+        .o_fence_i(writeback_fence_i), //high if FENCE.I is executed (invalidate instruction cache)
         // Trap-Handler
         .i_go_to_trap(csr_go_to_trap), //high before going to trap (if exception/interrupt detected)
+        .i_trap_fetched(csr_trap_fetched), //trap handler is already fetched by ALU stage (pipeline is not flushed)
         .i_return_from_trap(csr_return_from_trap), //high before returning from trap (via mret)
+        .i_bank_switch(csr_bank_switch), //high before switching the register bank by a CSR write (fetch again the next instructions)
         .i_return_address(csr_return_address), //mepc CSR
         .i_trap_address(csr_trap_address), //mtvec CSR
+        // Multithreading
+        .i_thread_switch(thread_switch), //high before switching to the next thread
+        .i_thread_pc(thread_next_pc), //PC where the next thread resumes
+        .o_thread_switch(writeback_thread_switch), //high if the thread switch is done
         /// Pipeline Control ///
         .i_ce(writeback_ce), // input clk enable for pipeline stalling of this stage
         .o_stall(stall_writeback), //informs pipeline to stall
@@ -333,19 +765,320 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
     );
     
     // removable extensions
+    if(DUAL) begin: dual //second issue slot (instruction at PC+4 issued together with the instruction at decode stage)
+        wire[`ALU_WIDTH-1:0] decoder_slot1_alu;
+        wire[`OPCODE_WIDTH-1:0] decoder_slot1_opcode;
+        wire[31:0] decoder_slot1_pc;
+        wire[4:0] decoder_slot1_rs1_addr_q, decoder_slot1_rs2_addr_q;
+        wire[31:0] decoder_slot1_imm;
+        wire[2:0] decoder_slot1_funct3;
+        wire[`EXCEPTION_WIDTH-1:0] decoder_slot1_exception;
+        wire[31:0] rs1_slot1, rs2_slot1;
+        wire slot1_force_stall;
+        wire alu_slot1_wr_rd_q;
+
+        assign alu_slot1_force_stall = slot1_force_stall && alu_slot1_ce;
+        assign alu_slot1_wr_rd = alu_slot1_wr_rd_q && memoryaccess_slot1_ce_d;
+
+        rv32i_forwarding slot1_forwarding ( //logic for operand forwarding of second issue slot
+            .i_rs1_orig(rs1_slot1_orig), //current rs1 value saved in basereg
+            .i_rs2_orig(rs2_slot1_orig), //current rs2 value saved in basereg
+            .i_decoder_rs1_addr_q(decoder_slot1_rs1_addr_q), //address of operand rs1 used in ALU stage
+            .i_decoder_rs2_addr_q(decoder_slot1_rs2_addr_q), //address of operand rs2 used in ALU stage
+            .o_alu_force_stall(slot1_force_stall), //high to force ALU stage to stall
+            .o_rs1(rs1_slot1), //rs1 value with Operand Forwarding
+            .o_rs2(rs2_slot1), //rs2 value with Operand Forwarding
+            // Stage 4 [MEMORYACCESS]
+            .i_alu_rd_addr(alu_rd_addr), //destination register address
+            .i_alu_wr_rd(alu_wr_rd), //high if rd_addr will be written
+            .i_alu_rd_valid(alu_rd_valid), //high if rd is already valid at this stage (not LOAD nor CSR instruction)
+            .i_alu_rd(alu_rd), //rd value in stage 4
+            .i_alu_csr(alu_opcode[`SYSTEM] && alu_funct3 != 0), //high if instruction at stage 4 is a CSR instruction
+            .i_csr_data(csr_data), //CSR value read at stage 4
+            .i_memoryaccess_ce(memoryaccess_ce), //high if stage 4 is enabled
+            .i_memoryaccess_data_load_bypass(memoryaccess_data_load_bypass), //load data in stage 4 that is still on the data bus
+            .i_memoryaccess_data_load_bypass_valid(memoryaccess_data_load_bypass_valid), //high if load data is acknowledged at this clock cycle
+            // Stage 5 [WRITEBACK]
+            .i_memoryaccess_rd_addr(memoryaccess_rd_addr), //destination register address
+            .i_memoryaccess_wr_rd(memoryaccess_wr_rd), //high if rd_addr will be written
+            .i_writeback_rd(writeback_rd), //rd value in stage 5
+            .i_writeback_ce(writeback_ce), //high if stage 4 is enabled
+            // Second issue slot (dual issue)
+            .i_alu_slot1_rd_addr(alu_slot1_rd_addr), //destination register address at stage 4
+            .i_alu_slot1_wr_rd(alu_slot1_wr_rd), //high if rd_addr at stage 4 will be written
+            .i_alu_slot1_rd(alu_slot1_rd), //rd value in stage 4
+            .i_memoryaccess_slot1_rd_addr(memoryaccess_slot1_rd_addr), //destination register address at stage 5
+            .i_memoryaccess_slot1_wr_rd(memoryaccess_slot1_wr_rd), //high if rd_addr at stage 5 will be written
+            .i_writeback_slot1_rd(memoryaccess_slot1_rd), //rd value in stage 5
+            .i_decoder_slot1_rd_addr(5'd0), //not used (no early branch resolution for second issue slot)
+            .i_alu_slot1_ce(1'b0), 
+            // Stage 2 [DECODE]
+            .i_decoder_rs1_orig(32'd0), //not used (no early branch resolution for second issue slot)
+            .i_decoder_rs2_orig(32'd0),
+            .i_decoder_rs1_addr(5'd0),
+            .i_decoder_rs2_addr(5'd0),
+            .o_decoder_rs1(),
+            .o_decoder_rs2(),
+            .o_decoder_rs_valid(),
+            // Stage 3 [ALU]
+            .i_decoder_rd_addr(5'd0),
+            .i_alu_ce(1'b0)
+        );
+
+        rv32i_decoder #(.EARLY_BRANCH(0), .M_EXTENSION(0), .ZB_EXTENSION(0), .A_EXTENSION(0)) m9( //decoder of second issue slot [DECODE STAGE , STAGE 2]
+            .i_clk(i_clk),
+            .i_rst_n(i_rst_n),
+            .i_inst(skid_inst1), //32 bit instruction
+            .i_pc(skid_pc + 32'd4), //PC value from fetch stage
+            .o_pc(decoder_slot1_pc), //PC value
+            .i_compressed(1'b0), //high if instruction is an expanded compressed instruction
+            .o_compressed(),
+            .o_rs1_addr(decoder_slot1_rs1_addr),// address for register source 1
+            .o_rs1_addr_q(decoder_slot1_rs1_addr_q), // registered address for register source 1
+            .o_rs2_addr(decoder_slot1_rs2_addr), // address for register source 2
+            .o_rs2_addr_q(decoder_slot1_rs2_addr_q), // registered address for register source 2
+            .o_rd_addr(decoder_slot1_rd_addr), // address for destination register
+            .o_imm(decoder_slot1_imm), // extended value for immediate
+            .o_funct3(decoder_slot1_funct3), // function type
+            .o_alu(decoder_slot1_alu), //alu operation type
+            .o_opcode(decoder_slot1_opcode), //opcode type
+            .o_exception(decoder_slot1_exception), //exceptions: illegal inst, ecall, ebreak, mret, wfi
+            /// Branch Prediction ///
+            .i_pred_taken(1'b0), //second issue slot is never predicted as a taken branch/jump
+            .o_pred_taken(),
+            .i_pred_pc(32'd0),
+            .o_pred_pc(),
+            /// Early Branch Resolution ///
+            .i_rs1(32'd0),
+            .i_rs2(32'd0),
+            .i_rs_valid(1'b0),
+            .o_branch_resolved(),
+            .o_branch_taken(),
+            .o_next_pc(),
+             /// Pipeline Control ///
+            .i_ce(skid_ce1), // input clk enable for pipeline stalling of this stage
+            .o_ce(alu_slot1_ce), // output clk enable for pipeline stalling of next stage
+            .i_stall((stall_alu || stall_memoryaccess || stall_writeback)), //informs this stage to stall
+            .o_stall(), //never stalls by itself
+            .i_flush(alu_flush), //flush this stage
+            .o_flush()
+        );
+
+        rv32i_alu #(.M_EXTENSION(0), .ZB_EXTENSION(0), .C_EXTENSION(0)) m10( //ALU of second issue slot [EXECUTE STAGE , STAGE 3]
+            .i_clk(i_clk),
+            .i_rst_n(i_rst_n),
+            .i_alu(decoder_slot1_alu), //alu operation type
+            .i_rs1_addr(decoder_slot1_rs1_addr_q), //address for register source 1
+            .o_rs1_addr(),
+            .i_rs1(rs1_slot1), //Source register 1 value
+            .o_rs1(),
+            .i_rs2(rs2_slot1), //Source Register 2 value
+            .o_rs2(),
+            .i_imm(decoder_slot1_imm), //Immediate value from previous stage
+            .o_imm(),
+            .i_funct3(decoder_slot1_funct3), //function type from decoder stage
+            .o_funct3(),
+            .i_opcode(decoder_slot1_opcode), //opcode type from previous stage
+            .o_opcode(),
+            .i_exception(decoder_slot1_exception), //exception from decoder stage
+            .o_exception(),
+            .o_y(),
+            // PC Control
+            .i_pc(decoder_slot1_pc), //pc from decoder stage
+            .i_compressed(1'b0), //high if instruction is an expanded compressed instruction
+            .o_pc(),
+            .o_compressed(),
+            .o_next_pc(),
+            .o_change_pc(), //second issue slot never changes the PC
+            .o_change_pc_trap(),
+            // Early Trap
+            .i_trap_address(32'd0),
+            .i_trap_address_valid(1'b0), //second issue slot is always an ALU instruction
+            .o_trap_fetched(),
+            // Branch Prediction
+            .i_pred_taken(1'b0),
+            .i_pred_pc(32'd0),
+            .o_branch_resolved(),
+            .o_branch_taken(),
+            .o_branch_target(),
+            // Basereg Control
+            .o_wr_rd(alu_slot1_wr_rd_q), //write rd to basereg if enabled
+            .i_rd_addr(decoder_slot1_rd_addr), //address for destination register (from previous stage)
+            .o_rd_addr(alu_slot1_rd_addr), //address for destination register
+            .o_rd(alu_slot1_rd), //value to be written back to destination register
+            .o_rd_valid(), //always valid (ALU instruction)
+             /// Pipeline Control ///
+            .o_stall_from_alu(),
+            .i_ce(alu_slot1_ce), // input clk enable for pipeline stalling of this stage
+            .o_ce(memoryaccess_slot1_ce_d), // output clk enable for pipeline stalling of next stage
+            .o_done(),
+            .i_stall(stall_alu), //stalls together with the first issue slot
+            .i_force_stall(1'b0),
+            .o_stall(),
+            .i_flush(memoryaccess_flush), //flush this stage
+            .o_flush()
+        );
+    end
+    else begin: dual
+        assign decoder_slot1_rs1_addr = 0;
+        assign decoder_slot1_rs2_addr = 0;
+        assign decoder_slot1_rd_addr = 0;
+        assign alu_slot1_ce = 0;
+        assign alu_slot1_force_stall = 0;
+        assign alu_slot1_wr_rd = 0;
+        assign alu_slot1_rd_addr = 0;
+        assign alu_slot1_rd = 0;
+        assign memoryaccess_slot1_ce_d = 0;
+    end
+
+    if(ICACHE_WAYS != 0) begin: icache
+        rv32i_icache #(.WAYS(ICACHE_WAYS), .INDEX_WIDTH(ICACHE_INDEX_WIDTH), .LINE_WORDS(ICACHE_LINE_WORDS), .FETCH_WORDS(DUAL? 2 : 1)) m7( //instruction cache between fetch stage and instruction memory
+            .i_clk(i_clk),
+            .i_rst_n(i_rst_n),
+            //Fetch Stage Interface
+            .i_iaddr(fetch_iaddr), //address of instruction from fetch stage
+            .i_stb_inst(fetch_stb_inst), //request for instruction from fetch stage
+            .o_ack_inst(icache_ack_inst), //ack (high if instruction is ready)
+            .o_inst(icache_inst), //retrieved instruction
+            //Instruction Memory Interface (burst refill)
+            .o_iaddr_mem(o_iaddr), //address of instruction memory
+            .o_stb_inst_mem(o_stb_inst), //request for read access to instruction memory
+            .i_ack_inst_mem(i_ack_inst), //ack by instruction memory
+            .i_inst_mem(i_inst), //instruction retrieved from instruction memory
+            // Cache Control
+            .i_invalidate(writeback_fence_i) //invalidate all cache lines (FENCE.I)
+        );
+    end
+    else begin: icache
+        assign o_iaddr = fetch_iaddr;
+        assign o_stb_inst = fetch_stb_inst;
+        assign icache_ack_inst = i_ack_inst;
+        assign icache_inst = i_inst;
+    end
+
+    if(DCACHE_WAYS != 0) begin: dcache
+        rv32i_dcache #(.WAYS(DCACHE_WAYS), .INDEX_WIDTH(DCACHE_INDEX_WIDTH), .LINE_WORDS(DCACHE_LINE_WORDS)) m8( //data cache between memory access stage and data memory
+            .i_clk(i_clk),
+            .i_rst_n(i_rst_n),
+            //Memory Access Stage Interface
+            .i_wb_cyc(memoryaccess_wb_cyc_data), //bus cycle active
+            .i_wb_stb(memoryaccess_wb_stb_data), //request for read/write access
+            .i_wb_we(memoryaccess_wb_we_data), //write-enable (1 = write, 0 = read)
+            .i_wb_addr(memoryaccess_wb_addr_data), //data address
+            .i_wb_data(memoryaccess_wb_data_data), //data to be stored
+            .i_wb_sel(memoryaccess_wb_sel_data), //byte strobe for write
+            .o_wb_ack(dcache_wb_ack_data), //ack (high when read data is ready or when write data is already written)
+            .o_wb_stall(dcache_wb_stall_data), //stall (1 = cache is busy)
+            .o_wb_data(dcache_wb_data_data), //data retrieved
+            //Data Memory Interface (burst refill and writeback)
+            .o_wb_cyc_mem(o_wb_cyc_data), //bus cycle active
+            .o_wb_stb_mem(o_wb_stb_data), //request for read/write access to data memory
+            .o_wb_we_mem(o_wb_we_data), //write-enable (1 = write, 0 = read)
+            .o_wb_addr_mem(o_wb_addr_data), //data memory address
+            .o_wb_data_mem(o_wb_data_data), //data to be stored to memory
+            .o_wb_sel_mem(o_wb_sel_data), //byte strobe for write
+            .i_wb_ack_mem(i_wb_ack_data), //ack by data memory
+            .i_wb_stall_mem(i_wb_stall_data), //stall by data memory
+            .i_wb_data_mem(i_wb_data_data), //data retrieved from data memory
+            // Cache Control
+            .i_clean(memoryaccess_dcache_clean), //write back all dirty lines (FENCE.I)
+            .o_clean_done(dcache_clean_done), //all dirty lines are already written back
+            .i_invalidate(1'b0) //invalidate all lines (hook for dropping stale lines e.g. after DMA, not used by the core)
+        );
+    end
+    else begin: dcache
+        assign o_wb_cyc_data = memoryaccess_wb_cyc_data;
+        assign o_wb_stb_data = memoryaccess_wb_stb_data;
+        assign o_wb_we_data = memoryaccess_wb_we_data;
+        assign o_wb_addr_data = memoryaccess_wb_addr_data;
+        assign o_wb_data_data = memoryaccess_wb_data_data;
+        assign o_wb_sel_data = memoryaccess_wb_sel_data;
+        assign dcache_wb_ack_data = i_wb_ack_data;
+        assign dcache_wb_stall_data = i_wb_stall_data;
+        assign dcache_wb_data_data = i_wb_data_data;
+        assign dcache_clean_done = 1'b1; //no dirty lines to write back
+    end
+
+    if(THREADS > 1) begin: threads
+        rv32i_threads #(.PC_RESET(PC_RESET), .THREADS(THREADS), .SWITCH_LATENCY(THREAD_SWITCH_LATENCY), .QUANTUM(THREAD_QUANTUM), .C_EXTENSION(C_EXTENSION)) m13( //thread scheduler (switch-on-event multithreading)
+            .i_clk(i_clk),
+            .i_rst_n(i_rst_n),
+            .o_thread(thread), //thread running on the pipeline
+            // Stage 4 [MEMORYACCESS]
+            .i_opcode(alu_opcode), //opcode type of instruction at memory access stage
+            .i_exception(alu_exception != 0), //high if instruction at memory access stage has an exception from decoder
+            .i_pc(alu_pc), //PC of instruction at memory access stage
+            .i_compressed(alu_compressed), //high if instruction at memory access stage is an expanded compressed instruction
+            .i_load_wait(memoryaccess_load_wait), //load at memory access stage is waiting for its ack
+            .i_reserved(memoryaccess_reserved), //reservation set by LR is valid
+            .i_wfi(alu_exception[`WFI] && !csr_wake), //WFI at memory access stage waits for an interrupt
+            .o_wfi_switch(thread_wfi_switch), //switch thread at the WFI
+            .o_park(thread_park), //park the load at memory access stage
+            .i_bank(csr_bank), //register bank used by the running thread
+            .o_park_bank(thread_park_bank), //{thread, bank} of the registers written by the parked load
+            .i_park_done(memoryaccess_park_wr_rd), //data of the parked load is written to the base reg
+            // Stage 5 [WRITEBACK]
+            .o_switch_q(thread_switch), //high before switching thread
+            .o_squash_q(thread_squash), //instruction at writeback stage is executed again (not retired)
+            .o_next_pc(thread_next_pc), //PC where the next thread resumes
+            .i_switch(writeback_thread_switch), //thread switch is done by writeback stage
+            .i_writeback_change_pc(writeback_change_pc), //high if writeback will issue change_pc (which will override this stage)
+            /// Pipeline Control ///
+            .i_ce(memoryaccess_ce), // input clk enable for pipeline stalling of memory access stage
+            .i_stall((stall_writeback || stall_memoryaccess)) //informs this stage to stall
+        );
+    end
+    else begin: threads
+        assign thread = 0;
+        assign thread_park = 0;
+        assign thread_park_bank = 0;
+        assign thread_switch = 0;
+        assign thread_squash = 0;
+        assign thread_next_pc = 0;
+        assign thread_wfi_switch = 0;
+    end
+
     if(ZICSR_EXTENSION == 1) begin: zicsr
-        rv32i_csr #(.TRAP_ADDRESS(TRAP_ADDRESS)) m6( // control logic for Control and Status Registers (CSR) [STAGE 4]
+        //each thread has its own CSRs (the CSRs of the running thread are used by the pipeline)
+        wire[31:0] thread_csr_out[THREADS-1:0];
+        wire[31:0] thread_csr_data[THREADS-1:0];
+        wire[31:0] thread_csr_return_address[THREADS-1:0];
+        wire[31:0] thread_csr_trap_address[THREADS-1:0];
+        wire[THREADS-1:0] thread_csr_go_to_trap;
+        wire[THREADS-1:0] thread_csr_trap_fetched;
+        wire[31:0] thread_csr_exception_address[THREADS-1:0];
+        wire[THREADS-1:0] thread_csr_return_from_trap;
+        wire[THREADS-1:0] thread_csr_bank;
+        wire[THREADS-1:0] thread_csr_bank_switch;
+        wire[THREADS-1:0] thread_csr_wake;
+        genvar t;
+        assign csr_out = thread_csr_out[thread];
+        assign csr_data = thread_csr_data[thread];
+        assign csr_return_address = thread_csr_return_address[thread];
+        assign csr_trap_address = thread_csr_trap_address[thread];
+        assign csr_go_to_trap = thread_csr_go_to_trap[thread];
+        assign csr_trap_fetched = thread_csr_trap_fetched[thread];
+        assign csr_exception_address = thread_csr_exception_address[thread];
+        assign csr_return_from_trap = thread_csr_return_from_trap[thread];
+        assign csr_bank = thread_csr_bank[thread];
+        assign csr_bank_switch = thread_csr_bank_switch[thread];
+        assign csr_wake = thread_csr_wake[thread];
+
+        rv32i_csr #(.TRAP_ADDRESS(TRAP_ADDRESS), .M_EXTENSION(M_EXTENSION), .C_EXTENSION(C_EXTENSION), .A_EXTENSION(A_EXTENSION), .HPM_COUNTERS(HPM_COUNTERS), .SHADOW_REGS(SHADOW_REGS),
+                   .CLIC(CLIC), .CLIC_INTERRUPTS(CLIC_INTERRUPTS), .COPROCESSOR(COPROCESSOR), .HART_ID(HART_ID)) m6( // control logic for Control and Status Registers (CSR) [STAGE 4]
             .i_clk(i_clk),
             .i_rst_n(i_rst_n),
             // Interrupts
-            .i_external_interrupt(i_external_interrupt), //interrupt from external source
-            .i_software_interrupt(i_software_interrupt), //interrupt from software (inter-processor interrupt)
-            .i_timer_interrupt(i_timer_interrupt), //interrupt from timer
+            .i_external_interrupt(i_external_interrupt[0]), //interrupt from external source
+            .i_software_interrupt(i_software_interrupt[0]), //interrupt from software (inter-processor interrupt)
+            .i_timer_interrupt(i_timer_interrupt[0]), //interrupt from timer
+            .i_clic_interrupt(i_clic_interrupt), //local interrupts (CLIC interrupt id 16 to 31)
             /// Exceptions ///
             .i_is_inst_illegal(alu_exception[`ILLEGAL]), //illegal instruction
             .i_is_ecall(alu_exception[`ECALL]), //ecall instruction
             .i_is_ebreak(alu_exception[`EBREAK]), //ebreak instruction
             .i_is_mret(alu_exception[`MRET]), //mret (return from trap) instruction
+            .i_is_wfi(alu_exception[`WFI]), //wfi (wait for interrupt) instruction
             /// Load/Store Misaligned Exception///
             .i_opcode(alu_opcode), //opcode type from alu stage
             .i_y(alu_y), //y value from ALU (address used in load/store/jump/branch)
@@ -354,26 +1087,96 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
             .i_csr_index(alu_imm), //immediate value decoded by decoder
             .i_imm({27'b0,alu_rs1_addr}), //unsigned immediate for immediate type of CSR instruction (new value to be stored to CSR)
             .i_rs1(alu_rs1), //Source register 1 value (new value to be stored to CSR)
-            .o_csr_out(csr_out), //CSR value to be loaded to basereg
+            .o_csr_out(thread_csr_out[0]), //CSR value to be loaded to basereg
+            .o_csr_data(thread_csr_data[0]), //CSR value read at this stage (forwarded)
             // Trap-Handler 
             .i_pc(alu_pc), //Program Counter  (three stages had already been filled [fetch -> decode -> execute ])
-            .writeback_change_pc(writeback_change_pc), //high if writeback will issue change_pc (which will override this stage)
-            .o_return_address(csr_return_address), //mepc CSR
-            .o_trap_address(csr_trap_address), //mtvec CSR
-            .o_go_to_trap_q(csr_go_to_trap), //high before going to trap (if exception/interrupt detected)
-            .o_return_from_trap_q(csr_return_from_trap), //high before returning from trap (via mret)
-            .i_minstret_inc(writeback_ce), //high for one clock cycle at the end of every instruction
+            .writeback_change_pc(writeback_change_pc || thread_park), //high if writeback will issue change_pc or the load is parked (which will override this stage)
+            .o_return_address(thread_csr_return_address[0]), //mepc CSR
+            .o_trap_address(thread_csr_trap_address[0]), //mtvec CSR
+            .o_go_to_trap_q(thread_csr_go_to_trap[0]), //high before going to trap (if exception/interrupt detected)
+            .i_trap_fetched(alu_trap_fetched), //trap handler of the instruction at this stage is already fetched by ALU stage
+            .o_trap_fetched_q(thread_csr_trap_fetched[0]), //trap handler is already fetched (pipeline is not flushed)
+            .o_exception_address(thread_csr_exception_address[0]), //trap address of synchronous exceptions
+            .o_return_from_trap_q(thread_csr_return_from_trap[0]), //high before returning from trap (via mret)
+            .o_wake(thread_csr_wake[0]), //an enabled interrupt is pending (ends WFI)
+            .o_bank(thread_csr_bank[0]), //register bank used by the core (1 = shadow registers)
+            .o_bank_switch_q(thread_csr_bank_switch[0]), //high before switching the register bank by a CSR write
+            .i_minstret_inc(writeback_ce && thread == 0 && !thread_squash), //high for one clock cycle at the end of every instruction
+            .i_minstret_inc_slot1(writeback_ce && memoryaccess_slot1_ce && thread == 0 && !thread_squash), //high for one clock cycle at the end of every instruction of the second issue slot
+            .i_hpm_event({4{thread == 0}} & {!decoder_ce && !(stall_decoder || stall_operand || stall_alu || stall_memoryaccess || stall_writeback), //instruction fetch wait (decode stage has no instruction)
+                          stall_memoryaccess && !stall_writeback && !memoryaccess_sleep, //data memory wait (memory access stage stalled by load/store/fence)
+                          alu_change_pc && !alu_change_pc_trap && !writeback_change_pc, //branch/jump misprediction at ALU stage
+                          (alu_force_stall || alu_slot1_force_stall || (stall_operand && !stall_alu)) && !writeback_change_pc}), //operand forwarding stall (data dependency to load or CSR instruction)
             /// Pipeline Control ///
-            .i_ce(memoryaccess_ce), // input clk enable for pipeline stalling of this stage
+            .i_ce(memoryaccess_ce && thread == 0), // input clk enable for pipeline stalling of this stage (instruction of this thread)
             .i_stall((stall_writeback || stall_memoryaccess)) //informs this stage to stall
         );
+
+        //CSRs of threads 1 to THREADS-1 (mhartid is HART_ID + thread)
+        for(t = 1; t < THREADS; t = t + 1) begin: threads
+            rv32i_csr #(.TRAP_ADDRESS(TRAP_ADDRESS), .M_EXTENSION(M_EXTENSION), .C_EXTENSION(C_EXTENSION), .A_EXTENSION(A_EXTENSION), .HPM_COUNTERS(HPM_COUNTERS), .SHADOW_REGS(SHADOW_REGS),
+                       .CLIC(CLIC), .CLIC_INTERRUPTS(CLIC_INTERRUPTS), .COPROCESSOR(COPROCESSOR), .HART_ID(HART_ID + t)) m6( // Control and Status Registers of thread t [STAGE 4]
+                .i_clk(i_clk),
+                .i_rst_n(i_rst_n),
+                // Interrupts
+                .i_external_interrupt(i_external_interrupt[t]), //interrupt from external source
+                .i_software_interrupt(i_software_interrupt[t]), //interrupt from software (inter-processor interrupt)
+                .i_timer_interrupt(i_timer_interrupt[t]), //interrupt from timer
+                .i_clic_interrupt(i_clic_interrupt), //local interrupts (CLIC interrupt id 16 to 31)
+                /// Exceptions ///
+                .i_is_inst_illegal(alu_exception[`ILLEGAL]), //illegal instruction
+                .i_is_ecall(alu_exception[`ECALL]), //ecall instruction
+                .i_is_ebreak(alu_exception[`EBREAK]), //ebreak instruction
+                .i_is_mret(alu_exception[`MRET]), //mret (return from trap) instruction
+                .i_is_wfi(alu_exception[`WFI]), //wfi (wait for interrupt) instruction
+                /// Load/Store Misaligned Exception///
+                .i_opcode(alu_opcode), //opcode type from alu stage
+                .i_y(alu_y), //y value from ALU (address used in load/store/jump/branch)
+                /// CSR instruction ///
+                .i_funct3(alu_funct3), // CSR instruction operation
+                .i_csr_index(alu_imm), //immediate value decoded by decoder
+                .i_imm({27'b0,alu_rs1_addr}), //unsigned immediate for immediate type of CSR instruction (new value to be stored to CSR)
+                .i_rs1(alu_rs1), //Source register 1 value (new value to be stored to CSR)
+                .o_csr_out(thread_csr_out[t]), //CSR value to be loaded to basereg
+                .o_csr_data(thread_csr_data[t]), //CSR value read at this stage (forwarded)
+                // Trap-Handler 
+                .i_pc(alu_pc), //Program Counter  (three stages had already been filled [fetch -> decode -> execute ])
+                .writeback_change_pc(writeback_change_pc || thread_park), //high if writeback will issue change_pc or the load is parked (which will override this stage)
+                .o_return_address(thread_csr_return_address[t]), //mepc CSR
+                .o_trap_address(thread_csr_trap_address[t]), //mtvec CSR
+                .o_go_to_trap_q(thread_csr_go_to_trap[t]), //high before going to trap (if exception/interrupt detected)
+                .i_trap_fetched(alu_trap_fetched), //trap handler of the instruction at this stage is already fetched by ALU stage
+                .o_trap_fetched_q(thread_csr_trap_fetched[t]), //trap handler is already fetched (pipeline is not flushed)
+                .o_exception_address(thread_csr_exception_address[t]), //trap address of synchronous exceptions
+                .o_return_from_trap_q(thread_csr_return_from_trap[t]), //high before returning from trap (via mret)
+                .o_wake(thread_csr_wake[t]), //an enabled interrupt is pending (ends WFI)
+                .o_bank(thread_csr_bank[t]), //register bank used by the core (1 = shadow registers)
+                .o_bank_switch_q(thread_csr_bank_switch[t]), //high before switching the register bank by a CSR write
+                .i_minstret_inc(writeback_ce && thread == t && !thread_squash), //high for one clock cycle at the end of every instruction
+                .i_minstret_inc_slot1(writeback_ce && memoryaccess_slot1_ce && thread == t && !thread_squash), //high for one clock cycle at the end of every instruction of the second issue slot
+                .i_hpm_event({4{thread == t}} & {!decoder_ce && !(stall_decoder || stall_operand || stall_alu || stall_memoryaccess || stall_writeback), //instruction fetch wait (decode stage has no instruction)
+                              stall_memoryaccess && !stall_writeback && !memoryaccess_sleep, //data memory wait (memory access stage stalled by load/store/fence)
+                              alu_change_pc && !alu_change_pc_trap && !writeback_change_pc, //branch/jump misprediction at ALU stage
+                              (alu_force_stall || alu_slot1_force_stall || (stall_operand && !stall_alu)) && !writeback_change_pc}), //operand forwarding stall (data dependency to load or CSR instruction)
+                /// Pipeline Control ///
+                .i_ce(memoryaccess_ce && thread == t), // input clk enable for pipeline stalling of this stage (instruction of this thread)
+                .i_stall((stall_writeback || stall_memoryaccess)) //informs this stage to stall
+            );
+        end
     end
     else begin: zicsr
         assign csr_out = 0;
+        assign csr_data = 0;
         assign csr_return_address = 0;
         assign csr_trap_address = 0;
         assign csr_go_to_trap = 0;
+        assign csr_trap_fetched = 0;
+        assign csr_exception_address = 0;
         assign csr_return_from_trap = 0;
+        assign csr_bank = 0;
+        assign csr_bank_switch = 0;
+        assign csr_wake = 1; //no interrupts (WFI is a NOP)
     end
      
 
@@ -390,14 +1193,14 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         end
 
         // assumption on inputs(not more than one opcode and alu operation is high)
-        wire[4:0] f_alu=decoder_alu[`ADD]+decoder_alu[`SUB]+decoder_alu[`SLT]+decoder_alu[`SLTU]+decoder_alu[`XOR]+decoder_alu[`OR]+decoder_alu[`AND]+decoder_alu[`SLL]+decoder_alu[`SRL]+decoder_alu[`SRA]+decoder_alu[`EQ]+decoder_alu[`NEQ]+decoder_alu[`GE]+decoder_alu[`GEU]+0;
+        wire[5:0] f_alu=decoder_alu[`ADD]+decoder_alu[`SUB]+decoder_alu[`SLT]+decoder_alu[`SLTU]+decoder_alu[`XOR]+decoder_alu[`OR]+decoder_alu[`AND]+decoder_alu[`SLL]+decoder_alu[`SRL]+decoder_alu[`SRA]+decoder_alu[`EQ]+decoder_alu[`NEQ]+decoder_alu[`GE]+decoder_alu[`GEU]+decoder_alu[`MUL]+decoder_alu[`MULH]+decoder_alu[`MULHSU]+decoder_alu[`MULHU]+decoder_alu[`DIV]+decoder_alu[`DIVU]+decoder_alu[`REM]+decoder_alu[`REMU]+decoder_alu[`SH1ADD]+decoder_alu[`SH2ADD]+decoder_alu[`SH3ADD]+decoder_alu[`ANDN]+decoder_alu[`ORN]+decoder_alu[`XNOR]+decoder_alu[`CLZ]+decoder_alu[`CTZ]+decoder_alu[`CPOP]+decoder_alu[`MIN]+decoder_alu[`MINU]+decoder_alu[`MAX]+decoder_alu[`MAXU]+decoder_alu[`SEXTB]+decoder_alu[`SEXTH]+decoder_alu[`ZEXTH]+decoder_alu[`ROL]+decoder_alu[`ROR]+decoder_alu[`ORCB]+decoder_alu[`REV8]+0;
         wire[4:0] f_opcode=decoder_opcode[`RTYPE]+decoder_opcode[`ITYPE]+decoder_opcode[`LOAD]+decoder_opcode[`STORE]+decoder_opcode[`BRANCH]+decoder_opcode[`JAL]+decoder_opcode[`JALR]+decoder_opcode[`LUI]+decoder_opcode[`AUIPC]+decoder_opcode[`SYSTEM]+decoder_opcode[`FENCE]+0;
         always @* begin
             assume(f_alu <= 1);
             assume(f_opcode <= 1);
         end
 
-        wire[4:0] f_outstanding;
+        wire[$clog2(DATA_MAX_REQUESTS+1):0] f_outstanding;
 
    fwb_master #(
 		// {{{
@@ -405,7 +1208,7 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
         .DW(32),
 		.F_MAX_STALL(1),
 		.F_MAX_ACK_DELAY(1),
-		.F_LGDEPTH(4),
+		.F_LGDEPTH($clog2(DATA_MAX_REQUESTS+1)+1),
 		.F_MAX_REQUESTS(0),
 		// OPT_BUS_ABORT: If true, the master can drop CYC at any time
 		// and must drop CYC following any bus error
@@ -454,11 +1257,44 @@ module rv32i_core #(parameter PC_RESET = 32'h00_00_00_00, TRAP_ADDRESS = 0, ZICS
 		// }}}
 	);
         always @* begin
-            assert(f_outstanding <= 1);
-            if(f_outstanding == 1) begin
+            //requests on the bus (accepted or still on stb) must never exceed DATA_MAX_REQUESTS
+            assert(f_outstanding + o_wb_stb_data <= DATA_MAX_REQUESTS);
+            if(f_outstanding == DATA_MAX_REQUESTS) begin
                 assert(!o_wb_stb_data);
             end
         end
+
+        //////////////////////// verify that no instruction is lost or duplicated between fetch and decode stages ////////////////////////
+        reg[7:0] f_skid_in; //instructions handed over by fetch stage (two per handshake when dual issue)
+        reg[7:0] f_skid_out; //instructions taken by decode stage
+        wire[7:0] f_skid_count = f_skid_in - f_skid_out; //instructions waiting in the skid buffer
+        wire f_skid_push = fetch_ce && !stall_fetch;
+        wire f_skid_pop = decoder_ce && !(stall_decoder || stall_operand || stall_alu || stall_memoryaccess || stall_writeback);
+        reg[31:0] f_skid_pc; //PC of the instruction waiting in the skid buffer
+        always @(posedge i_clk, negedge i_rst_n) begin
+            if(!i_rst_n) begin
+                f_skid_in <= 0;
+                f_skid_out <= 0;
+            end
+            else if(decoder_flush) begin //wrong-path instructions are discarded
+                f_skid_in <= 0;
+                f_skid_out <= 0;
+            end
+            else begin
+                if(f_skid_push) f_skid_in <= f_skid_in + 1 + (DUAL && fetch_ce1);
+                if(f_skid_pop) f_skid_out <= f_skid_out + 1 + (DUAL && skid_ce1);
+            end
+        end
+        always @(posedge i_clk) begin
+            if(f_skid_push) f_skid_pc <= fetch_pc;
+        end
+        always @* begin
+            if(i_rst_n) begin
+                assert(f_skid_count == (stall_fetch? 1 + (DUAL && skid_ce1) : 0)); //only the instructions of one handshake wait while decode stage is stalled
+                if(stall_fetch) assert(decoder_ce && skid_pc == f_skid_pc); //instruction waiting is given to decode stage first
+                else assert(decoder_ce == fetch_ce && skid_pc == fetch_pc && skid_ce1 == fetch_ce1); //else instruction from fetch stage is passed through
+            end
+        end
   
         /*
         //////////////////////////////////////////////// verify Operand Forwarding ///////////////////////////////////////////////////
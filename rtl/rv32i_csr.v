@@ -4,17 +4,19 @@
 `default_nettype none
 `include "rv32i_header.vh"
 
-module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
+module rv32i_csr #(parameter TRAP_ADDRESS = 0, M_EXTENSION = 0, C_EXTENSION = 0, A_EXTENSION = 0, HPM_COUNTERS = 0, SHADOW_REGS = 0, CLIC = 0, CLIC_INTERRUPTS = 0, COPROCESSOR = 0, HART_ID = 0) (
     input wire i_clk, i_rst_n,
     // Interrupts
     input wire i_external_interrupt, //interrupt from external source
     input wire i_software_interrupt, //interrupt from software (inter-processor interrupt)
     input wire i_timer_interrupt, //interrupt from timer
+    input wire[15:0] i_clic_interrupt, //local interrupts (CLIC interrupt id 16 to 31, only the first CLIC_INTERRUPTS are used)
     /// Exceptions ///
     input wire i_is_inst_illegal, //illegal instruction
     input wire i_is_ecall, //ecall instruction
     input wire i_is_ebreak, //ebreak instruction
     input wire i_is_mret, //mret (return from trap) instruction
+    input wire i_is_wfi, //wfi (wait for interrupt) instruction
     /// Instruction/Load/Store Misaligned Exception///
     input wire[`OPCODE_WIDTH-1:0] i_opcode, //opcode types
     input wire[31:0] i_y, //y value from ALU (address used in load/store/jump/branch)
@@ -24,14 +26,23 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
     input wire[31:0] i_imm, //unsigned immediate for immediate type of CSR instruction (new value to be stored to CSR)
     input wire[31:0] i_rs1, //Source register 1 value (new value to be stored to CSR)
     output reg[31:0] o_csr_out, //CSR value to be loaded to basereg
+    output wire[31:0] o_csr_data, //CSR value read at this stage (forwarded to the operands of the next instructions)
     // Trap-Handler 
     input wire[31:0] i_pc, //Program Counter 
     input wire writeback_change_pc, //high if writeback will issue change_pc (which will override this stage)
     output reg[31:0] o_return_address, //mepc CSR
     output reg[31:0] o_trap_address, //mtvec CSR
     output reg o_go_to_trap_q, //high before going to trap (if exception/interrupt detected)
+    input wire i_trap_fetched, //trap handler of the instruction at this stage is already fetched by ALU stage (ECALL, EBREAK, illegal instruction)
+    output reg o_trap_fetched_q, //trap handler is already fetched (pipeline is not flushed)
+    output wire[31:0] o_exception_address, //trap address of synchronous exceptions (used by ALU stage to fetch the trap handler early)
     output reg o_return_from_trap_q, //high before returning from trap (via mret)
+    output wire o_wake, //an enabled interrupt is pending, even if interrupts are disabled by mstatus.mie (ends WFI)
     input wire i_minstret_inc, //increment minstret after executing an instruction
+    input wire i_minstret_inc_slot1, //increment minstret once more for the instruction of the second issue slot (dual issue)
+    output reg o_bank, //register bank used by the core (1 = shadow registers)
+    output reg o_bank_switch_q, //high before switching the register bank by a CSR write (instructions after the CSR write are fetched again)
+    input wire[3:0] i_hpm_event, //pipeline events for mhpmcounters {instruction fetch wait, data memory wait, ALU branch/jump misprediction, operand forwarding stall}
     /// Pipeline Control ///
     input wire i_ce, // input clk enable for pipeline stalling of this stage
     input wire i_stall //informs this stage to stall
@@ -56,12 +67,15 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
                MISA = 12'h301,
                MIE = 12'h304,
                MTVEC = 12'h305,
+               MTVT = 12'h307, //CLIC
                //machine trap handling
                MSCRATCH = 12'h340, 
                MEPC = 12'h341,
                MCAUSE = 12'h342,
                MTVAL = 12'h343,
                MIP = 12'h344,
+               MINTTHRESH = 12'h347, //CLIC
+               MINTSTATUS = 12'hFB1, //CLIC
                //machine counters/timers
                MCYCLE = 12'hB00,
                MCYCLEH = 12'hB80,
@@ -69,7 +83,24 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
                //TIMEH = 12'hC81,
                MINSTRET = 12'hB02,
                MINSTRETH = 12'hBB2,
-               MCOUNTINHIBIT = 12'h320;
+               MHPMCOUNTER3 = 12'hB03, //up to MHPMCOUNTER31 (12'hB1F)
+               MHPMCOUNTER3H = 12'hB83, //up to MHPMCOUNTER31H (12'hB9F)
+               MCOUNTINHIBIT = 12'h320,
+               MHPMEVENT3 = 12'h323, //up to MHPMEVENT31 (12'h33F)
+               //custom
+               MBANK = 12'h7C0,
+               CLICINT = 12'hBC0; //CLIC {clicintctl, clicintattr, clicintie, clicintip} of interrupt id at CLICINT + id (up to 12'hBDF)
+               
+               //interrupt ids implemented by the CLIC (software, timer, external, and CLIC_INTERRUPTS local interrupts)
+    localparam[31:0] CLIC_IDS = ((32'h1 << CLIC_INTERRUPTS) - 32'h1) << 16 | 32'h888;
+               
+               //mhpmevent codes (event counted by mhpmcounter)
+    localparam HPM_NO_EVENT = 0, //counter does not increment
+               HPM_FORWARD_STALL = 1, //clock cycles the ALU stage is stalled by a data dependency to a load or CSR instruction
+               HPM_MISPREDICT = 2, //branches and jumps mispredicted at the ALU stage (pipeline flushed)
+               HPM_DATA_WAIT = 3, //clock cycles the memory access stage is stalled waiting for the data memory
+               HPM_FETCH_WAIT = 4, //clock cycles the decode stage has no instruction from the fetch stage
+               HPM_TRAP = 5; //traps taken (exceptions and interrupts)
                 
                //mcause codes
     localparam MACHINE_SOFTWARE_INTERRUPT =3,
@@ -84,14 +115,17 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
     
     
     wire opcode_store=i_opcode[`STORE];
-    wire opcode_load=i_opcode[`LOAD];
+    wire opcode_load=i_opcode[`LOAD] && !i_opcode[`CUSTOM]; //custom instructions are decoded as loads but have no address
     wire opcode_branch=i_opcode[`BRANCH];
     wire opcode_jal=i_opcode[`JAL];
     wire opcode_jalr=i_opcode[`JALR];
     wire opcode_system=i_opcode[`SYSTEM];
+    wire opcode_amo=i_opcode[`AMO];
+    wire opcode_custom=i_opcode[`CUSTOM];
+    wire amo_store = opcode_amo && i_csr_index[11:7] != `FUNCT5_LR; //SC and AMOs are reported as store misaligned (i_csr_index[11:7] is funct5)
     reg[31:0] csr_in; //value to be stored to CSR
     reg[31:0] csr_data; //value at current CSR address
-    wire csr_enable = opcode_system && i_funct3!=0 && i_ce && !writeback_change_pc; //csr read/write operation is enabled only at this conditions
+    assign o_csr_data = csr_data; //same value is registered to o_csr_out when this stage moves on
     reg[1:0] new_pc = 0; //last two bits of i_pc that will be used in taken branch and jumps
     reg go_to_trap; //high before going to trap (if exception/interrupt detected)
     reg return_from_trap; //high before returning from trap (via mret)
@@ -105,6 +139,7 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
     reg is_interrupt;
     reg is_exception;
     reg is_trap;
+    wire csr_enable = opcode_system && i_funct3!=0 && i_ce && !writeback_change_pc && !is_interrupt; //csr read/write operation is enabled only at this conditions (an interrupted csr instruction is executed again after mret)
     wire stall_bit =i_stall;
 
     // CSR register bits
@@ -116,10 +151,11 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
     reg mie_msie; //machine software interrupt enable
     reg[29:0] mtvec_base; //address of i_pc after returning from interrupt (via MRET)
     reg[1:0] mtvec_mode; //vector mode addressing 
+    assign o_exception_address = {mtvec_base,2'b00}; //synchronous exceptions always go to the BASE field of mtvec
     reg[31:0] mscratch; //dedicated for use by machine code
     reg[31:0] mepc; //machine exception i_pc (address of interrupted instruction)
     reg mcause_intbit; //interrupt(1) or exception(0)
-    reg[3:0] mcause_code; //indicates event that caused the trap
+    reg[4:0] mcause_code; //indicates event that caused the trap
     reg[31:0] mtval; //exception-specific infotmation to assist software in handling trap
     reg mip_meip; //machine external interrupt pending
     reg mip_mtip; //machine timer interrupt pending
@@ -131,6 +167,38 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
     reg[63:0] minstret; //counts number instructions retired/executed by core
     reg mcountinhibit_cy; //controls increment of mcycle
     reg mcountinhibit_ir; //controls increment of minstret
+    wire[1:0] minstret_inc = (o_go_to_trap_q || o_return_from_trap_q)? 2'd0 : i_minstret_inc + i_minstret_inc_slot1; //number of instructions retired at this clock cycle
+    reg[63:0] mhpmcounter[3:31]; //counts the event selected by mhpmevent (only the first HPM_COUNTERS are implemented, the rest are hardwired to zero)
+    reg[2:0] mhpmevent[3:31]; //event counted by mhpmcounter
+    reg[31:3] mcountinhibit_hpm; //controls increment of mhpmcounters
+    reg mbank_pbank; //register bank restored by mret
+    reg mbank_new; //register bank selected by CSR write (used after the CSR instruction leaves the pipeline)
+    //CLIC (Core-Local Interrupt Controller)
+    wire clic_mode = CLIC != 0 && mtvec_mode == 2'b11; //CLIC interrupt mode (mtvec.mode = 3)
+    reg[25:0] mtvt_base; //base address of the vector table of interrupts with selective hardware vectoring (64-byte aligned)
+    reg[7:0] mintthresh_th; //interrupt level threshold (only interrupts with higher level are taken)
+    reg[7:0] mintstatus_mil; //interrupt level of the running trap handler (0 = not in an interrupt handler)
+    reg[7:0] mcause_mpil; //interrupt level before the trap (restored to mintstatus by mret)
+    wire[31:0] clic_src = {i_clic_interrupt, 4'b0, i_external_interrupt, 3'b0, i_timer_interrupt, 3'b0, i_software_interrupt, 3'b0}; //interrupt inputs indexed by interrupt id
+    reg[31:0] clic_in; //registered interrupt inputs (inverted for negative polarity)
+    reg[31:0] clicintip_edge; //pending bits of edge-triggered interrupts
+    reg[31:0] clicintie; //interrupt enable
+    reg[31:0] clicintattr_shv; //selective hardware vectoring (jump to mtvt + 4*id instead of mtvec)
+    reg[31:0] clicintattr_edge; //1 = edge-triggered, 0 = level-triggered
+    reg[31:0] clicintattr_neg; //1 = negative polarity (active-low level or falling edge)
+    wire[31:0] clicintip = (clicintattr_edge & clicintip_edge) | (~clicintattr_edge & clic_in); //interrupt pending
+    reg[7:0] clicintctl[0:31]; //interrupt level (higher level preempts lower level)
+    reg clic_pending; //high if an enabled interrupt is pending
+    reg[4:0] clic_id; //id of the pending interrupt with the highest level (highest id among same level)
+    reg[7:0] clic_level; //level of the pending interrupt
+    wire clic_interrupt = clic_pending && clic_level > mintstatus_mil && clic_level > mintthresh_th; //interrupt preempts the running code
+    /* Volume 2 pg. 47: The WFI instruction can also be executed when interrupts are disabled. The operation of WFI must be unaffected by 
+    the global interrupt bits in mstatus (MIE and SIE) and the delegation register mideleg, but should honor the individual interrupt enables. */
+    assign o_wake = clic_mode? clic_interrupt : (mie_meie && mip_meip) || (mie_mtie && mip_mtip) || (mie_msie && mip_msip);
+    wire[4:0] interrupt_code = clic_mode? clic_id : external_interrupt_pending? MACHINE_EXTERNAL_INTERRUPT : software_interrupt_pending? MACHINE_SOFTWARE_INTERRUPT : MACHINE_TIMER_INTERRUPT; //mcause code of interrupt
+    integer j;
+    wire[5:1] hpm_event = {go_to_trap && !o_go_to_trap_q && !stall_bit, i_hpm_event}; //event occured at this clock cycle (indexed by mhpmevent code)
+    integer i;
     
     //control logic for load/store/instruction misaligned exception detection
     always @* begin
@@ -145,8 +213,8 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             is_store_addr_misaligned = opcode_store? i_y[0] : 0;
         end
         if(i_funct3[1:0] == 2'b10) begin //word load/store
-            is_load_addr_misaligned = opcode_load? i_y[1:0]!=2'b00 : 0;
-            is_store_addr_misaligned = opcode_store? i_y[1:0]!=2'b00 : 0;
+            is_load_addr_misaligned = (opcode_load && !amo_store)? i_y[1:0]!=2'b00 : 0;
+            is_store_addr_misaligned = (opcode_store || amo_store)? i_y[1:0]!=2'b00 : 0;
         end
         
         // Misaligned Instruction Address
@@ -154,11 +222,14 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
         An instruction-address-misaligned exception is generated on a taken branch or unconditional jump
         if the target address is not four-byte aligned. This exception is reported on the branch or jump
         instruction, not on the target instruction. No instruction-address-misaligned exception is generated
-        for a conditional branch that is not taken. */
+        for a conditional branch that is not taken. 
+        Volume 1 pg. 97: With the addition of the C extension, no instructions can raise instruction-address-misaligned 
+        exceptions (instructions are aligned on two-byte boundary and JALR clears the least-significant bit of the target) */
         if((opcode_branch && i_y[0]) || opcode_jal || opcode_jalr) begin // branch or jump to new instruction
             new_pc = i_pc[1:0] + i_csr_index[1:0];
             if(opcode_jalr) new_pc = i_rs1[1:0] +  i_csr_index[1:0];
-            is_inst_addr_misaligned = (new_pc == 2'b00)? 1'b0:1'b1; //i_pc (instruction address) must always be four bytes aligned
+            if(C_EXTENSION != 0) is_inst_addr_misaligned = new_pc[0] && !opcode_jalr; //i_pc (instruction address) must be two bytes aligned
+            else is_inst_addr_misaligned = (new_pc == 2'b00)? 1'b0:1'b1; //i_pc (instruction address) must always be four bytes aligned
         end
         
     end
@@ -167,6 +238,7 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
     always @(posedge i_clk,negedge i_rst_n) begin
         if(!i_rst_n) begin
             o_go_to_trap_q <= 0;
+            o_trap_fetched_q <= 0;
             o_return_from_trap_q <= 0;        
             mstatus_mie <= 0;
             mstatus_mpie <= 0;
@@ -181,9 +253,6 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             mcause_intbit <= 0;
             mcause_code <= 0;
             mtval <= 0;
-            mip_meip <= 0;
-            mip_meip <= 0;
-            mip_msip <= 0;
             mcycle <= 0;
             //mtime <= 0;
             //millisec <= 0;
@@ -191,6 +260,15 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             minstret <= 0;
             mcountinhibit_cy <= 0;
             mcountinhibit_ir <= 0;
+            mcountinhibit_hpm <= 0;
+            o_bank <= 0;
+            o_bank_switch_q <= 0;
+            mbank_pbank <= 0;
+            mbank_new <= 0;
+            mtvt_base <= 0;
+            mintthresh_th <= 0;
+            mintstatus_mil <= 0;
+            mcause_mpil <= 0;
         end
         else if(!stall_bit) begin
             /***************************************************** CSR control logic *****************************************************/
@@ -243,7 +321,7 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             
             //MEPC (address of interrupted instruction)
             if(i_csr_index == MEPC && csr_enable) begin 
-                mepc <= {csr_in[31:2],2'b00};
+                mepc <= (C_EXTENSION != 0)? {csr_in[31:1],1'b0} : {csr_in[31:2],2'b00}; //mepc[0] is always zero (mepc[1] too if IALIGN=32)
             end
             /* Volume 2 pg. 38: When a trap is taken into M-mode, mepc is written with the virtual address of the 
              instruction that was interrupted or that encountered the exception */
@@ -253,21 +331,13 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             //MCAUSE (indicates cause of trap(either interrupt or exception))
             if(i_csr_index == MCAUSE && csr_enable) begin
                mcause_intbit <= csr_in[31];
-               mcause_code <= csr_in[3:0];         
+               mcause_code <= {CLIC != 0 && csr_in[4], csr_in[3:0]};         
             end
             /* Volume 2 pg. 38: When a trap is taken into M-mode, mcause is written with a code indicating the event that caused the trap */
             // Interrupts have priority (external first, then s/w, then timer---[2] sec 3.1.9), then synchronous traps.
             if(go_to_trap && !o_go_to_trap_q) begin
-                if(external_interrupt_pending) begin 
-                    mcause_code <= MACHINE_EXTERNAL_INTERRUPT; 
-                    mcause_intbit <= 1;
-                end
-                else if(software_interrupt_pending) begin
-                    mcause_code <= MACHINE_SOFTWARE_INTERRUPT; 
-                    mcause_intbit <= 1;
-                end
-                else if(timer_interrupt_pending) begin 
-                    mcause_code <= MACHINE_TIMER_INTERRUPT; 
+                if(is_interrupt) begin 
+                    mcause_code <= interrupt_code; 
                     mcause_intbit <= 1;
                 end
                 else if(i_is_inst_illegal) begin
@@ -297,6 +367,32 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             end
             
             
+            //MINTSTATUS and MCAUSE.MPIL (CLIC: interrupt level of the running trap handler and interrupt level before the trap)
+            /* CLIC: A trap saves the current interrupt level to mcause.mpil, an interrupt raises the interrupt level to the
+            level of the interrupt so only interrupts with higher level can preempt the handler (after it sets mstatus.mie),
+            and mret restores the interrupt level from mcause.mpil */
+            if(CLIC != 0) begin
+                if(i_csr_index == MCAUSE && csr_enable) mcause_mpil <= csr_in[23:16];
+                if(go_to_trap && !o_go_to_trap_q) begin
+                    mcause_mpil <= mintstatus_mil;
+                    if(clic_mode && is_interrupt) mintstatus_mil <= clic_level;
+                end
+                else if(return_from_trap && clic_mode) mintstatus_mil <= mcause_mpil;
+            end
+            
+            
+            //MTVT (CLIC: base address of the jump table of interrupts with selective hardware vectoring)
+            if(i_csr_index == MTVT && csr_enable && CLIC != 0) begin
+                mtvt_base <= csr_in[31:6];
+            end
+            
+            
+            //MINTTHRESH (CLIC: interrupt level threshold)
+            if(i_csr_index == MINTTHRESH && csr_enable && CLIC != 0) begin
+                mintthresh_th <= csr_in[7:0];
+            end
+            
+            
             //MTVAL (exception-specific information to assist software in handling trap)
             if(i_csr_index == MTVAL && csr_enable) begin
                 mtval <= csr_in;
@@ -348,10 +444,6 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
            
                    
                             
-            //MIP (pending interrupts)       
-            mip_msip <= i_software_interrupt;
-            mip_mtip <= i_timer_interrupt;
-            mip_meip <= i_external_interrupt;
             
             
             //MINSTRET (counts number instructions retired/executed by core [upper half])       
@@ -364,13 +456,33 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             if(i_csr_index == MINSTRETH && csr_enable) begin
                 minstret[63:32] <= csr_in; 
             end
-             minstret <= mcountinhibit_ir? minstret : minstret + {63'b0,(i_minstret_inc && !o_go_to_trap_q && !o_return_from_trap_q)}; //increment minstret every instruction
+             minstret <= mcountinhibit_ir? minstret : minstret + {62'b0,minstret_inc}; //increment minstret every instruction
              
              
             //MCOUNTINHIBIT (controls which hardware performance-monitoring counters can increment)
             if(i_csr_index == MCOUNTINHIBIT && csr_enable) begin
                 mcountinhibit_cy <= csr_in[0];
                 mcountinhibit_ir <= csr_in[2];
+                mcountinhibit_hpm <= csr_in[31:3];
+            end
+            
+            
+            //MBANK (custom: register bank used by the core [bit 0] and register bank restored by mret [bit 1])
+            /* The shadow register bank is used automatically on trap entry and the interrupted register bank is restored
+            on mret so a trap handler does not need to save and restore registers. Switching the register bank by a CSR write 
+            lets the trap handler access the registers of the interrupted code (e.g. RTOS context switch). The rd of the CSR 
+            instruction is still written to the old register bank and the instructions after it are fetched again. */
+            if(SHADOW_REGS != 0) begin
+                if(i_csr_index == MBANK && csr_enable) begin
+                    mbank_pbank <= csr_in[1];
+                    mbank_new <= csr_in[0];
+                end
+                if(go_to_trap && !o_go_to_trap_q) begin
+                    mbank_pbank <= o_bank_switch_q? mbank_new : o_bank; 
+                    o_bank <= 1;
+                end
+                else if(return_from_trap) o_bank <= mbank_pbank;
+                else if(o_bank_switch_q) o_bank <= mbank_new;
             end
 
              /****************************************************************************************************************************/
@@ -378,13 +490,18 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
              /************************************** Registered Outputs for Trap Handlers ************************************************/
              if(i_ce) begin
                  o_go_to_trap_q <= go_to_trap;
+                 o_trap_fetched_q <= go_to_trap && !is_interrupt && i_trap_fetched; //an interrupt taken instead goes to its own trap address
                  o_return_from_trap_q <= return_from_trap;
+                 o_bank_switch_q <= SHADOW_REGS != 0 && i_csr_index == MBANK && csr_enable;
                  o_return_address <= mepc;
                  /* Volume 2 pg. 30: When MODE=Direct (0), all traps into machine mode cause the i_pc to be set to the address in the  
                  BASE field. When MODE=Vectored (1), all synchronous exceptions into machine mode cause the i_pc to be set to the address 
                  in the BASE field, whereas interrupts cause the i_pc to be set to the address in the BASE field plus four times the
                  interrupt cause number */
-                 if(mtvec_mode[1] && is_interrupt) o_trap_address <= {mtvec_base,2'b00} + {28'b0,mcause_code<<2};
+                 if(mtvec_mode == 2'b01 && is_interrupt) o_trap_address <= {mtvec_base,2'b00} + {25'b0,interrupt_code,2'b00};
+                 /* CLIC: Interrupts with selective hardware vectoring (shv) jump to entry id of a jump table at mtvt 
+                 (each entry is a jump instruction to the handler), all other traps jump to the common handler at mtvec */
+                 else if(clic_mode && is_interrupt && clicintattr_shv[clic_id]) o_trap_address <= {mtvt_base,6'b000000} + {25'b0,clic_id,2'b00};
                  else o_trap_address <= {mtvec_base,2'b00};
                  
                  /****************************************************************************************************************************/
@@ -393,13 +510,92 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
               end
               else begin //THIS SOLVES THE PROBLEM OF FREERTOS NOT WORKING
                 o_go_to_trap_q <= 0;
+                o_trap_fetched_q <= 0;
                 o_return_from_trap_q <= 0;
+                o_bank_switch_q <= 0;
               end
         end
         else begin
             // this CSR will always be updated
             mcycle <= mcountinhibit_cy? mcycle : mcycle + 1; //increments mcycle every clock cycle
-            minstret <= mcountinhibit_ir? minstret : minstret + {63'b0,(i_minstret_inc && !o_go_to_trap_q && !o_return_from_trap_q)}; //increment minstret every instruction
+            minstret <= mcountinhibit_ir? minstret : minstret + {62'b0,minstret_inc}; //increment minstret every instruction
+        end
+    end
+
+    //MIP (pending interrupts are sampled every clock cycle, also while the pipeline is stalled since a WFI holds it until one is pending)
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            mip_msip <= 0;
+            mip_mtip <= 0;
+            mip_meip <= 0;
+        end
+        else begin
+            mip_msip <= i_software_interrupt;
+            mip_mtip <= i_timer_interrupt;
+            mip_meip <= i_external_interrupt;
+        end
+    end
+
+    //CLICINT (CLIC: pending, enable, attribute, and level of each interrupt id)
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            clic_in <= 0;
+            clicintip_edge <= 0;
+            clicintie <= 0;
+            clicintattr_shv <= 0;
+            clicintattr_edge <= 0;
+            clicintattr_neg <= 0;
+            for(j = 0; j < 32; j = j + 1) clicintctl[j] <= 0;
+        end
+        else if(CLIC != 0) begin
+            clic_in <= (clic_src ^ clicintattr_neg) & CLIC_IDS; //interrupt inputs are sampled every clock cycle
+            clicintip_edge <= clicintip_edge | ((clic_src ^ clicintattr_neg) & ~clic_in & clicintattr_edge); //edge-triggered interrupt becomes pending on rising (or falling) edge
+            //edge-triggered interrupt is no longer pending when taken
+            if(go_to_trap && !o_go_to_trap_q && !stall_bit && clic_mode && is_interrupt) clicintip_edge[clic_id] <= 0;
+            if(i_csr_index[11:5] == CLICINT[11:5] && CLIC_IDS[i_csr_index[4:0]] && csr_enable && !stall_bit) begin
+                clicintip_edge[i_csr_index[4:0]] <= csr_in[0]; //pending bit of edge-triggered interrupt can be set/cleared by software
+                clicintie[i_csr_index[4:0]] <= csr_in[8];
+                clicintattr_shv[i_csr_index[4:0]] <= csr_in[16];
+                clicintattr_edge[i_csr_index[4:0]] <= csr_in[17];
+                clicintattr_neg[i_csr_index[4:0]] <= csr_in[18];
+                clicintctl[i_csr_index[4:0]] <= csr_in[31:24];
+            end
+        end
+    end
+    
+    //select the pending and enabled interrupt with the highest level (highest id among same level)
+    always @* begin
+        clic_pending = 0;
+        clic_id = 0;
+        clic_level = 0;
+        for(j = 0; j < 32; j = j + 1) begin
+            if(CLIC_IDS[j] && clicintip[j] && clicintie[j] && clicintctl[j] >= clic_level) begin
+                clic_pending = 1;
+                clic_id = j[4:0];
+                clic_level = clicintctl[j];
+            end
+        end
+    end
+
+    //MHPMCOUNTER3..31 (counts the pipeline event selected by MHPMEVENT3..31 unless inhibited by mcountinhibit)
+    /* Volume 2 pg. 36: The hardware performance monitor includes 29 additional 64-bit event counters, mhpmcounter3-mhpmcounter31.
+    The event selector CSRs, mhpmevent3-mhpmevent31, are WARL registers that control which event causes the corresponding 
+    counter to increment. It is legal to implement any of the counters as read-only zero. */
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            for(i = 3; i < 32; i = i + 1) begin
+                mhpmcounter[i] <= 0;
+                mhpmevent[i] <= HPM_NO_EVENT;
+            end
+        end
+        else begin
+            for(i = 3; i < HPM_COUNTERS + 3; i = i + 1) begin
+                if(!stall_bit && csr_enable && i_csr_index == MHPMCOUNTER3 + i - 3) mhpmcounter[i][31:0] <= csr_in; //software write has priority over increment
+                else if(!stall_bit && csr_enable && i_csr_index == MHPMCOUNTER3H + i - 3) mhpmcounter[i][63:32] <= csr_in;
+                else if(!mcountinhibit_hpm[i] && mhpmevent[i] != HPM_NO_EVENT) mhpmcounter[i] <= mhpmcounter[i] + {63'b0, hpm_event[mhpmevent[i]]};
+                
+                if(!stall_bit && csr_enable && i_csr_index == MHPMEVENT3 + i - 3) mhpmevent[i] <= (csr_in <= HPM_TRAP)? csr_in[2:0] : HPM_NO_EVENT; //unsupported events are not counted
+            end
         end
     end
 
@@ -415,11 +611,15 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
         return_from_trap = 0;
         
         if(i_ce) begin
-             external_interrupt_pending =  mstatus_mie && mie_meie && (mip_meip); //machine_interrupt_enable + machine_external_interrupt_enable + machine_external_interrupt_pending must all be high
-             software_interrupt_pending = mstatus_mie && mie_msie && mip_msip;  //machine_interrupt_enable + machine_software_interrupt_enable + machine_software_interrupt_pending must all be high
-             timer_interrupt_pending = mstatus_mie && mie_mtie && mip_mtip; //machine_interrupt_enable + machine_timer_interrupt_enable + machine_timer_interrupt_pending must all be high
+             external_interrupt_pending =  !clic_mode && mstatus_mie && mie_meie && (mip_meip); //machine_interrupt_enable + machine_external_interrupt_enable + machine_external_interrupt_pending must all be high
+             software_interrupt_pending = !clic_mode && mstatus_mie && mie_msie && mip_msip;  //machine_interrupt_enable + machine_software_interrupt_enable + machine_software_interrupt_pending must all be high
+             timer_interrupt_pending = !clic_mode && mstatus_mie && mie_mtie && mip_mtip; //machine_interrupt_enable + machine_timer_interrupt_enable + machine_timer_interrupt_pending must all be high
              
-             is_interrupt = external_interrupt_pending || software_interrupt_pending || timer_interrupt_pending;
+             //atomic and custom instructions are not interrupted since their write to memory or request to coprocessor can not be undone (interrupt is taken at next instruction),
+             //WFI is not interrupted since the interrupt that ends it is taken at the next instruction (mepc is the pc after WFI),
+             //and an instruction to be flushed by writeback stage is not interrupted (mepc must be the pc of an instruction that will execute)
+             is_interrupt = (external_interrupt_pending || software_interrupt_pending || timer_interrupt_pending || (clic_mode && mstatus_mie && clic_interrupt)) 
+                            && !opcode_amo && !opcode_custom && !i_is_wfi && !writeback_change_pc;
              is_exception = (i_is_inst_illegal || is_inst_addr_misaligned || i_is_ecall || i_is_ebreak || is_load_addr_misaligned || is_store_addr_misaligned) && !writeback_change_pc;
              is_trap = is_interrupt || is_exception;
              go_to_trap = is_trap; //a trap is taken, save i_pc, and go to trap address
@@ -437,7 +637,7 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
             MVENDORID: csr_data = 32'h0;  //MVENDORID (JEDEC manufacturer ID)
               MARCHID: csr_data = 32'h0; //MARCHID (open-source project architecture ID allocated by RISC-V International  ( https://github.com/riscv/riscv-isa-manual/blob/master/marchid.md ))
                MIMPID: csr_data = 32'h0; //MIMPID (version of the processor implementation (provided by author of source code))
-              MHARTID: csr_data = 32'h0; //MHARTID (integer ID of the hart that is currently running the code (one hart must have an ID of zero))             
+              MHARTID: csr_data = HART_ID; //MHARTID (integer ID of the hart that is currently running the code (one hart must have an ID of zero))             
             
             //machine trap setup  
               MSTATUS: begin //MSTATUS (controls hart's current operating state (mie and mpie are the only configurable bits))
@@ -448,6 +648,10 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
                        
                  MISA: begin //MISA (control and monitor hart's current operating state)
                         csr_data[8] = 1'b1; //RV32I/64I/128I base ISA (ISA supported by the hart)
+                        csr_data[12] = M_EXTENSION != 0; //Integer Multiply/Divide extension
+                        csr_data[2] = C_EXTENSION != 0; //Compressed extension
+                        csr_data[0] = A_EXTENSION != 0; //Atomic extension
+                        csr_data[23] = COPROCESSOR != 0; //Non-standard extensions present (custom instructions)
                         csr_data[31:30] = 2'b01; //Base 32
                        end
                        
@@ -461,6 +665,10 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
                         csr_data = {mtvec_base,mtvec_mode};
                        end
                        
+                 MTVT: begin //MTVT (CLIC: base address of the jump table of interrupts with selective hardware vectoring)
+                        if(CLIC != 0) csr_data = {mtvt_base,6'b000000};
+                       end
+                       
             //machine trap handling
              MSCRATCH: begin //MSCRATCH (dedicated for use by machine code) 
                         csr_data = mscratch;
@@ -472,7 +680,8 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
                        
                MCAUSE: begin //MCAUSE (indicates cause of trap(either interrupt or exception))
                         csr_data[31] = mcause_intbit; 
-                        csr_data[3:0] = mcause_code;
+                        csr_data[4:0] = mcause_code;
+                        if(clic_mode) csr_data[23:16] = mcause_mpil; //interrupt level before the trap
                        end
                        
                 MTVAL: begin //MTVAL (exception-specific information to assist software in handling trap)
@@ -485,6 +694,14 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
                         csr_data[11] = mip_meip;
                        end
                        
+           MINTTHRESH: begin //MINTTHRESH (CLIC: interrupt level threshold)
+                        if(CLIC != 0) csr_data[7:0] = mintthresh_th;
+                       end
+                       
+           MINTSTATUS: begin //MINTSTATUS (CLIC: interrupt level of the running trap handler)
+                        if(CLIC != 0) csr_data[31:24] = mintstatus_mil;
+                       end
+                       
             //machine counters/timers
                MCYCLE: begin //MCYCLE (counts number of i_clk cycle executed by core [LOWER HALF])
                         csr_data = mcycle[31:0];
@@ -514,10 +731,28 @@ module rv32i_csr #(parameter TRAP_ADDRESS = 0) (
         MCOUNTINHIBIT: begin //MCOUNTINHIBIT (controls which hardware performance-monitoring counters can increment)
                         csr_data[0] = mcountinhibit_cy;
                         csr_data[2] = mcountinhibit_ir;
+                        csr_data[31:3] = mcountinhibit_hpm;
+                       end
+            
+            //custom
+                MBANK: begin //MBANK (register bank used by the core and register bank restored by mret)
+                        csr_data[0] = SHADOW_REGS != 0 && o_bank;
+                        csr_data[1] = SHADOW_REGS != 0 && mbank_pbank;
                        end
                        
               default: csr_data = 0;
         endcase
+        //CLICINT (CLIC: {clicintctl, clicintattr, clicintie, clicintip} of interrupt id at CLICINT + id)
+        if(CLIC != 0 && i_csr_index[11:5] == CLICINT[11:5] && CLIC_IDS[i_csr_index[4:0]]) begin
+            csr_data = {clicintctl[i_csr_index[4:0]], 5'b0, clicintattr_neg[i_csr_index[4:0]], clicintattr_edge[i_csr_index[4:0]], clicintattr_shv[i_csr_index[4:0]],
+                        7'b0, clicintie[i_csr_index[4:0]], 7'b0, clicintip[i_csr_index[4:0]]};
+        end
+        //MHPMCOUNTER3..31, MHPMCOUNTER3H..31H, and MHPMEVENT3..31 (hardware performance-monitoring counters)
+        if(i_csr_index[4:0] >= 3 && i_csr_index[4:0] < HPM_COUNTERS + 3) begin
+            if(i_csr_index[11:5] == MHPMCOUNTER3[11:5]) csr_data = mhpmcounter[i_csr_index[4:0]][31:0];
+            if(i_csr_index[11:5] == MHPMCOUNTER3H[11:5]) csr_data = mhpmcounter[i_csr_index[4:0]][63:32];
+            if(i_csr_index[11:5] == MHPMEVENT3[11:5]) csr_data = {29'b0, mhpmevent[i_csr_index[4:0]]};
+        end
         /*****************************************************************************************************************************/
         
         
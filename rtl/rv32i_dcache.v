@@ -0,0 +1,315 @@
+/* The rv32i_dcache module is an optional write-back, write-allocate data cache
+placed between the memory access stage and the data memory (wishbone) bus. It
+lets data (e.g. stack and heap) be placed on slow or external memory. Key
+functionalities of the rv32i_dcache module include:
+ - Cache organization: The cache is direct-mapped (WAYS = 1) or 2-way set-associative
+    (WAYS = 2) with 2**INDEX_WIDTH sets and LINE_WORDS 32-bit words per line.
+    The data address is split into {tag, index, word offset}. For 2-way, the
+    least recently used way of the set is replaced on a miss.
+ - Cache hit: The memory access stage is a wishbone master of this module. The tag
+    and data are read (block ram) at the clock cycle the request is accepted and
+    compared on the next clock cycle. On a hit, a load is acknowledged with the
+    word read from the cache and a store writes the bytes selected by i_wb_sel
+    to the cache and marks the line as dirty (write-back). A new request can be
+    accepted at the same clock cycle a hit is acknowledged.
+ - Miss: The line to be replaced (invalid way first) is written back to memory by
+    a burst of LINE_WORDS back-to-back write requests if it is dirty. Then the new
+    line is refilled by a burst of LINE_WORDS back-to-back read requests (store
+    misses also refill the line since the cache is write-allocate). The request
+    is then looked up again which will now be a hit.
+ - Uncached bypass: Requests to the memory-mapped peripherals region (address MSB
+    is high) are never cached and are directly sent to the data memory bus.
+ - Clean and invalidate: While i_clean is high, all dirty lines are written back to
+    memory (lines stay valid) then o_clean_done goes high until i_clean goes low.
+    This is used by FENCE.I so the instruction memory sees all previous stores.
+    i_invalidate drops all lines (including dirty lines) in one clock cycle, e.g.
+    when another bus master changed memory (tied low in rv32i_core).
+*/
+
+`timescale 1ns / 1ps
+`default_nettype none
+
+module rv32i_dcache #(parameter WAYS = 1, //1 = direct-mapped, 2 = 2-way set-associative
+                      INDEX_WIDTH = 6, //cache has 2**INDEX_WIDTH sets
+                      LINE_WORDS = 4 //number of 32-bit words per cache line (burst length of refill/writeback, power of 2 and at least 2)
+                      ) (
+    input wire i_clk, i_rst_n,
+    //Memory Access Stage Interface (wishbone slave)
+    input wire i_wb_cyc, //bus cycle active
+    input wire i_wb_stb, //request for read/write access
+    input wire i_wb_we, //write-enable (1 = write, 0 = read)
+    input wire[31:0] i_wb_addr, //data address
+    input wire[31:0] i_wb_data, //data to be stored
+    input wire[3:0] i_wb_sel, //byte strobe for write (1 = write the byte) {byte3,byte2,byte1,byte0}
+    output reg o_wb_ack, //ack (high when read data is ready or when write data is already written)
+    output wire o_wb_stall, //stall (1 = cache is busy)
+    output reg[31:0] o_wb_data, //data retrieved
+    //Data Memory Interface (wishbone master)
+    output wire o_wb_cyc_mem, //bus cycle active
+    output reg o_wb_stb_mem, //request for read/write access to data memory
+    output reg o_wb_we_mem, //write-enable (1 = write, 0 = read)
+    output reg[31:0] o_wb_addr_mem, //data memory address
+    output reg[31:0] o_wb_data_mem, //data to be stored to memory
+    output reg[3:0] o_wb_sel_mem, //byte strobe for write
+    input wire i_wb_ack_mem, //ack by data memory (in the same order as requests)
+    input wire i_wb_stall_mem, //stall by data memory
+    input wire[31:0] i_wb_data_mem, //data retrieved from data memory
+    // Cache Control
+    input wire i_clean, //write back all dirty lines (FENCE.I)
+    output reg o_clean_done, //high when all dirty lines are written back (until i_clean goes low)
+    input wire i_invalidate //invalidate all lines
+);
+    localparam SETS = 2**INDEX_WIDTH;
+    localparam LINE_OFFSET = $clog2(LINE_WORDS); //number of word offset bits in the address
+    localparam TAG_WIDTH = 30 - INDEX_WIDTH - LINE_OFFSET;
+    localparam IDLE = 0,
+               WRITEBACK = 1,
+               REFILL = 2,
+               REPLAY = 3,
+               UNCACHED = 4,
+               CLEAN = 5;
+
+    reg[31:0] data0[SETS*LINE_WORDS-1:0]; //data words of way 0
+    reg[31:0] data1[SETS*LINE_WORDS-1:0]; //data words of way 1
+    reg[TAG_WIDTH-1:0] tag0[SETS-1:0]; //tag of way 0
+    reg[TAG_WIDTH-1:0] tag1[SETS-1:0]; //tag of way 1
+    reg[SETS-1:0] valid0, valid1; //line is valid
+    reg[SETS-1:0] dirty0, dirty1; //line is modified and not yet written back to memory
+    reg[SETS-1:0] lru; //way to be replaced next on the set (least recently used)
+
+    reg[2:0] state;
+    reg req_valid; //high if there is a request being looked up
+    reg req_we; //request is a write
+    reg[31:0] req_addr; //address of request
+    reg[31:0] req_data; //data to be stored of request
+    reg[3:0] req_sel; //byte strobe of request
+    reg[31:0] rd_data0, rd_data1; //data read from each way
+    reg[TAG_WIDTH-1:0] rd_tag0, rd_tag1; //tag read from each way
+    reg[INDEX_WIDTH-1:0] line_index; //set of line being written back or refilled
+    reg line_way; //way of line being written back or refilled
+    reg[LINE_OFFSET:0] req_count; //number of burst requests sent
+    reg[LINE_OFFSET:0] ack_count; //number of burst requests acknowledged
+    reg[INDEX_WIDTH-1:0] clean_index; //set being checked for dirty lines
+    reg clean_way; //way being checked for dirty lines
+    reg[INDEX_WIDTH+LINE_OFFSET-1:0] data_raddr; //read address of data block ram
+    reg[INDEX_WIDTH-1:0] tag_raddr; //read address of tag block ram
+
+    wire[INDEX_WIDTH-1:0] req_index = req_addr[INDEX_WIDTH+LINE_OFFSET+1 : LINE_OFFSET+2];
+    wire[TAG_WIDTH-1:0] req_tag = req_addr[31 : INDEX_WIDTH+LINE_OFFSET+2];
+    wire[INDEX_WIDTH+LINE_OFFSET-1:0] req_word = req_addr[INDEX_WIDTH+LINE_OFFSET+1 : 2]; //{index, word offset} of request
+    wire[TAG_WIDTH-1:0] line_tag = line_way? rd_tag1 : rd_tag0; //tag of line being written back
+    wire uncached = req_addr[31]; //memory-mapped peripherals are never cached
+    wire hit0 = valid0[req_index] && rd_tag0 == req_tag;
+    wire hit1 = WAYS == 2 && valid1[req_index] && rd_tag1 == req_tag;
+    wire hit = state == IDLE && req_valid && !uncached && (hit0 || hit1);
+    wire miss = state == IDLE && req_valid && !uncached && !(hit0 || hit1);
+    //way to be replaced on a miss (invalid way first)
+    wire victim_way = (WAYS == 1 || !valid0[req_index])? 1'b0 : (!valid1[req_index])? 1'b1 : lru[req_index];
+    wire victim_dirty = victim_way? (valid1[req_index] && dirty1[req_index]) : (valid0[req_index] && dirty0[req_index]);
+    wire clean_dirty = clean_way? (valid1[clean_index] && dirty1[clean_index]) : (valid0[clean_index] && dirty0[clean_index]);
+    wire start_clean = state == IDLE && !req_valid && i_clean && !o_clean_done;
+    //new request is accepted when no request is being looked up or when the current request is acknowledged (a load
+    //right after a store hit on the same word waits one clock cycle so it reads the updated word)
+    wire ready = state == IDLE && (!req_valid || (hit && !(req_we && i_wb_addr[31:2] == req_addr[31:2]))) && !start_clean;
+    wire accept = i_wb_cyc && i_wb_stb && ready;
+    //burst request can be sent when the current request (if any) is accepted by data memory
+    wire send_burst = (state == WRITEBACK || state == REFILL) && req_count != LINE_WORDS && !(o_wb_stb_mem && i_wb_stall_mem);
+    wire burst_done = i_wb_ack_mem && ack_count == LINE_WORDS-1;
+
+    assign o_wb_stall = !ready;
+    assign o_wb_cyc_mem = state == WRITEBACK || state == REFILL || state == UNCACHED;
+
+    //response to the memory access stage
+    always @* begin
+        o_wb_ack = hit || (state == UNCACHED && i_wb_ack_mem);
+        o_wb_data = (state == UNCACHED)? i_wb_data_mem : (hit0? rd_data0 : rd_data1);
+    end
+
+    //read address of block rams
+    always @* begin
+        data_raddr = i_wb_addr[INDEX_WIDTH+LINE_OFFSET+1 : 2];
+        tag_raddr = accept? i_wb_addr[INDEX_WIDTH+LINE_OFFSET+1 : LINE_OFFSET+2] : req_index;
+        if(miss) data_raddr = {req_index, {LINE_OFFSET{1'b0}}}; //first word of line to be written back
+        if(state == CLEAN) begin //tag and first word of line to be cleaned
+            data_raddr = {clean_index, {LINE_OFFSET{1'b0}}};
+            tag_raddr = clean_index;
+        end
+        if(state == WRITEBACK) data_raddr = {line_index, req_count[LINE_OFFSET-1:0] + send_burst}; //next word to be written back
+        if(state == REPLAY) data_raddr = req_word;
+    end
+
+    //block rams
+    always @(posedge i_clk) begin
+        rd_data0 <= data0[data_raddr];
+        rd_data1 <= data1[data_raddr];
+        if(state != WRITEBACK) begin //tag of line being written back must not change
+            rd_tag0 <= tag0[tag_raddr];
+            rd_tag1 <= tag1[tag_raddr];
+        end
+        //store hit
+        if(hit && req_we) begin
+            if(hit1) begin
+                if(req_sel[0]) data1[req_word][7:0] <= req_data[7:0];
+                if(req_sel[1]) data1[req_word][15:8] <= req_data[15:8];
+                if(req_sel[2]) data1[req_word][23:16] <= req_data[23:16];
+                if(req_sel[3]) data1[req_word][31:24] <= req_data[31:24];
+            end
+            else begin
+                if(req_sel[0]) data0[req_word][7:0] <= req_data[7:0];
+                if(req_sel[1]) data0[req_word][15:8] <= req_data[15:8];
+                if(req_sel[2]) data0[req_word][23:16] <= req_data[23:16];
+                if(req_sel[3]) data0[req_word][31:24] <= req_data[31:24];
+            end
+        end
+        //refill
+        if(state == REFILL && i_wb_ack_mem) begin
+            if(line_way) data1[{line_index, ack_count[LINE_OFFSET-1:0]}] <= i_wb_data_mem;
+            else data0[{line_index, ack_count[LINE_OFFSET-1:0]}] <= i_wb_data_mem;
+        end
+        if(state == REFILL && burst_done) begin
+            if(line_way) tag1[line_index] <= req_tag;
+            else tag0[line_index] <= req_tag;
+        end
+    end
+
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            state <= IDLE;
+            req_valid <= 0;
+            valid0 <= 0;
+            valid1 <= 0;
+            dirty0 <= 0;
+            dirty1 <= 0;
+            lru <= 0;
+            o_wb_stb_mem <= 0;
+            o_wb_we_mem <= 0;
+            req_count <= 0;
+            ack_count <= 0;
+            line_index <= 0;
+            line_way <= 0;
+            clean_index <= 0;
+            clean_way <= 0;
+            o_clean_done <= 0;
+        end
+        else begin
+            //burst request is accepted if no stall from memory: idle the stb line
+            if(o_wb_stb_mem && !i_wb_stall_mem) o_wb_stb_mem <= 0;
+
+            case(state)
+                IDLE: begin
+                        if(req_valid && uncached) begin //send request directly to data memory
+                            state <= UNCACHED;
+                            o_wb_stb_mem <= 1;
+                            o_wb_we_mem <= req_we;
+                            o_wb_addr_mem <= req_addr;
+                            o_wb_data_mem <= req_data;
+                            o_wb_sel_mem <= req_sel;
+                        end
+                        else if(miss) begin //write back replaced line first if dirty then refill
+                            state <= victim_dirty? WRITEBACK : REFILL;
+                            line_index <= req_index;
+                            line_way <= victim_way;
+                            req_count <= 0;
+                            ack_count <= 0;
+                        end
+                        else if(hit) begin
+                            if(WAYS == 2) lru[req_index] <= hit0; //the way not used is replaced next
+                            if(req_we && hit1) dirty1[req_index] <= 1;
+                            if(req_we && !hit1) dirty0[req_index] <= 1;
+                        end
+                        else if(start_clean) begin //check all lines starting from first set
+                            state <= CLEAN;
+                            clean_index <= 0;
+                            clean_way <= 0;
+                        end
+                      end
+
+           WRITEBACK: begin
+                        if(send_burst) begin
+                            o_wb_stb_mem <= 1;
+                            o_wb_we_mem <= 1;
+                            o_wb_addr_mem <= {line_tag, line_index, req_count[LINE_OFFSET-1:0], 2'b00};
+                            o_wb_data_mem <= line_way? rd_data1 : rd_data0;
+                            o_wb_sel_mem <= 4'b1111;
+                            req_count <= req_count + 1;
+                        end
+                        if(i_wb_ack_mem) ack_count <= ack_count + 1;
+                        if(burst_done) begin //line is now clean
+                            if(line_way) dirty1[line_index] <= 0;
+                            else dirty0[line_index] <= 0;
+                            state <= req_valid? REFILL : CLEAN; //refill the replaced line or continue cleaning
+                            req_count <= 0;
+                            ack_count <= 0;
+                        end
+                      end
+
+              REFILL: begin
+                        if(send_burst) begin
+                            o_wb_stb_mem <= 1;
+                            o_wb_we_mem <= 0;
+                            o_wb_addr_mem <= {req_tag, line_index, req_count[LINE_OFFSET-1:0], 2'b00};
+                            o_wb_sel_mem <= 4'b1111;
+                            req_count <= req_count + 1;
+                        end
+                        if(i_wb_ack_mem) ack_count <= ack_count + 1;
+                        if(burst_done) begin //line is now valid
+                            if(line_way) begin
+                                valid1[line_index] <= 1;
+                                dirty1[line_index] <= 0;
+                            end
+                            else begin
+                                valid0[line_index] <= 1;
+                                dirty0[line_index] <= 0;
+                            end
+                            state <= REPLAY;
+                        end
+                      end
+
+              REPLAY: state <= IDLE; //request is read again from the cache (will now be a hit)
+
+            UNCACHED: if(i_wb_ack_mem) state <= IDLE; //request is acknowledged
+
+               CLEAN: begin
+                        if(clean_dirty) begin //write back dirty line
+                            state <= WRITEBACK;
+                            line_index <= clean_index;
+                            line_way <= clean_way;
+                            req_count <= 0;
+                            ack_count <= 0;
+                        end
+                        else if(clean_way == WAYS-1 || WAYS == 1) begin //go to next set
+                            clean_way <= 0;
+                            clean_index <= clean_index + 1;
+                            if(clean_index == SETS-1) begin //all lines are already clean
+                                state <= IDLE;
+                                o_clean_done <= 1;
+                            end
+                        end
+                        else clean_way <= 1;
+                      end
+             default: state <= IDLE;
+            endcase
+
+            //register new request to be looked up on the next clock cycle
+            if(accept) begin
+                req_valid <= 1;
+                req_we <= i_wb_we;
+                req_addr <= i_wb_addr;
+                req_data <= i_wb_data;
+                req_sel <= i_wb_sel;
+            end
+            else if(hit || (state == UNCACHED && i_wb_ack_mem)) req_valid <= 0;
+
+            if(!i_clean) o_clean_done <= 0;
+
+            //invalidate all lines
+            if(i_invalidate) begin
+                valid0 <= 0;
+                valid1 <= 0;
+                dirty0 <= 0;
+                dirty1 <= 0;
+            end
+        end
+    end
+
+endmodule
@@ -13,14 +13,37 @@ in the decode stage of the pipeline. This module has several key components:
  - ALU operation decoding: The module decodes the required ALU operation based on the 
     opcode and funct3 fields of the instruction. It sets the appropriate signals 
     (alu_add_d, alu_sub_d, alu_slt_d, etc.) to indicate the desired operation to be 
-    executed in the ALU during the execution stage.
+    executed in the ALU during the execution stage. When M_EXTENSION is enabled,
+    R-type instructions with funct7 = 0000001 are decoded as the multiply/divide
+    operations (alu_mul_d, alu_div_d, etc.), otherwise they are illegal instructions.
+    Likewise, the Zba and Zbb bit-manipulation instructions (alu_sh1add_d, alu_clz_d,
+    alu_rev8_d, etc.) are decoded only when ZB_EXTENSION is enabled.
+ - Atomic instructions: When A_EXTENSION is enabled, LR.W, SC.W, and the AMOs are decoded
+    as loads (opcode_load_d) which are also marked as atomic (opcode_amo_d) so that the
+    destination register waits for the memory access stage like a normal load. The address
+    is rs1 (the ALU adds nothing to it) and funct5 is passed to the next stages through
+    the immediate (o_imm[11:7]).
+ - Custom instructions: When COPROCESSOR is enabled, the custom-0 and custom-1 opcodes
+    (R-type layout) are dispatched to the coprocessor interface. They are also decoded as
+    loads (opcode_load_d) which are marked as custom (opcode_custom_d) so that the destination
+    register waits for the coprocessor response at the memory access stage. rs1 passes through
+    the ALU unchanged, funct7 is passed through the immediate (o_imm[11:5]), and o_imm[0] is
+    high for custom-1.
  - Opcode type decoding: The module identifies the type of instruction based on its opcode 
     (opcode_rtype_d, opcode_itype_d, opcode_load_d, etc.). These signals are used in the 
     next stages of the pipeline to control the flow of data and determine the required 
     operations.
  - Exception decoding: The module checks for illegal instructions, system instructions 
-    (ECALL, EBREAK, and MRET), and unsupported shift operations. If any of these conditions 
+    (ECALL, EBREAK, MRET, and WFI), and unsupported shift operations. If any of these conditions 
     are detected, the corresponding exception signals (o_exception) are set.
+ - Early branch resolution: When EARLY_BRANCH is enabled, JAL instructions are 
+    resolved at this stage, and so are branch instructions whose operands are already
+    available through operand forwarding (i_rs_valid). The resolved next PC (o_next_pc)
+    is used by the fetch stage to change the PC right away instead of waiting for 
+    the ALU stage.
+ - Compressed instructions: Compressed instructions are already expanded by the fetch stage,
+    so they are decoded like any 32-bit instruction. Only the size of the instruction 
+    (o_compressed) is passed to the next stages for computing the return address (PC+2).
  - Pipeline control: The module supports pipeline stalling and flushing. If the next stage 
     of the pipeline is stalled (i_stall), the module will stall the decode stage (o_stall) 
     and prevent updating the output registers. If a flush signal (i_flush) is received, the 
@@ -32,11 +55,13 @@ in the decode stage of the pipeline. This module has several key components:
 `default_nettype none
 `include "rv32i_header.vh"
 
-module rv32i_decoder(
+module rv32i_decoder #(parameter EARLY_BRANCH = 0, M_EXTENSION = 0, ZB_EXTENSION = 0, A_EXTENSION = 0, COPROCESSOR = 0) (
     input wire i_clk,i_rst_n,
     input wire[31:0] i_inst, //32 bit instruction
     input wire[31:0] i_pc, //PC value from previous stage
     output reg[31:0] o_pc, //PC value
+    input wire i_compressed, //high if instruction is an expanded compressed instruction
+    output reg o_compressed, //high if instruction is an expanded compressed instruction (next PC is PC+2)
     output wire[4:0] o_rs1_addr,//address for register source 1
     output reg[4:0] o_rs1_addr_q,//registered address for register source 1
     output wire[4:0] o_rs2_addr, //address for register source 2
@@ -46,7 +71,19 @@ module rv32i_decoder(
     output reg[2:0] o_funct3, //function type
     output reg[`ALU_WIDTH-1:0] o_alu, //alu operation type
     output reg[`OPCODE_WIDTH-1:0] o_opcode, //opcode type
-    output reg[`EXCEPTION_WIDTH-1:0] o_exception, //exceptions: illegal inst, ecall, ebreak, mret
+    output reg[`EXCEPTION_WIDTH-1:0] o_exception, //exceptions: illegal inst, ecall, ebreak, mret, wfi
+    /// Branch Prediction ///
+    input wire i_pred_taken, //high if instruction is predicted as a taken branch/jump by fetch stage
+    output reg o_pred_taken, //high if instruction is predicted as a taken branch/jump
+    input wire[31:0] i_pred_pc, //predicted target address from fetch stage
+    output reg[31:0] o_pred_pc, //predicted target address
+    /// Early Branch Resolution ///
+    input wire[31:0] i_rs1, //rs1 value at this stage (with operand forwarding)
+    input wire[31:0] i_rs2, //rs2 value at this stage (with operand forwarding)
+    input wire i_rs_valid, //high if i_rs1 and i_rs2 are already the most updated values
+    output reg o_branch_resolved, //high if branch/jump is resolved at this stage
+    output reg o_branch_taken, //high if the resolved branch/jump is taken
+    output wire[31:0] o_next_pc, //target address of branch/jump
     /// Pipeline Control ///
     input wire i_ce, // input clk enable for pipeline stalling of this stage
     output reg o_ce, // output clk enable for pipeline stalling of next stage
@@ -62,6 +99,7 @@ module rv32i_decoder(
 
     wire[2:0] funct3_d = i_inst[14:12];
     wire[6:0] opcode = i_inst[6:0];
+    wire[6:0] funct7_d = i_inst[31:25];
 
     reg[31:0] imm_d;
     reg alu_add_d;
@@ -78,6 +116,34 @@ module rv32i_decoder(
     reg alu_neq_d;
     reg alu_ge_d; 
     reg alu_geu_d;
+    reg alu_mul_d;
+    reg alu_mulh_d;
+    reg alu_mulhsu_d;
+    reg alu_mulhu_d;
+    reg alu_div_d;
+    reg alu_divu_d;
+    reg alu_rem_d;
+    reg alu_remu_d;
+    reg alu_sh1add_d;
+    reg alu_sh2add_d;
+    reg alu_sh3add_d;
+    reg alu_andn_d;
+    reg alu_orn_d;
+    reg alu_xnor_d;
+    reg alu_clz_d;
+    reg alu_ctz_d;
+    reg alu_cpop_d;
+    reg alu_min_d;
+    reg alu_minu_d;
+    reg alu_max_d;
+    reg alu_maxu_d;
+    reg alu_sextb_d;
+    reg alu_sexth_d;
+    reg alu_zexth_d;
+    reg alu_rol_d;
+    reg alu_ror_d;
+    reg alu_orcb_d;
+    reg alu_rev8_d;
     
     reg opcode_rtype_d;
     reg opcode_itype_d;
@@ -90,10 +156,15 @@ module rv32i_decoder(
     reg opcode_auipc_d;
     reg opcode_system_d;
     reg opcode_fence_d;
+    reg opcode_amo_d;
+    reg opcode_custom_d;
             
     reg system_noncsr = 0;
     reg valid_opcode = 0;
     reg illegal_shift = 0;
+    reg illegal_muldiv = 0;
+    reg bitmanip_d = 0;
+    reg illegal_bitmanip = 0;
     wire stall_bit = o_stall || i_stall; //stall this stage when next stages are stalled
 
     //register the outputs of this decoder module for shorter combinational timing paths
@@ -104,11 +175,14 @@ module rv32i_decoder(
         else begin
             if(i_ce && !stall_bit) begin //update registers only if this stage is enabled and pipeline is not stalled
                 o_pc       <= i_pc;
+                o_compressed <= i_compressed;
                 o_rs1_addr_q <= o_rs1_addr;
                 o_rs2_addr_q <= o_rs2_addr;
                 o_rd_addr  <= i_inst[11:7];
                 o_funct3   <= funct3_d;
                 o_imm      <= imm_d;
+                o_pred_taken <= i_pred_taken;
+                o_pred_pc  <= i_pred_pc;
                 
                 /// ALU Operations ////
                 o_alu[`ADD]  <= alu_add_d;
@@ -125,6 +199,34 @@ module rv32i_decoder(
                 o_alu[`NEQ]  <= alu_neq_d;
                 o_alu[`GE]   <= alu_ge_d; 
                 o_alu[`GEU]  <= alu_geu_d;
+                o_alu[`MUL]  <= alu_mul_d;
+                o_alu[`MULH] <= alu_mulh_d;
+                o_alu[`MULHSU] <= alu_mulhsu_d;
+                o_alu[`MULHU] <= alu_mulhu_d;
+                o_alu[`DIV]  <= alu_div_d;
+                o_alu[`DIVU] <= alu_divu_d;
+                o_alu[`REM]  <= alu_rem_d;
+                o_alu[`REMU] <= alu_remu_d;
+                o_alu[`SH1ADD] <= alu_sh1add_d;
+                o_alu[`SH2ADD] <= alu_sh2add_d;
+                o_alu[`SH3ADD] <= alu_sh3add_d;
+                o_alu[`ANDN]  <= alu_andn_d;
+                o_alu[`ORN]   <= alu_orn_d;
+                o_alu[`XNOR]  <= alu_xnor_d;
+                o_alu[`CLZ]   <= alu_clz_d;
+                o_alu[`CTZ]   <= alu_ctz_d;
+                o_alu[`CPOP]  <= alu_cpop_d;
+                o_alu[`MIN]   <= alu_min_d;
+                o_alu[`MINU]  <= alu_minu_d;
+                o_alu[`MAX]   <= alu_max_d;
+                o_alu[`MAXU]  <= alu_maxu_d;
+                o_alu[`SEXTB] <= alu_sextb_d;
+                o_alu[`SEXTH] <= alu_sexth_d;
+                o_alu[`ZEXTH] <= alu_zexth_d;
+                o_alu[`ROL]   <= alu_rol_d;
+                o_alu[`ROR]   <= alu_ror_d;
+                o_alu[`ORCB]  <= alu_orcb_d;
+                o_alu[`REV8]  <= alu_rev8_d;
                           
                 o_opcode[`RTYPE]  <= opcode_rtype_d;
                 o_opcode[`ITYPE]  <= opcode_itype_d;
@@ -137,18 +239,23 @@ module rv32i_decoder(
                 o_opcode[`AUIPC]  <= opcode_auipc_d;
                 o_opcode[`SYSTEM] <= opcode_system_d;
                 o_opcode[`FENCE]  <= opcode_fence_d;
+                o_opcode[`AMO]    <= opcode_amo_d;
+                o_opcode[`CUSTOM] <= opcode_custom_d;
                 
                 /*********************** decode possible exceptions ***********************/
-                o_exception[`ILLEGAL] <= !valid_opcode || illegal_shift;
+                o_exception[`ILLEGAL] <= !valid_opcode || illegal_shift || illegal_muldiv || illegal_bitmanip;
 
                 // Check if ECALL
                 o_exception[`ECALL] <= (system_noncsr && i_inst[21:20]==2'b00)? 1:0;
                 
                 // Check if EBREAK
-                o_exception[`EBREAK] <= (system_noncsr && i_inst[21:20]==2'b01)? 1:0;
+                o_exception[`EBREAK] <= (system_noncsr && i_inst[22:20]==3'b001)? 1:0;
                 
                 // Check if MRET
                  o_exception[`MRET] <= (system_noncsr && i_inst[21:20]==2'b10)? 1:0;
+                 
+                // Check if WFI
+                o_exception[`WFI] <= (system_noncsr && i_inst[22:20]==3'b101)? 1:0;
                 /***************************************************************************/
             end
             if(i_flush && !stall_bit) begin //flush this stage so clock-enable of next stage is disabled at next clock cycle
@@ -165,7 +272,13 @@ module rv32i_decoder(
         //// Opcode Type ////
         opcode_rtype_d  = opcode == `OPCODE_RTYPE;
         opcode_itype_d  = opcode == `OPCODE_ITYPE;
-        opcode_load_d   = opcode == `OPCODE_LOAD;
+        opcode_amo_d    = opcode == `OPCODE_AMO && funct3_d == 3'b010 && A_EXTENSION != 0 && (i_inst[31:27] == `FUNCT5_LR? o_rs2_addr == 0 :
+                          i_inst[31:27] == `FUNCT5_SC || i_inst[31:27] == `FUNCT5_AMOSWAP || i_inst[31:27] == `FUNCT5_AMOADD ||
+                          i_inst[31:27] == `FUNCT5_AMOXOR || i_inst[31:27] == `FUNCT5_AMOAND || i_inst[31:27] == `FUNCT5_AMOOR ||
+                          i_inst[31:27] == `FUNCT5_AMOMIN || i_inst[31:27] == `FUNCT5_AMOMAX || i_inst[31:27] == `FUNCT5_AMOMINU ||
+                          i_inst[31:27] == `FUNCT5_AMOMAXU); //only valid atomic instructions are decoded (else illegal)
+        opcode_custom_d = (opcode == `OPCODE_CUSTOM0 || opcode == `OPCODE_CUSTOM1) && COPROCESSOR != 0; //custom instructions are illegal without coprocessor
+        opcode_load_d   = opcode == `OPCODE_LOAD || opcode_amo_d || opcode_custom_d; //atomic instructions load rd from memory, custom instructions from coprocessor
         opcode_store_d  = opcode == `OPCODE_STORE;
         opcode_branch_d = opcode == `OPCODE_BRANCH;
         opcode_jal_d    = opcode == `OPCODE_JAL;
@@ -181,6 +294,44 @@ module rv32i_decoder(
         // Check if instruction is illegal    
         valid_opcode = (opcode_rtype_d || opcode_itype_d || opcode_load_d || opcode_store_d || opcode_branch_d || opcode_jal_d || opcode_jalr_d || opcode_lui_d || opcode_auipc_d || opcode_system_d || opcode_fence_d);
         illegal_shift = (opcode_itype_d && (alu_sll_d || alu_srl_d || alu_sra_d)) && i_inst[25];
+        illegal_muldiv = opcode_rtype_d && funct7_d == `FUNCT7_MULDIV && M_EXTENSION == 0; //multiply/divide instruction but M extension is disabled
+        
+        // Check if Zba/Zbb bit-manipulation instruction
+        bitmanip_d = (opcode_rtype_d && funct7_d == `FUNCT7_SHADD && (funct3_d == `FUNCT3_SH1ADD || funct3_d == `FUNCT3_SH2ADD || funct3_d == `FUNCT3_SH3ADD)) ||
+                     (opcode_rtype_d && funct7_d == `FUNCT7_LOGICN && (funct3_d == `FUNCT3_ANDN || funct3_d == `FUNCT3_ORN || funct3_d == `FUNCT3_XNOR)) ||
+                     (opcode_rtype_d && funct7_d == `FUNCT7_MINMAX && funct3_d[2]) ||
+                     (opcode_rtype_d && funct7_d == `FUNCT7_ROTATE && (funct3_d == `FUNCT3_ROL || funct3_d == `FUNCT3_ROR)) ||
+                     (opcode_rtype_d && funct7_d == `FUNCT7_ZEXTH && funct3_d == 3'b100 && o_rs2_addr == 0) || //zext.h
+                     (opcode_itype_d && funct7_d == `FUNCT7_ROTATE && funct3_d == 3'b001 && (o_rs2_addr <= 2 || o_rs2_addr == 4 || o_rs2_addr == 5)) || //clz, ctz, cpop, sext.b, sext.h
+                     (opcode_itype_d && funct7_d == `FUNCT7_ROTATE && funct3_d == `FUNCT3_ROR) || //rori
+                     (opcode_itype_d && i_inst[31:20] == `IMM_ORCB && funct3_d == 3'b101) || //orc.b
+                     (opcode_itype_d && i_inst[31:20] == `IMM_REV8 && funct3_d == 3'b101); //rev8
+        illegal_bitmanip = bitmanip_d && ZB_EXTENSION == 0; //bit-manipulation instruction but Zba/Zbb extension is disabled
+    end
+
+    //resolve JAL and branch instructions early (when operands are already available)
+    assign o_next_pc = i_pc + imm_d;
+    always @* begin
+        o_branch_resolved = 0;
+        o_branch_taken = 0;
+        if(EARLY_BRANCH != 0) begin
+            if(opcode_jal_d) begin
+                o_branch_resolved = 1;
+                o_branch_taken = 1;
+            end
+            else if(opcode_branch_d && i_rs_valid) begin
+                o_branch_resolved = 1;
+                case(funct3_d)
+                    `FUNCT3_EQ: o_branch_taken = i_rs1 == i_rs2;
+                   `FUNCT3_NEQ: o_branch_taken = i_rs1 != i_rs2;
+                    `FUNCT3_LT: o_branch_taken = $signed(i_rs1) < $signed(i_rs2);
+                    `FUNCT3_GE: o_branch_taken = $signed(i_rs1) >= $signed(i_rs2);
+                   `FUNCT3_LTU: o_branch_taken = i_rs1 < i_rs2;
+                   `FUNCT3_GEU: o_branch_taken = i_rs1 >= i_rs2;
+                       default: o_branch_resolved = 0; //invalid branch is left to the ALU stage
+                endcase
+            end
+        end
     end
 
      //decode operation for ALU and the extended value of immediate
@@ -202,9 +353,78 @@ module rv32i_decoder(
         alu_neq_d = 0;
         alu_ge_d = 0; 
         alu_geu_d = 0;
+        alu_mul_d = 0;
+        alu_mulh_d = 0;
+        alu_mulhsu_d = 0;
+        alu_mulhu_d = 0;
+        alu_div_d = 0;
+        alu_divu_d = 0;
+        alu_rem_d = 0;
+        alu_remu_d = 0;
+        alu_sh1add_d = 0;
+        alu_sh2add_d = 0;
+        alu_sh3add_d = 0;
+        alu_andn_d = 0;
+        alu_orn_d = 0;
+        alu_xnor_d = 0;
+        alu_clz_d = 0;
+        alu_ctz_d = 0;
+        alu_cpop_d = 0;
+        alu_min_d = 0;
+        alu_minu_d = 0;
+        alu_max_d = 0;
+        alu_maxu_d = 0;
+        alu_sextb_d = 0;
+        alu_sexth_d = 0;
+        alu_zexth_d = 0;
+        alu_rol_d = 0;
+        alu_ror_d = 0;
+        alu_orcb_d = 0;
+        alu_rev8_d = 0;
         
         /********** Decode ALU Operation **************/
-        if(opcode == `OPCODE_RTYPE || opcode == `OPCODE_ITYPE) begin
+        if(opcode == `OPCODE_RTYPE && funct7_d == `FUNCT7_MULDIV && M_EXTENSION != 0) begin //multiply/divide operations
+            alu_mul_d = funct3_d == `FUNCT3_MUL;
+            alu_mulh_d = funct3_d == `FUNCT3_MULH;
+            alu_mulhsu_d = funct3_d == `FUNCT3_MULHSU;
+            alu_mulhu_d = funct3_d == `FUNCT3_MULHU;
+            alu_div_d = funct3_d == `FUNCT3_DIV;
+            alu_divu_d = funct3_d == `FUNCT3_DIVU;
+            alu_rem_d = funct3_d == `FUNCT3_REM;
+            alu_remu_d = funct3_d == `FUNCT3_REMU;
+        end
+
+        else if(bitmanip_d && ZB_EXTENSION != 0) begin //Zba/Zbb bit-manipulation operations
+            if(opcode == `OPCODE_RTYPE) begin
+                alu_sh1add_d = funct7_d == `FUNCT7_SHADD && funct3_d == `FUNCT3_SH1ADD;
+                alu_sh2add_d = funct7_d == `FUNCT7_SHADD && funct3_d == `FUNCT3_SH2ADD;
+                alu_sh3add_d = funct7_d == `FUNCT7_SHADD && funct3_d == `FUNCT3_SH3ADD;
+                alu_andn_d = funct7_d == `FUNCT7_LOGICN && funct3_d == `FUNCT3_ANDN;
+                alu_orn_d = funct7_d == `FUNCT7_LOGICN && funct3_d == `FUNCT3_ORN;
+                alu_xnor_d = funct7_d == `FUNCT7_LOGICN && funct3_d == `FUNCT3_XNOR;
+                alu_min_d = funct7_d == `FUNCT7_MINMAX && funct3_d == `FUNCT3_MIN;
+                alu_minu_d = funct7_d == `FUNCT7_MINMAX && funct3_d == `FUNCT3_MINU;
+                alu_max_d = funct7_d == `FUNCT7_MINMAX && funct3_d == `FUNCT3_MAX;
+                alu_maxu_d = funct7_d == `FUNCT7_MINMAX && funct3_d == `FUNCT3_MAXU;
+                alu_rol_d = funct7_d == `FUNCT7_ROTATE && funct3_d == `FUNCT3_ROL;
+                alu_ror_d = funct7_d == `FUNCT7_ROTATE && funct3_d == `FUNCT3_ROR;
+                alu_zexth_d = funct7_d == `FUNCT7_ZEXTH;
+            end
+            else if(funct3_d == 3'b001) begin //unary operations selected by rs2 field
+                alu_clz_d = o_rs2_addr == 0;
+                alu_ctz_d = o_rs2_addr == 1;
+                alu_cpop_d = o_rs2_addr == 2;
+                alu_sextb_d = o_rs2_addr == 4;
+                alu_sexth_d = o_rs2_addr == 5;
+            end
+            else begin
+                alu_ror_d = funct7_d == `FUNCT7_ROTATE; //rori uses the immediate as shift amount
+                alu_orcb_d = i_inst[31:20] == `IMM_ORCB;
+                alu_rev8_d = i_inst[31:20] == `IMM_REV8;
+            end
+        end
+
+        else if(opcode == `OPCODE_RTYPE || opcode == `OPCODE_ITYPE) begin
             if(opcode == `OPCODE_RTYPE) begin
                 alu_add_d = funct3_d == `FUNCT3_ADD ? !i_inst[30] : 0; //add and sub has same o_funct3 code
                 alu_sub_d = funct3_d == `FUNCT3_ADD ? i_inst[30] : 0;      //differs on i_inst[30]
@@ -240,6 +460,8 @@ module rv32i_decoder(
                                         `OPCODE_JAL: imm_d = {{11{i_inst[31]}},i_inst[31],i_inst[19:12],i_inst[20],i_inst[30:21],1'b0};
                         `OPCODE_LUI , `OPCODE_AUIPC: imm_d = {i_inst[31:12],12'h000};
                      `OPCODE_SYSTEM , `OPCODE_FENCE: imm_d = {20'b0,i_inst[31:20]};   
+                                        `OPCODE_AMO: imm_d = {20'b0,i_inst[31:20]}; //funct5 of atomic instruction (not an offset)
+                `OPCODE_CUSTOM0 , `OPCODE_CUSTOM1: imm_d = {20'b0,i_inst[31:25],4'b0,opcode[5]}; //funct7 and custom-1 bit of custom instruction (not an offset)
                      default: imm_d = 0;
         endcase
         /**************************************************************************/
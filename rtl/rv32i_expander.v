@@ -0,0 +1,97 @@
+/* The rv32i_expander module converts a 16-bit compressed instruction (RV32C) into its
+equivalent 32-bit instruction so that the rest of the pipeline only needs to decode
+the base instruction formats. It is purely combinational and sits inside the fetch
+stage right before the instruction register that feeds the decode stage. Function includes:
+ - Operand mapping: The 3-bit register fields (rd', rs1', rs2') of the CIW, CL, CS, CA,
+    and CB formats are mapped to registers x8-x15, while the CR and CI formats use the
+    full 5-bit register fields. Stack-pointer-relative loads/stores and C.ADDI16SP/C.ADDI4SPN
+    implicitly use x2 (sp) and C.JAL/C.JALR implicitly link to x1 (ra).
+ - Immediate reconstruction: The scrambled immediate bits of each compressed format are
+    reassembled and sign/zero extended to the immediate field of the 32-bit format.
+ - Illegal instructions: Reserved encodings (all-zero instruction, C.ADDI4SPN/C.ADDI16SP/C.LUI
+    with zero immediate, C.LWSP/C.JR with rd/rs1 = x0, RV32 shifts with shamt[5] = 1) and the
+    floating-point instructions are expanded to all zeros, which the decoder reports as
+    an illegal instruction.
+*/
+
+`timescale 1ns / 1ps
+`default_nettype none
+`include "rv32i_header.vh"
+
+module rv32i_expander (
+    input wire[15:0] i_inst, //16-bit compressed instruction
+    output reg[31:0] o_inst //equivalent 32-bit instruction (all zeros if illegal)
+);
+
+    wire[2:0] funct3 = i_inst[15:13];
+    wire[4:0] rd = i_inst[11:7]; //rd/rs1 (CR and CI formats)
+    wire[4:0] rs2 = i_inst[6:2]; //rs2 (CR and CSS formats)
+    wire[4:0] rd_p = {2'b01, i_inst[4:2]}; //rd'/rs2' (x8-x15)
+    wire[4:0] rs1_p = {2'b01, i_inst[9:7]}; //rd'/rs1' (x8-x15)
+    wire[11:0] imm_ci = {{7{i_inst[12]}}, i_inst[6:2]}; //C.ADDI, C.LI, C.ANDI
+    wire[11:0] imm_addi4spn = {2'b00, i_inst[10:7], i_inst[12:11], i_inst[5], i_inst[6], 2'b00};
+    wire[11:0] imm_addi16sp = {{3{i_inst[12]}}, i_inst[4:3], i_inst[5], i_inst[2], i_inst[6], 4'b0000};
+    wire[11:0] imm_lw = {5'b00000, i_inst[5], i_inst[12:10], i_inst[6], 2'b00}; //C.LW, C.SW
+    wire[11:0] imm_lwsp = {4'b0000, i_inst[3:2], i_inst[12], i_inst[6:4], 2'b00};
+    wire[11:0] imm_swsp = {4'b0000, i_inst[8:7], i_inst[12:9], 2'b00};
+    wire[20:0] imm_j = {{10{i_inst[12]}}, i_inst[8], i_inst[10:9], i_inst[6], i_inst[7], i_inst[2], i_inst[11], i_inst[5:3], 1'b0}; //C.J, C.JAL
+    wire[12:0] imm_b = {{5{i_inst[12]}}, i_inst[6:5], i_inst[2], i_inst[11:10], i_inst[4:3], 1'b0}; //C.BEQZ, C.BNEZ
+
+    always @* begin
+        o_inst = 0; //illegal instruction
+        case(i_inst[1:0])
+            2'b00: case(funct3) //quadrant 0
+                    3'b000: if(imm_addi4spn != 0) o_inst = {imm_addi4spn, 5'd2, `FUNCT3_ADD, rd_p, `OPCODE_ITYPE}; //C.ADDI4SPN
+                    3'b010: o_inst = {imm_lw, rs1_p, 3'b010, rd_p, `OPCODE_LOAD}; //C.LW
+                    3'b110: o_inst = {imm_lw[11:5], rd_p, rs1_p, 3'b010, imm_lw[4:0], `OPCODE_STORE}; //C.SW
+                   default: o_inst = 0;
+                   endcase
+
+            2'b01: case(funct3) //quadrant 1
+                    3'b000: o_inst = {imm_ci, rd, `FUNCT3_ADD, rd, `OPCODE_ITYPE}; //C.ADDI (C.NOP)
+                    3'b001: o_inst = {imm_j[20], imm_j[10:1], imm_j[11], imm_j[19:12], 5'd1, `OPCODE_JAL}; //C.JAL
+                    3'b010: o_inst = {imm_ci, 5'd0, `FUNCT3_ADD, rd, `OPCODE_ITYPE}; //C.LI
+                    3'b011: if(rd == 5'd2) begin
+                                if(imm_addi16sp != 0) o_inst = {imm_addi16sp, 5'd2, `FUNCT3_ADD, 5'd2, `OPCODE_ITYPE}; //C.ADDI16SP
+                            end
+                            else if(imm_ci != 0) o_inst = {{8{i_inst[12]}}, imm_ci, rd, `OPCODE_LUI}; //C.LUI
+                    3'b100: case(i_inst[11:10])
+                             2'b00, 2'b01: if(!i_inst[12]) o_inst = {1'b0, i_inst[10], 5'b00000, rs2, rs1_p, `FUNCT3_SRA, rs1_p, `OPCODE_ITYPE}; //C.SRLI, C.SRAI
+                                    2'b10: o_inst = {imm_ci, rs1_p, `FUNCT3_AND, rs1_p, `OPCODE_ITYPE}; //C.ANDI
+                                    2'b11: if(!i_inst[12]) begin
+                                                case(i_inst[6:5])
+                                                    2'b00: o_inst = {7'b0100000, rd_p, rs1_p, `FUNCT3_ADD, rs1_p, `OPCODE_RTYPE}; //C.SUB
+                                                    2'b01: o_inst = {7'b0000000, rd_p, rs1_p, `FUNCT3_XOR, rs1_p, `OPCODE_RTYPE}; //C.XOR
+                                                    2'b10: o_inst = {7'b0000000, rd_p, rs1_p, `FUNCT3_OR, rs1_p, `OPCODE_RTYPE}; //C.OR
+                                                    2'b11: o_inst = {7'b0000000, rd_p, rs1_p, `FUNCT3_AND, rs1_p, `OPCODE_RTYPE}; //C.AND
+                                                endcase
+                                            end
+                            endcase
+                    3'b101: o_inst = {imm_j[20], imm_j[10:1], imm_j[11], imm_j[19:12], 5'd0, `OPCODE_JAL}; //C.J
+                    3'b110: o_inst = {imm_b[12], imm_b[10:5], 5'd0, rs1_p, `FUNCT3_EQ, imm_b[4:1], imm_b[11], `OPCODE_BRANCH}; //C.BEQZ
+                    3'b111: o_inst = {imm_b[12], imm_b[10:5], 5'd0, rs1_p, `FUNCT3_NEQ, imm_b[4:1], imm_b[11], `OPCODE_BRANCH}; //C.BNEZ
+                   endcase
+
+            2'b10: case(funct3) //quadrant 2
+                    3'b000: if(!i_inst[12]) o_inst = {7'b0000000, rs2, rd, `FUNCT3_SLL, rd, `OPCODE_ITYPE}; //C.SLLI
+                    3'b010: if(rd != 0) o_inst = {imm_lwsp, 5'd2, 3'b010, rd, `OPCODE_LOAD}; //C.LWSP
+                    3'b100: if(!i_inst[12]) begin
+                                if(rs2 == 0) begin
+                                    if(rd != 0) o_inst = {12'd0, rd, 3'b000, 5'd0, `OPCODE_JALR}; //C.JR
+                                end
+                                else o_inst = {7'b0000000, rs2, 5'd0, `FUNCT3_ADD, rd, `OPCODE_RTYPE}; //C.MV
+                            end
+                            else begin
+                                if(rs2 == 0 && rd == 0) o_inst = 32'h00100073; //C.EBREAK
+                                else if(rs2 == 0) o_inst = {12'd0, rd, 3'b000, 5'd1, `OPCODE_JALR}; //C.JALR
+                                else o_inst = {7'b0000000, rs2, rd, `FUNCT3_ADD, rd, `OPCODE_RTYPE}; //C.ADD
+                            end
+                    3'b110: o_inst = {imm_swsp[11:5], rs2, 5'd2, 3'b010, imm_swsp[4:0], `OPCODE_STORE}; //C.SWSP
+                   default: o_inst = 0;
+                   endcase
+
+           default: o_inst = 0; //not a compressed instruction
+        endcase
+    end
+
+endmodule
@@ -9,127 +9,625 @@ the pipeline. Below are the key functions of the rv32i_fetch module:
     such as branches, jumps, or traps.
  - Instruction fetching: The module fetches the instruction from memory based on 
     the current PC value. It sends a request for a new instruction (o_stb_inst) 
-    when the fetch stage is enabled (ce), and waits for an acknowledgment 
-    (i_ack_inst) from the memory. The fetched instruction (i_inst) is then sent
-    to the pipeline (o_inst).
+    when the fetch stage is enabled (ce) and there is a place to store the
+    instruction (o_inst or the prefetch queue), and waits for an acknowledgment
+    (i_ack_inst) from the memory. A new request can be sent at the same clock
+    cycle the previous one is acknowledged. Up to MAX_REQUESTS requests can be
+    outstanding if the instruction memory accepts a request every clock cycle 
+    and acknowledges them in order, hiding the latency of slow memories. The fetched instruction (i_inst) is then sent to the pipeline (o_inst).
  - Pipeline control: The rv32i_fetch module manages the pipeline by controlling 
-    clock enable (o_ce) signals for the next stage. It can stall the fetch stage
-    (stall_fetch) when the next stages are stalled (i_stall), a requested 
-    instruction has not yet been acknowledged, or when there is no request for a
-    new instruction. Moreover, it can create pipeline bubbles when the PC needs 
-    to be changed, disabling clock enable signals for the next stages, ensuring
-    no instructions are executed during this period.
+    clock enable (o_ce) signals for the next stage. Pipeline bubbles are created
+    when the requested instruction has not yet been acknowledged or when the PC 
+    needs to be changed, disabling clock enable signals for the next stages, 
+    ensuring no instructions are executed during this period. The stall (i_stall)
+    comes registered from the skid buffer in front of the decode stage (rv32i_skid),
+    so the stall of the next stages does not reach the PC logic in the same clock cycle.
  - PC control: The module updates the PC based on the control signals received 
     from other stages in the pipeline. It can update the PC with a new address
-    (i_writeback_next_pc) when handling traps, or with the address of a taken 
-    branch or jump (i_alu_next_pc). The fetch stage can be stalled during this
-    process to prevent instructions from being executed in the pipeline.
-  - Handling stalls and flushes: The rv32i_fetch module can stall the fetch 
-    stage based on different conditions and store the current PC and instruction
-    values. When the stall condition is resolved, it can return to the stored 
-    values and continue fetching instructions. The module can also flush the 
-    fetch stage when required (i_flush), disabling the clock enable signal 
-    for the next stage, effectively clearing any pending instructions.
+    (i_writeback_next_pc) when handling traps, or with the address of a 
+    mispredicted branch or jump (i_alu_next_pc). Requests that are still waiting
+    for acknowledgment when the PC changes are discarded once acknowledged.
+  - Prefetch queue: Fetching is decoupled from the next stages by a FIFO of
+    PREFETCH_DEPTH entries. While the next stages are stalled (i_stall), the
+    sequential (or BTB predicted) instructions keep on being fetched and are 
+    queued along with their PC and prediction. When the stall is resolved, the
+    queued instructions are sent to the pipeline one per clock cycle (oldest 
+    first) without waiting for the instruction memory.
+  - Compressed instructions: When C_EXTENSION is enabled, instructions can be 16 bits
+    long and 32-bit instructions can start at any halfword. The prefetch queue then 
+    holds fetched words which are split into instructions by an aligner: a halfword 
+    left over from the previous word is either a whole compressed instruction or the 
+    lower half of a 32-bit instruction which straddles the word boundary, and is joined 
+    with the lower half of the next word. Compressed instructions are expanded to their
+    32-bit equivalent (rv32i_expander) before entering the decode stage, with o_compressed
+    high so that the next stages use PC+2 instead of PC+4. The instruction memory is 
+    still read one word at a time, so a word of two compressed instructions feeds the 
+    pipeline for two clock cycles.
+  - Handling flushes: The module can flush the fetch stage when required (i_flush)
+    or when the PC changes, disabling the clock enable signal for the next stage
+    and discarding all queued instructions.
+ - Branch prediction: The next instruction address can be predicted so that 
+    taken branches and jumps do not need to wait for the ALU stage to change
+    the PC. The type of predictor is chosen by the parameter BRANCH_PREDICTOR:
+    0 = no prediction (always PC+4), 1 = static BTFN (Backward Taken, Forward 
+    Not-taken) where backward branches and JAL are redirected as soon as they 
+    leave this stage, 2 = dynamic prediction using a Branch Target Buffer (BTB)
+    with 2-bit saturating counters looked up with the instruction address itself,
+    falling back to static BTFN when the BTB misses. The BTB has 2**BTB_INDEX_WIDTH
+    entries. The prediction (o_pred_taken and o_pred_pc) travels along with the 
+    instruction and is verified by the ALU stage, which updates the BTB 
+    (i_alu_branch_resolved) and changes the PC through the usual flush path 
+    on a misprediction. Branches and jumps already resolved at the decode stage
+    (i_decoder_branch_resolved) use the resolved next PC instead of the prediction.
+ - Return address stack (RAS): Calls (JAL/JALR with rd = x1/x5) push their return 
+    address and returns (JALR with rs1 = x1/x5 and rd not a link register) pop it
+    when they leave this stage, so that returns are predicted by the RAS instead of
+    the BTB. The RAS has RAS_DEPTH entries (power of 2, 0 = no RAS). When full, a 
+    call overwrites the oldest entry (RAS_OVERFLOW = 0) or is not pushed at all 
+    (RAS_OVERFLOW = 1). The RAS is updated speculatively, so on a pipeline flush 
+    it is either kept as is (RAS_FLUSH = 0), cleared (RAS_FLUSH = 1), or repaired
+    when the ALU stage changes the PC and cleared when going to/returning from trap
+    (RAS_FLUSH = 2). For the repair, every instruction in flight up to the ALU stage
+    has a checkpoint of the top-of-stack pointer, the number of entries, and the top
+    entry right after its own update. On a misprediction these are restored from the
+    checkpoint of the mispredicted instruction, which undoes any number of wrong-path
+    calls and returns unless a wrong-path call overwrote an entry below the top entry
+    (the wrong path returned more than once before calling).
+    With compressed instructions, the BTB is indexed by the word holding the last halfword
+    of the branch/jump, and remembers which halfword it is so that only the instructions
+    up to the branch/jump are taken from the fetched word. A BTB entry that would split a
+    32-bit instruction (stale after the code changed) is invalidated and the instruction 
+    is fetched again.
+ - Dual issue: When DUAL_ISSUE is enabled (C_EXTENSION must be disabled), the instruction
+    memory returns the 64-bit doubleword at o_iaddr[31:3] so that two instructions are 
+    fetched at a time (only the upper word is used when fetching from the upper word of a 
+    jump target, and the upper word is dropped when the BTB predicts the lower word as a 
+    taken branch/jump). The BTB is looked up for both words. The prefetch queue takes up to
+    two words and gives up to two words per clock cycle. The word after the oldest one is 
+    issued together with it (o_inst1 and o_ce1) when the pair can execute in the same clock
+    cycle: the second instruction is a base ALU instruction (OP, OP-IMM, LUI, or AUIPC 
+    without M/Zb operations), the first is not a branch, jump, SYSTEM, FENCE, or atomic 
+    instruction (so at most one memory access per pair), the second does not read the rd 
+    of the first, and neither of them is predicted as a taken branch/jump.
 */
 `timescale 1ns / 1ps
 `default_nettype none
 `include "rv32i_header.vh"
 
-module rv32i_fetch #(parameter PC_RESET = 32'h00_00_00_00) (
+module rv32i_fetch #(parameter PC_RESET = 32'h00_00_00_00, BRANCH_PREDICTOR = 0, BTB_INDEX_WIDTH = 6,
+                              RAS_DEPTH = 0, RAS_OVERFLOW = 0, RAS_FLUSH = 2, 
+                              PREFETCH_DEPTH = 1, //number of entries of prefetch queue (at least 1)
+                              MAX_REQUESTS = 1, //maximum number of outstanding instruction memory requests (at most PREFETCH_DEPTH)
+                              C_EXTENSION = 0, //1 = support compressed instructions (16-bit instructions aligned on any halfword)
+                              DUAL_ISSUE = 0 //1 = fetch 64-bit doublewords and issue two instructions at a time (C_EXTENSION must be 0)
+                              ) (
     input wire i_clk,i_rst_n,
     output reg[31:0] o_iaddr, //instruction memory address
     output reg[31:0] o_pc, //PC value of current instruction 
-    input wire[31:0] i_inst, // retrieved instruction from Memory
+    input wire[(DUAL_ISSUE != 0)? 63:31 : 0] i_inst, // retrieved instruction from Memory (doubleword when DUAL_ISSUE)
     output reg[31:0] o_inst, // instruction sent to pipeline
+    output reg o_compressed, //high if o_inst is an expanded compressed instruction (next instruction is at PC+2)
+    output reg[31:0] o_inst1, //instruction at PC+4 issued together with o_inst (DUAL_ISSUE)
     output wire o_stb_inst, // request for instruction
     input wire i_ack_inst, //ack (high if new instruction is now on the bus)
     // PC Control
     input wire i_writeback_change_pc, //high when PC needs to change when going to trap or returning from trap
     input wire[31:0] i_writeback_next_pc, //next PC due to trap
-    input wire i_alu_change_pc, //high when PC needs to change for taken branches and jumps
+    input wire i_alu_change_pc, //high when PC needs to change for mispredicted branches and jumps (only when ALU stage is not stalled)
     input wire[31:0] i_alu_next_pc, //next PC due to branch or jump
+    // Branch Prediction
+    output wire o_pred_taken, //high if current instruction is predicted as a taken branch/jump
+    output wire[31:0] o_pred_pc, //predicted target address of current instruction (valid if o_pred_taken is high)
+    input wire i_alu_branch_resolved, //high when a branch/jump is resolved at ALU stage (update branch predictor)
+    input wire i_alu_branch_taken, //high if the resolved branch/jump is taken
+    input wire[31:0] i_alu_branch_target, //target address of the resolved branch/jump
+    input wire[31:0] i_alu_pc, //PC of the resolved branch/jump
+    input wire i_alu_compressed, //high if the resolved branch/jump is a compressed instruction
+    input wire i_alu_done, //high when an instruction leaves the ALU stage (releases its RAS checkpoint)
+    input wire i_decoder_branch_resolved, //high if current instruction is a branch/jump already resolved at decode stage
+    input wire i_decoder_branch_taken, //high if the branch/jump resolved at decode stage is taken
+    input wire[31:0] i_decoder_next_pc, //target address of the branch/jump resolved at decode stage
     /// Pipeline Control ///
     output reg o_ce, // output clk enable for pipeline stalling of next stage
-    input wire i_stall, //stall logic for whole pipeline
+    output reg o_ce1, //high if o_inst1 is issued together with o_inst
+    input wire i_stall, //o_inst cannot be taken by next stage (registered stall from the skid buffer of decode stage)
     input wire i_flush //flush this stage
 );
 
-    reg[31:0] iaddr_d, prev_pc, stalled_inst, stalled_pc;
-    reg ce, ce_d;
-    reg stall_fetch;
-    reg stall_q;
-    //stall this stage when:
-    //- next stages are stalled
-    //- you have request but no ack yeti
-    //- you dont have a request at all (no request then no instruction to execute for this stage)
-    wire stall_bit = stall_fetch || i_stall || (o_stb_inst && !i_ack_inst) || !o_stb_inst; 
-    assign o_stb_inst = ce; //request for new instruction if this stage is enabled                                                               
+    localparam FETCH_WORDS = (DUAL_ISSUE != 0)? 2 : 1; //number of instruction words fetched at a time
+    localparam PRED_WIDTH = 35*FETCH_WORDS; //prediction bundles of all fetched words {upper word, lower word}
+    reg[31:0] iaddr_d; //next instruction address
+    reg ce; //fetch stage enable (low only on reset)
+    //instruction requests which are waiting for ack (FIFO since acks are in the same order as requests)
+    localparam PENDING_PTR_WIDTH = (MAX_REQUESTS > 1)? $clog2(MAX_REQUESTS) : 1;
+    reg[$clog2(MAX_REQUESTS+1)-1:0] pending_requests; //number of requests waiting for ack
+    reg[$clog2(MAX_REQUESTS+1)-1:0] discard_requests; //number of oldest pending requests to be discarded when acked (PC changed while waiting)
+    reg[PENDING_PTR_WIDTH-1:0] pending_wr_ptr, pending_rd_ptr; //write pointer (new request) and read pointer (oldest request)
+    reg[31:0] pending_addr[MAX_REQUESTS-1:0]; //address of the pending requests
+    reg[PRED_WIDTH-1:0] pending_addr_pred[MAX_REQUESTS-1:0]; //prediction bundle of the pending requests
+    wire[31:0] pending_pc = pending_addr[pending_rd_ptr]; //address of the oldest pending request
+    wire[PRED_WIDTH-1:0] pending_pred = pending_addr_pred[pending_rd_ptr]; //prediction bundle of the oldest pending request
+    //prefetch queue: stores the instructions that arrive while o_inst cannot be taken by next stage
+    localparam QUEUE_PTR_WIDTH = (PREFETCH_DEPTH > 1)? $clog2(PREFETCH_DEPTH) : 1;
+    reg[31:0] queue_inst[PREFETCH_DEPTH-1:0];
+    reg[31:0] queue_pc[PREFETCH_DEPTH-1:0];
+    reg[QUEUE_PTR_WIDTH-1:0] queue_wr_ptr, queue_rd_ptr; //write pointer (push) and read pointer (oldest instruction)
+    wire[QUEUE_PTR_WIDTH-1:0] queue_wr_ptr1 = (queue_wr_ptr == PREFETCH_DEPTH-1)? 0 : queue_wr_ptr + 1'b1; //entry after queue_wr_ptr
+    wire[QUEUE_PTR_WIDTH-1:0] queue_rd_ptr1 = (queue_rd_ptr == PREFETCH_DEPTH-1)? 0 : queue_rd_ptr + 1'b1; //entry after queue_rd_ptr
+    reg[$clog2(PREFETCH_DEPTH+1)-1:0] queue_count; //number of instructions in prefetch queue
+    //branch prediction bundle {btb_upper, btb_hit, pred_taken, pred_pc} which follows the instruction address
+    //in the same way as the PC (o_iaddr -> pending_pc -> queue_pc -> o_pc). btb_upper is high if the 
+    //predicted branch/jump ends at the upper halfword of the fetched word (only the bundle of the 
+    //instruction that ends there is passed to o_pc, the other instructions are not predicted)
+    reg[PRED_WIDTH-1:0] iaddr_pred;
+    wire[PRED_WIDTH-1:0] iaddr_pred_d; //prediction bundle for iaddr_d
+    reg[33:0] inst_pred;
+    reg[34:0] queue_pred[PREFETCH_DEPTH-1:0];
+    //oldest fetched word (from prefetch queue, else from the bus) which is split into instructions
+    wire src_valid;
+    wire[31:0] src_inst, src_pc;
+    wire[34:0] src_pred;
+    //words of the acked fetch (bus_*0 is the first word, bus_*1 the upper word of a doubleword when DUAL_ISSUE)
+    wire[1:0] bus_words; //number of words of the acked fetch that must be kept
+    wire[31:0] bus_inst0, bus_pc0, bus_inst1, bus_pc1;
+    wire[34:0] bus_pred0, bus_pred1;
+    //dual issue: the word after the oldest fetched word which is issued together with it
+    wire src1_valid;
+    wire[31:0] src1_inst;
+    wire[34:0] src1_pred;
+    wire pair; //oldest fetched word is issued together with the word after it (o_inst1)
+    //aligner: the halfword left over from the previous word
+    reg half_valid; 
+    reg[15:0] half_inst;
+    reg[31:0] half_pc;
+    reg[33:0] half_pred;
+    reg align_valid; //an instruction is ready to be loaded to o_inst
+    reg[31:0] align_inst; //instruction to be loaded to o_inst (lower half only if compressed)
+    reg align_compressed; //instruction to be loaded to o_inst is compressed
+    reg[31:0] align_pc; //PC of instruction to be loaded to o_inst
+    reg[33:0] align_pred; //prediction bundle of instruction to be loaded to o_inst
+    reg align_src_pop; //oldest fetched word is consumed
+    reg align_half_load; //upper half of oldest fetched word is left over
+    reg align_half_clear; //left over halfword is consumed
+    reg align_stale; //a 32-bit instruction starts at the halfword where BTB predicted a taken branch/jump
+    reg[31:0] align_stale_pc; //address of that 32-bit instruction (to be fetched again)
+    wire[31:0] expanded_inst; //32-bit equivalent of compressed align_inst
+    wire align_change_pc; //high when PC needs to change due to a stale BTB entry
+    wire btb_upper; //high if the branch/jump in the BTB entry for iaddr_d ends at the upper halfword
+    wire btb_hit; //high if BTB has an entry for iaddr_d
+    wire btb_taken; //high if BTB predicts iaddr_d as a taken branch/jump
+    wire[31:0] btb_pc; //target address stored in BTB for iaddr_d
+    wire btb_hit1, btb_taken1; //BTB hit and prediction for the upper word of the doubleword at iaddr_d (DUAL_ISSUE)
+    wire[31:0] btb_pc1; //target address stored in BTB for the upper word
+    reg static_taken; //high if o_inst is predicted as taken by static BTFN 
+    reg[31:0] static_pc; //target address of o_inst predicted by static BTFN
+    wire ras_taken; //high if o_inst is a return predicted by the RAS
+    wire[31:0] ras_pc; //return address at top of RAS
+    wire decode_change_pc; //high when PC needs to change due to early branch resolution, RAS, or static BTFN prediction
     
+    wire stall_bit = i_stall; //o_inst cannot be taken by next stage
+    wire inst_taken = o_ce && !stall_bit; //o_inst is taken by next stage at this clock cycle
+    wire inst_valid = pending_requests != 0 && i_ack_inst && discard_requests == 0; //requested instruction is now on the bus and must be kept
+    wire[$clog2(MAX_REQUESTS+1)-1:0] live_requests = pending_requests - discard_requests; //pending requests that will be kept
+    wire inst_load = !o_ce || inst_taken; //o_inst is free at next clock cycle (load the next instruction)
+    wire[1:0] src_pops = inst_load? align_src_pop + pair : 2'd0; //number of oldest fetched words consumed by the aligner
+    wire[1:0] queue_pops = (src_pops > queue_count)? queue_count : src_pops; //number of oldest queued words consumed
+    wire[1:0] bus_pops = src_pops - queue_pops; //number of acked words consumed directly
+    wire[1:0] queue_pushes = bus_words - bus_pops; //number of acked words which can not be consumed directly
+    wire[QUEUE_PTR_WIDTH:0] queue_rd_sum = queue_rd_ptr + queue_pops;
+    wire[QUEUE_PTR_WIDTH:0] queue_wr_sum = queue_wr_ptr + queue_pushes;
+    //change PC when going to/returning from trap, when ALU stage resolves a mispredicted
+    //branch/jump, or when o_inst enters decode stage with a different next PC than the one fetched
+    wire change_pc = i_writeback_change_pc || i_alu_change_pc || decode_change_pc || align_change_pc;
+    wire flush_fetch = change_pc || (i_flush && !stall_bit); //flush all fetched instructions
+    //request for new instruction if this stage is enabled, there are less than MAX_REQUESTS requests waiting 
+    //for ack, and there is a place to store all requested words (o_inst or the left over halfword, and the prefetch queue)
+    assign o_stb_inst = ce && (pending_requests != MAX_REQUESTS || i_ack_inst) && (((o_ce && !inst_taken) || half_valid) + queue_count + FETCH_WORDS*live_requests + FETCH_WORDS - 1 <= PREFETCH_DEPTH);
+    wire[$clog2(MAX_REQUESTS+1)-1:0] pending_requests_d = pending_requests + o_stb_inst - (i_ack_inst && pending_requests != 0);
+    
+    //branches/jumps resolved at decode stage need no prediction, returns are predicted by the RAS, and 
+    //static prediction is only used for instructions the BTB has no entry for. The PC changes when the
+    //instruction leaves this stage (enters decode stage) and the prediction differs from the address 
+    //already fetched after it.
+    assign o_pred_taken = i_decoder_branch_resolved? i_decoder_branch_taken : (ras_taken || inst_pred[32] || (static_taken && !inst_pred[33]));
+    assign o_pred_pc = i_decoder_branch_resolved? i_decoder_next_pc : ras_taken? ras_pc : inst_pred[32]? inst_pred[31:0]:static_pc;
+    assign decode_change_pc = inst_taken && !i_flush && ((o_pred_taken != inst_pred[32]) || (o_pred_taken && o_pred_pc != inst_pred[31:0]));
+    assign align_change_pc = inst_load && align_stale && !i_flush && !i_writeback_change_pc && !i_alu_change_pc && !decode_change_pc;
+
     //ce logic for fetch stage
     always @(posedge i_clk, negedge i_rst_n) begin
          if(!i_rst_n) ce <= 0;
-         else if((i_alu_change_pc || i_writeback_change_pc) && !(i_stall || stall_fetch)) ce <= 0; //do pipeline bubble when need to change pc so that next stages will be disabled 
-         else ce <= 1;                                                  //and will not execute the instructions already inside the pipeline
+         else ce <= 1;
      end
 
-
-
     always @(posedge i_clk, negedge i_rst_n) begin
         if(!i_rst_n) begin
             o_ce <= 0;
             o_iaddr <= PC_RESET;
-            prev_pc <= PC_RESET;
-            stalled_inst <= 0;
             o_pc <= 0;
+            o_inst <= 0;
+            o_compressed <= 0;
+            o_ce1 <= 0;
+            o_inst1 <= 0;
+            pending_requests <= 0;
+            discard_requests <= 0;
+            pending_wr_ptr <= 0;
+            pending_rd_ptr <= 0;
+            queue_wr_ptr <= 0;
+            queue_rd_ptr <= 0;
+            queue_count <= 0;
+            iaddr_pred <= 0;
+            inst_pred <= 0;
+            half_valid <= 0;
         end
         else begin 
-            if((ce && !stall_bit) || (stall_bit && !o_ce && ce) || i_writeback_change_pc) begin //update registers only if this stage is enabled and next stages are not stalled
+            //update instruction address when a new instruction is requested or when PC needs to change
+            if(o_stb_inst || change_pc) begin
                 o_iaddr <= iaddr_d;
-                o_pc <= stall_q? stalled_pc:prev_pc;
-                o_inst <= stall_q? stalled_inst:i_inst;
+                iaddr_pred <= iaddr_pred_d; //prediction for the next instruction address 
             end
-            if(i_flush && !stall_bit) begin //flush this stage(only when not stalled) so that clock-enable of next stage is disabled at next clock cycle
+
+            //track the requests waiting for ack. All requests waiting for ack when the PC changes (including
+            //the request made at the same time) are already for the wrong path and must be discarded.
+            pending_requests <= pending_requests_d;
+            if(o_stb_inst) pending_wr_ptr <= (pending_wr_ptr == MAX_REQUESTS-1)? 0 : pending_wr_ptr + 1'b1;
+            if(i_ack_inst && pending_requests != 0) pending_rd_ptr <= (pending_rd_ptr == MAX_REQUESTS-1)? 0 : pending_rd_ptr + 1'b1;
+            if(flush_fetch) discard_requests <= pending_requests_d;
+            else if(i_ack_inst && discard_requests != 0) discard_requests <= discard_requests - 1'b1;
+
+            //flush this stage so that clock-enable of next stage is disabled at next clock cycle
+            //and all queued instructions are discarded
+            if(flush_fetch) begin
                 o_ce <= 0;
+                o_ce1 <= 0;
+                queue_wr_ptr <= 0;
+                queue_rd_ptr <= 0;
+                queue_count <= 0;
+                half_valid <= 0;
             end
-            else if(!stall_bit) begin //clock-enable will change only when not stalled
-                o_ce <= ce_d;
-            end
-            //if this stage is stalled but next stage is not, disable 
-            //clock enable of next stage at next clock cycle (pipeline bubble)
-            else if(stall_bit && !i_stall) o_ce <= 0; 
-                                                                    
-                
-            stall_q <= i_stall || stall_fetch; //raise stall when any of 5 stages is stalled
-
-            //store both instruction and PC before stalling so that we can
-            //come back to these values when we need to return from stall 
-            if(stall_bit && !stall_q) begin
-                stalled_pc <= prev_pc; 
-                stalled_inst <= i_inst; 
+            else begin
+                //o_inst is taken by next stage: replace it with the next instruction from the aligner 
+                //(oldest queued word, else the newly acked word) or create a pipeline bubble if there is none
+                if(inst_load) begin
+                    o_ce <= align_valid;
+                    o_ce1 <= pair;
+                    if(pair) o_inst1 <= src1_inst;
+                    if(align_valid) begin
+                        o_pc <= align_pc;
+                        o_inst <= align_compressed? expanded_inst : align_inst;
+                        o_compressed <= align_compressed;
+                        inst_pred <= align_pred;
+                    end
+                    if(align_half_load) begin
+                        half_valid <= 1;
+                        half_inst <= src_inst[31:16];
+                        half_pc <= {src_pc[31:2], 2'b10};
+                        half_pred <= src_pred[34]? src_pred[33:0] : 34'd0; 
+                    end
+                    else if(align_half_clear) half_valid <= 0;
+                end
+                queue_rd_ptr <= (queue_rd_sum >= PREFETCH_DEPTH)? queue_rd_sum - PREFETCH_DEPTH : queue_rd_sum;
+                //queue the newly acked words while the aligner is busy so that 
+                //we can come back to them when we return from stall
+                queue_wr_ptr <= (queue_wr_sum >= PREFETCH_DEPTH)? queue_wr_sum - PREFETCH_DEPTH : queue_wr_sum;
+                queue_count <= queue_count + queue_pushes - queue_pops;
             end
-            prev_pc <= o_iaddr; //this is the first delay to align the PC to the pipeline
         end
     end
-    // logic for PC and pipeline clock_enable control
+
+    //prefetch queue and pending requests storage
+    always @(posedge i_clk) begin
+        if(o_stb_inst) begin
+            pending_addr[pending_wr_ptr] <= o_iaddr;
+            pending_addr_pred[pending_wr_ptr] <= iaddr_pred;
+        end
+        if(queue_pushes != 0) begin
+            queue_pc[queue_wr_ptr] <= (bus_pops != 0)? bus_pc1 : bus_pc0;
+            queue_inst[queue_wr_ptr] <= (bus_pops != 0)? bus_inst1 : bus_inst0;
+            queue_pred[queue_wr_ptr] <= (bus_pops != 0)? bus_pred1 : bus_pred0;
+        end
+        if(queue_pushes == 2) begin
+            queue_pc[queue_wr_ptr1] <= bus_pc1;
+            queue_inst[queue_wr_ptr1] <= bus_inst1;
+            queue_pred[queue_wr_ptr1] <= bus_pred1;
+        end
+    end
+    // logic for next PC
     always @* begin
         iaddr_d = 0;
-        ce_d = 0;
-        stall_fetch = i_stall; //stall when retrieving instructions need wait time
-        //prepare next PC when changing pc, then do a pipeline bubble
-        //to disable the ce of next stage
-        if(i_writeback_change_pc) begin
-            iaddr_d = i_writeback_next_pc;
-            ce_d = 0;
+        //prepare next PC when changing pc
+        if(i_writeback_change_pc) iaddr_d = i_writeback_next_pc;
+        else if(i_alu_change_pc) iaddr_d  = i_alu_next_pc;
+        else if(decode_change_pc) iaddr_d = o_pred_taken? o_pred_pc : o_pc + (o_compressed? 32'd2 : 32'd4);
+        else if(align_change_pc) iaddr_d = align_stale_pc;
+        else if(iaddr_pred[32]) iaddr_d = iaddr_pred[31:0]; //follow the BTB if it predicts a taken branch/jump
+        else if(iaddr_pred[PRED_WIDTH-3]) iaddr_d = iaddr_pred[PRED_WIDTH-4:PRED_WIDTH-35]; //taken branch/jump at the upper word (DUAL_ISSUE)
+        else iaddr_d = ({o_iaddr[31:2], 2'b00} & ~(4*FETCH_WORDS - 1)) + 4*FETCH_WORDS;
+    end
+
+    // Aligner: split the oldest fetched word into instructions. A word is consumed when its last
+    // halfword is either taken by an instruction or left over, and everything after the halfword
+    // where the BTB predicts a taken branch/jump (src_pred[32]) is dropped since the next word 
+    // comes from the predicted target.
+    assign src_valid = queue_count != 0 || inst_valid;
+    assign src_inst = (queue_count != 0)? queue_inst[queue_rd_ptr] : bus_inst0;
+    assign src_pc = (queue_count != 0)? queue_pc[queue_rd_ptr] : bus_pc0;
+    assign src_pred = (queue_count != 0)? queue_pred[queue_rd_ptr] : bus_pred0;
+    wire half_compressed = C_EXTENSION != 0 && half_inst[1:0] != 2'b11; //left over halfword is a compressed instruction
+    wire lower_compressed = C_EXTENSION != 0 && src_inst[1:0] != 2'b11; //lower halfword of word is a compressed instruction
+    wire upper_compressed = C_EXTENSION != 0 && src_inst[17:16] != 2'b11; //upper halfword of word is a compressed instruction
+    wire upper_start = C_EXTENSION != 0 && src_pc[1]; //word was fetched from its upper halfword (jump target)
+    wire lower_jump = src_pred[32] && !src_pred[34]; //predicted taken branch/jump ends at lower halfword
+    always @* begin
+        align_valid = 0;
+        align_inst = src_inst;
+        align_compressed = 0;
+        align_pc = src_pc;
+        align_pred = 0;
+        align_src_pop = 0;
+        align_half_load = 0;
+        align_half_clear = 0;
+        align_stale = 0;
+        align_stale_pc = src_pc;
+        if(half_valid) begin
+            if(half_compressed) begin //left over halfword is a whole instruction
+                align_valid = 1;
+                align_inst = {16'b0, half_inst};
+                align_compressed = 1;
+                align_pc = half_pc;
+                align_pred = half_pred;
+                align_half_clear = 1;
+            end
+            else if(half_pred[32]) begin //32-bit instruction can not start at the end of the fetched path
+                align_stale = 1;
+                align_stale_pc = half_pc;
+            end
+            else if(src_valid) begin //join with lower half of next word
+                align_valid = 1;
+                align_inst = {src_inst[15:0], half_inst};
+                align_pc = half_pc;
+                align_pred = (src_pred[33] && !src_pred[34])? src_pred[33:0] : 34'd0;
+                align_src_pop = 1;
+                align_half_load = !lower_jump; 
+                align_half_clear = lower_jump;
+            end
         end
-        else if(i_alu_change_pc) begin
-            iaddr_d  = i_alu_next_pc;
-            ce_d = 0;
+        else if(src_valid) begin
+            align_src_pop = 1;
+            if(upper_start) begin
+                if(upper_compressed) begin
+                    align_valid = 1;
+                    align_inst = {16'b0, src_inst[31:16]};
+                    align_compressed = 1;
+                    align_pred = src_pred[33:0];
+                end
+                else align_half_load = 1; //wait for the upper half from the next word
+            end
+            else if(lower_compressed) begin
+                align_valid = 1;
+                align_inst = {16'b0, src_inst[15:0]};
+                align_compressed = 1;
+                align_pred = (src_pred[33] && !src_pred[34])? src_pred[33:0] : 34'd0;
+                align_half_load = !lower_jump;
+            end
+            else if(lower_jump) begin //32-bit instruction can not start at the end of the fetched path
+                align_src_pop = 0;
+                align_stale = 1;
+            end
+            else begin
+                align_valid = 1;
+                align_pred = src_pred[34]? src_pred[33:0] : 34'd0;
+            end
         end
-        else begin
-            iaddr_d = o_iaddr + 32'd4;
-            ce_d = ce;
+    end
+
+    // Acked fetch: a single word, or a doubleword (DUAL_ISSUE) whose lower word is skipped when fetched
+    // from the upper word (jump target) and whose upper word is dropped when the lower word is predicted
+    // as a taken branch/jump (the next fetch is from the predicted target)
+    if(DUAL_ISSUE != 0) begin: dual
+        wire upper_only = pending_pc[2]; //doubleword was fetched from its upper word
+        assign bus_words = !inst_valid? 2'd0 : (upper_only || pending_pred[32])? 2'd1 : 2'd2;
+        assign bus_inst0 = upper_only? i_inst[63:32] : i_inst[31:0];
+        assign bus_pc0 = pending_pc;
+        assign bus_pred0 = upper_only? pending_pred[69:35] : pending_pred[34:0];
+        assign bus_inst1 = i_inst[63:32];
+        assign bus_pc1 = {pending_pc[31:3], 3'b100};
+        assign bus_pred1 = pending_pred[69:35];
+        //prediction bundle of both words at iaddr_d (none for the lower word when fetching from the upper word)
+        assign iaddr_pred_d = {1'b1, btb_hit1, btb_taken1, btb_pc1, iaddr_d[2]? 35'd0 : {btb_upper, btb_hit, btb_taken, btb_pc}};
+
+        // Pairing: the word after the oldest fetched word is issued together with it when it is a base
+        // ALU instruction which does not depend on it, and the oldest one does not change the control flow
+        // nor use the data memory port along with another instruction in the pair
+        wire[6:0] opcode0 = src_inst[6:0];
+        wire[6:0] opcode1 = src1_inst[6:0];
+        wire[2:0] funct3_1 = src1_inst[14:12];
+        wire[6:0] funct7_1 = src1_inst[31:25];
+        wire rtype1 = opcode1 == `OPCODE_RTYPE && (funct7_1 == 7'b0000000 || (funct7_1 == 7'b0100000 && (funct3_1 == 3'b000 || funct3_1 == 3'b101))); //base R-type (no M/Zb)
+        wire itype1 = opcode1 == `OPCODE_ITYPE && (funct3_1[1:0] != 2'b01 || funct7_1 == 7'b0000000 || (funct3_1 == 3'b101 && funct7_1 == 7'b0100000)); //base I-type (no Zb)
+        wire second_ok = rtype1 || itype1 || opcode1 == `OPCODE_LUI || opcode1 == `OPCODE_AUIPC;
+        wire first_ok = opcode0 != `OPCODE_BRANCH && opcode0 != `OPCODE_JAL && opcode0 != `OPCODE_JALR && opcode0 != `OPCODE_SYSTEM && opcode0 != `OPCODE_FENCE && opcode0 != `OPCODE_AMO;
+        wire dependent = opcode0 != `OPCODE_STORE && src_inst[11:7] != 0 && //second instruction reads rd of the first
+                         (((rtype1 || itype1) && src1_inst[19:15] == src_inst[11:7]) || (rtype1 && src1_inst[24:20] == src_inst[11:7]));
+
+        assign src1_valid = queue_count + bus_words >= 2;
+        assign src1_inst = (queue_count >= 2)? queue_inst[queue_rd_ptr1] : (queue_count == 1)? bus_inst0 : bus_inst1;
+        assign src1_pred = (queue_count >= 2)? queue_pred[queue_rd_ptr1] : (queue_count == 1)? bus_pred0 : bus_pred1;
+        assign pair = align_valid && src1_valid && first_ok && second_ok && !dependent && !src_pred[32] && !src1_pred[32];
+    end
+    else begin: dual
+        assign bus_words = {1'b0, inst_valid};
+        assign bus_inst0 = i_inst;
+        assign bus_pc0 = pending_pc;
+        assign bus_pred0 = pending_pred;
+        assign bus_inst1 = 0;
+        assign bus_pc1 = 0;
+        assign bus_pred1 = 0;
+        assign iaddr_pred_d = {btb_upper, btb_hit, btb_taken, btb_pc};
+        assign src1_valid = 0;
+        assign src1_inst = 0;
+        assign src1_pred = 0;
+        assign pair = 0;
+    end
+
+    //compressed instructions are expanded before entering the decode stage
+    if(C_EXTENSION != 0) begin: rvc
+        rv32i_expander m0(
+            .i_inst(align_inst[15:0]), //16-bit compressed instruction
+            .o_inst(expanded_inst) //equivalent 32-bit instruction
+        );
+    end
+    else begin: rvc
+        assign expanded_inst = 0;
+    end
+
+    // Static BTFN prediction: backward branches (negative offset) and JAL are predicted as taken
+    always @* begin
+        static_taken = 0;
+        static_pc = 0;
+        if(BRANCH_PREDICTOR != 0) begin
+            if(o_inst[6:0] == `OPCODE_BRANCH) begin
+                static_taken = o_inst[31]; //sign bit of offset
+                static_pc = o_pc + {{19{o_inst[31]}},o_inst[31],o_inst[7],o_inst[30:25],o_inst[11:8],1'b0};
+            end
+            else if(o_inst[6:0] == `OPCODE_JAL) begin
+                static_taken = 1;
+                static_pc = o_pc + {{11{o_inst[31]}},o_inst[31],o_inst[19:12],o_inst[20],o_inst[30:21],1'b0};
+            end
         end
     end
+
+    // Return Address Stack: circular buffer where ras_ptr points to the top entry
+    if(RAS_DEPTH != 0) begin: ras
+        localparam RAS_PTR_WIDTH = $clog2(RAS_DEPTH);
+        localparam CHECKPOINTS = 4; //instructions in flight between this stage and the end of ALU stage (skid buffer, decode, operand, ALU)
+        reg[31:0] ras_stack[RAS_DEPTH-1:0];
+        reg[RAS_PTR_WIDTH-1:0] ras_ptr; //index of top entry
+        reg[RAS_PTR_WIDTH:0] ras_count; //number of valid entries
+        //checkpoint {ras_count, ras_ptr, top entry} after the update made by each instruction in flight (FIFO
+        //in program order, released when the instruction leaves the ALU stage) used to repair the RAS
+        reg[RAS_PTR_WIDTH*2+32:0] ckpt[CHECKPOINTS-1:0];
+        reg[$clog2(CHECKPOINTS)-1:0] ckpt_wr_ptr, ckpt_rd_ptr;
+        reg[RAS_PTR_WIDTH*2+32:0] ckpt_done; //checkpoint of the last instruction that left the ALU stage
+        wire link_rd = o_inst[11:7] == 5'd1 || o_inst[11:7] == 5'd5; //rd is x1(ra) or x5(t0)
+        wire link_rs1 = o_inst[19:15] == 5'd1 || o_inst[19:15] == 5'd5; //rs1 is x1(ra) or x5(t0)
+        wire call = (o_inst[6:0] == `OPCODE_JAL || o_inst[6:0] == `OPCODE_JALR) && link_rd;
+        wire ret = o_inst[6:0] == `OPCODE_JALR && link_rs1 && !link_rd;
+        wire push = call && !(RAS_OVERFLOW == 1 && ras_count == RAS_DEPTH);
+        wire pop = ret && ras_count != 0;
+        wire update = inst_taken && !i_flush; //instruction leaves this stage
+        wire[RAS_PTR_WIDTH-1:0] push_ptr = ras_ptr + 1'b1;
+        wire[RAS_PTR_WIDTH-1:0] pop_ptr = ras_ptr - 1'b1;
+        wire[31:0] return_pc = o_pc + (o_compressed? 32'd2 : 32'd4); //return address pushed by a call
+        //RAS state after the update of the instruction leaving this stage
+        wire[RAS_PTR_WIDTH*2+32:0] ckpt_d = push? {(ras_count != RAS_DEPTH)? ras_count + 1'b1 : ras_count, push_ptr, return_pc} :
+                                            pop? {ras_count - 1'b1, pop_ptr, ras_stack[pop_ptr]} : {ras_count, ras_ptr, ras_stack[ras_ptr]};
+        //the mispredicted instruction is either leaving the ALU stage right now (oldest checkpoint) or already
+        //left it (registered misprediction of ALU stage)
+        wire[RAS_PTR_WIDTH*2+32:0] ckpt_restore = i_alu_done? ckpt[ckpt_rd_ptr] : ckpt_done;
+
+        assign ras_taken = pop;
+        assign ras_pc = ras_stack[ras_ptr];
+
+        always @(posedge i_clk, negedge i_rst_n) begin
+            if(!i_rst_n) begin
+                ras_ptr <= 0;
+                ras_count <= 0;
+                ckpt_wr_ptr <= 0;
+                ckpt_rd_ptr <= 0;
+            end
+            else begin
+                if(i_writeback_change_pc || (RAS_FLUSH == 1 && i_flush)) begin //clear RAS
+                    ras_count <= 0;
+                end
+                else if(RAS_FLUSH == 2 && i_alu_change_pc) begin //restore RAS state right after the mispredicted instruction
+                    ras_count <= ckpt_restore[RAS_PTR_WIDTH+32 +: RAS_PTR_WIDTH+1];
+                    ras_ptr <= ckpt_restore[32 +: RAS_PTR_WIDTH];
+                end
+                else if(update) begin
+                    ras_count <= ckpt_d[RAS_PTR_WIDTH+32 +: RAS_PTR_WIDTH+1];
+                    ras_ptr <= ckpt_d[32 +: RAS_PTR_WIDTH];
+                end
+
+                //instructions in flight are discarded on a flush (the instruction leaving the ALU stage on
+                //an ALU misprediction is the one the RAS is restored to)
+                if(i_flush || i_alu_change_pc || i_writeback_change_pc) begin
+                    ckpt_wr_ptr <= 0;
+                    ckpt_rd_ptr <= 0;
+                end
+                else begin
+                    if(update) ckpt_wr_ptr <= ckpt_wr_ptr + 1'b1;
+                    if(i_alu_done) ckpt_rd_ptr <= ckpt_rd_ptr + 1'b1;
+                end
+            end
+        end
+
+        always @(posedge i_clk) begin
+            if(RAS_FLUSH == 2 && i_alu_change_pc && !i_writeback_change_pc) ras_stack[ckpt_restore[32 +: RAS_PTR_WIDTH]] <= ckpt_restore[31:0]; //top entry may be overwritten by wrong-path calls
+            else if(update && push && !i_writeback_change_pc) ras_stack[push_ptr] <= return_pc;
+            if(update) ckpt[ckpt_wr_ptr] <= ckpt_d;
+            if(i_alu_done) ckpt_done <= ckpt[ckpt_rd_ptr];
+        end
+    end
+    else begin: ras
+        assign ras_taken = 0;
+        assign ras_pc = 0;
+    end
+
+    // Dynamic prediction: Branch Target Buffer with 2-bit saturating counters (00 = strongly not-taken,
+    // 01 = weakly not-taken, 10 = weakly taken, 11 = strongly taken). Looked up using the next instruction
+    // address (iaddr_d) so the prediction is ready when that address is requested. Updated by the ALU stage.
+    if(BRANCH_PREDICTOR == 2) begin: btb
+        reg[(1<<BTB_INDEX_WIDTH)-1:0] btb_valid; //high if BTB entry is valid
+        reg[29-BTB_INDEX_WIDTH:0] btb_tag[(1<<BTB_INDEX_WIDTH)-1:0]; //upper bits of the branch address
+        reg[30:0] btb_target[(1<<BTB_INDEX_WIDTH)-1:0]; //target address of the branch (halfword address)
+        reg[1:0] btb_counter[(1<<BTB_INDEX_WIDTH)-1:0]; //2-bit saturating counter
+        reg[(1<<BTB_INDEX_WIDTH)-1:0] btb_end; //high if the branch ends at the upper halfword of the word
+        //the branch is stored at the address of its last halfword 
+        wire[31:0] alu_end_pc = (C_EXTENSION != 0 && i_alu_compressed)? i_alu_pc : i_alu_pc + 32'd2;
+        wire alu_end = C_EXTENSION == 0 || alu_end_pc[1];
+        wire[BTB_INDEX_WIDTH-1:0] rd_index = iaddr_d[BTB_INDEX_WIDTH+1:2];
+        wire[BTB_INDEX_WIDTH-1:0] rd_index1 = {iaddr_d[BTB_INDEX_WIDTH+1:3], 1'b1}; //upper word of the doubleword at iaddr_d (DUAL_ISSUE)
+        wire[BTB_INDEX_WIDTH-1:0] wr_index = alu_end_pc[BTB_INDEX_WIDTH+1:2];
+        wire wr_hit = btb_valid[wr_index] && btb_tag[wr_index] == alu_end_pc[31:BTB_INDEX_WIDTH+2] && btb_end[wr_index] == alu_end;
+
+        //no prediction if fetching from the upper halfword past the branch, or if the entry is stale
+        assign btb_hit = btb_valid[rd_index] && btb_tag[rd_index] == iaddr_d[31:BTB_INDEX_WIDTH+2] && (btb_end[rd_index] || !iaddr_d[1]) && !align_change_pc;
+        assign btb_upper = btb_end[rd_index];
+        assign btb_taken = btb_hit && btb_counter[rd_index][1];
+        assign btb_pc = {btb_target[rd_index], 1'b0};
+        assign btb_hit1 = btb_valid[rd_index1] && btb_tag[rd_index1] == iaddr_d[31:BTB_INDEX_WIDTH+2]; //second read port (removed by synthesis when DUAL_ISSUE is disabled)
+        assign btb_taken1 = btb_hit1 && btb_counter[rd_index1][1];
+        assign btb_pc1 = {btb_target[rd_index1], 1'b0};
+
+        always @(posedge i_clk, negedge i_rst_n) begin
+            if(!i_rst_n) btb_valid <= 0;
+            else if(i_alu_branch_resolved && i_alu_branch_taken) btb_valid[wr_index] <= 1'b1; //allocate entry for taken branches/jumps
+            else if(align_change_pc) btb_valid[rd_index] <= 1'b0; //remove stale entry 
+        end
+
+        always @(posedge i_clk) begin
+            if(i_alu_branch_resolved) begin
+                if(i_alu_branch_taken) begin
+                    btb_tag[wr_index] <= alu_end_pc[31:BTB_INDEX_WIDTH+2];
+                    btb_end[wr_index] <= alu_end;
+                    btb_target[wr_index] <= i_alu_branch_target[31:1];
+                    if(!wr_hit) btb_counter[wr_index] <= 2'b10; //new entry starts as weakly taken
+                    else if(btb_counter[wr_index] != 2'b11) btb_counter[wr_index] <= btb_counter[wr_index] + 1'b1;
+                end
+                else if(wr_hit && btb_counter[wr_index] != 2'b00) btb_counter[wr_index] <= btb_counter[wr_index] - 1'b1;
+            end
+        end
+    end
+    else begin: btb
+        assign btb_hit = 0;
+        assign btb_upper = 1;
+        assign btb_taken = 0;
+        assign btb_pc = 0;
+        assign btb_hit1 = 0;
+        assign btb_taken1 = 0;
+        assign btb_pc1 = 0;
+    end
     
 endmodule
 
@@ -14,23 +14,37 @@ functionalities of the rv32i_forwarding module include:
     i_memoryaccess_rd_addr).
  - Operand forwarding for rs1:If the next value of rs1 is in stage 4 (Memory Access), 
     and the Memory Access stage is enabled and if the next value of rs1 comes from a
-    load or CSR instruction (i.e., rd is not valid at stage 4), the module stalls the
-    ALU stage by asserting o_alu_force_stall. Otherwise, the module forwards the value
-    of rd from stage 4 (i_alu_rd) to o_rs1. If the next value of rs1 is in stage 5 
+    load instruction (i.e., rd is not valid at stage 4), the module stalls the
+    ALU stage by asserting o_alu_force_stall. The stall only lasts until
+    the load data is acknowledged since the aligned load data is then forwarded
+    directly from the data bus (i_memoryaccess_data_load_bypass). The value of a CSR
+    instruction is read by rv32i_csr at stage 4 and forwarded without stall (i_csr_data).
+    Otherwise, the module forwards the value of rd from stage 4 (i_alu_rd) to o_rs1. If the next value of rs1 is in stage 5 
     (Writeback), and the Writeback stage is enabled, the module forwards the value of
     rd from stage 5 (i_writeback_rd) to o_rs1.
  - Operand forwarding for rs2: If the next value of rs2 is in stage 4 (Memory Access),
     and the Memory Access stage is enabled and if the next value of rs2 comes from a 
-    load or CSR instruction (i.e., rd is not yet valid at stage 4), the module stalls 
-    the ALU stage by asserting o_alu_force_stall. Otherwise, the module forwards the
+    load instruction (i.e., rd is not yet valid at stage 4), the module stalls 
+    the ALU stage by asserting o_alu_force_stall (CSR values are forwarded from
+    i_csr_data like for rs1). Otherwise, the module forwards the
     value of rd from stage 4 (i_alu_rd) to o_rs2. If the next value of rs2 is in stage
     5 (Writeback), and the Writeback stage is enabled, the module forwards the value
     of rd from stage 5 (i_writeback_rd) to o_rs2.
  - Handling zero register (x0) forwarding: The module ensures that no operation 
     forwarding is performed when the register address is zero, as this register is
     hardwired to zero. If either i_decoder_rs1_addr_q or i_decoder_rs2_addr_q is zero,
-    the corresponding output register (o_rs1 or o_rs2) is set to zero. By implementing
-    operand forwarding, the rv32i_forwarding module helps to mitigate data hazards,
+    the corresponding output register (o_rs1 or o_rs2) is set to zero.
+ - Operand forwarding for decode stage: For early branch resolution, the operands of
+    the instruction at decode stage (i_decoder_rs1_addr and i_decoder_rs2_addr) are 
+    forwarded the same way from stage 4 and stage 5 (o_decoder_rs1 and o_decoder_rs2).
+    The operands are not yet available (o_decoder_rs_valid is low) if the next value
+    comes from the instruction at stage 3 (ALU), or from a load instruction at
+    stage 4. The branch is then resolved at the ALU stage as usual.
+ - Dual issue: The instruction issued together with the one at each stage (second
+    issue slot, always an ALU instruction so its rd is already valid at stage 4) is 
+    younger, so its rd (i_alu_slot1_rd and i_writeback_slot1_rd) is forwarded before 
+    the rd of the first slot at the same stage. The module is instantiated once more 
+    for the operands of the second issue slot. By implementing operand forwarding, the rv32i_forwarding module helps to mitigate data hazards,
     ensuring the correct execution of instructions and improving the overall efficiency
     of the RV32I pipelined processor.
 */
@@ -52,12 +66,36 @@ module rv32i_forwarding (
     input wire i_alu_wr_rd, //high if rd_addr will be written
     input wire i_alu_rd_valid, //high if rd is already valid at this stage (not LOAD nor CSR instruction)
     input wire[31:0] i_alu_rd, //rd value in stage 4
+    input wire i_alu_csr, //high if instruction at stage 4 is a CSR instruction
+    input wire[31:0] i_csr_data, //CSR value read at stage 4 (rd of the CSR instruction)
     input wire i_memoryaccess_ce, //high if stage 4 is enabled
+    input wire[31:0] i_memoryaccess_data_load_bypass, //load data in stage 4 that is still on the data bus
+    input wire i_memoryaccess_data_load_bypass_valid, //high if load data is acknowledged at this clock cycle
     // Stage 5 [WRITEBACK]
     input wire[4:0] i_memoryaccess_rd_addr, //destination register address
     input wire i_memoryaccess_wr_rd, //high if rd_addr will be written
     input wire[31:0] i_writeback_rd, //rd value in stage 5
-    input wire i_writeback_ce //high if stage 4 is enabled
+    input wire i_writeback_ce, //high if stage 4 is enabled
+    // Second issue slot (dual issue)
+    input wire[4:0] i_alu_slot1_rd_addr, //destination register address at stage 4
+    input wire i_alu_slot1_wr_rd, //high if rd_addr at stage 4 will be written
+    input wire[31:0] i_alu_slot1_rd, //rd value in stage 4
+    input wire[4:0] i_memoryaccess_slot1_rd_addr, //destination register address at stage 5
+    input wire i_memoryaccess_slot1_wr_rd, //high if rd_addr at stage 5 will be written
+    input wire[31:0] i_writeback_slot1_rd, //rd value in stage 5
+    input wire[4:0] i_decoder_slot1_rd_addr, //destination register address at stage 3
+    input wire i_alu_slot1_ce, //high if second issue slot at stage 3 is enabled
+    // Stage 2 [DECODE]
+    input wire[31:0] i_decoder_rs1_orig, //current rs1 value saved in basereg (read at decode stage)
+    input wire[31:0] i_decoder_rs2_orig, //current rs2 value saved in basereg (read at decode stage)
+    input wire[4:0] i_decoder_rs1_addr, //address of operand rs1 used in decode stage
+    input wire[4:0] i_decoder_rs2_addr, //address of operand rs2 used in decode stage
+    output reg[31:0] o_decoder_rs1, //rs1 value at decode stage with Operand Forwarding
+    output reg[31:0] o_decoder_rs2, //rs2 value at decode stage with Operand Forwarding
+    output reg o_decoder_rs_valid, //high if both o_decoder_rs1 and o_decoder_rs2 are already the most updated value
+    // Stage 3 [ALU]
+    input wire[4:0] i_decoder_rd_addr, //destination register address
+    input wire i_alu_ce //high if stage 3 is enabled
 );
 
     always @* begin
@@ -69,22 +107,46 @@ module rv32i_forwarding (
         // The solution to make sure the updated value of rs1 or rs2 is used is to either stall the pipeline until the basereg is updated (very inefficient) or use Operand Forwarding
 
             // Operand Forwarding for rs1
-            if((i_decoder_rs1_addr_q == i_alu_rd_addr) && i_alu_wr_rd && i_memoryaccess_ce) begin //next value of rs1 is currently on stage 4
-                if(!i_alu_rd_valid) begin   //if next value of rs1 comes from load or CSR instruction then we must stall from ALU stage and wait until 
-                    o_alu_force_stall = 1;   //stage 4(Memoryaccess) becomes disabled, which means next value of rs1 is already at stage 5   
-                end
+            if((i_decoder_rs1_addr_q == i_alu_slot1_rd_addr) && i_alu_slot1_wr_rd && i_memoryaccess_ce) begin //next value of rs1 is currently on second issue slot of stage 4
+                o_rs1 = i_alu_slot1_rd;
+            end
+            else if((i_decoder_rs1_addr_q == i_alu_rd_addr) && i_alu_wr_rd && i_memoryaccess_ce) begin //next value of rs1 is currently on stage 4
                 o_rs1 = i_alu_rd;
+                if(i_memoryaccess_data_load_bypass_valid) begin //next value of rs1 is the load data currently on the data bus
+                    o_rs1 = i_memoryaccess_data_load_bypass;
+                end
+                else if(i_alu_csr) begin //next value of rs1 is the CSR value read at stage 4
+                    o_rs1 = i_csr_data;
+                end
+                else if(!i_alu_rd_valid) begin   //if next value of rs1 comes from load instruction then we must stall from ALU stage and wait until 
+                    o_alu_force_stall = 1;   //load data is acknowledged or stage 4(Memoryaccess) becomes disabled, which means next value of rs1 is already at stage 5   
+                end
+            end
+            else if((i_decoder_rs1_addr_q == i_memoryaccess_slot1_rd_addr) && i_memoryaccess_slot1_wr_rd && i_writeback_ce) begin //next value of rs1 is currently on second issue slot of stage 5
+                o_rs1 = i_writeback_slot1_rd;
             end
             else if((i_decoder_rs1_addr_q == i_memoryaccess_rd_addr) && i_memoryaccess_wr_rd && i_writeback_ce) begin //next value of rs1 is currently on stage 5
                 o_rs1 = i_writeback_rd;
             end
             
             // Operand Forwarding for rs2
-            if((i_decoder_rs2_addr_q == i_alu_rd_addr) && i_alu_wr_rd && i_memoryaccess_ce) begin //next value of rs2 is currently on stage 4
-                if(!i_alu_rd_valid) begin   //if next value of rs2 comes from load or CSR instruction(rd is only available at stage 5) then we must stall from ALU stage and wait until 
-                    o_alu_force_stall = 1;   //stage 4(Memoryaccess) becomes disabled (which implicitly means that next value of rs2 is already at stage 5)   
-                end
+            if((i_decoder_rs2_addr_q == i_alu_slot1_rd_addr) && i_alu_slot1_wr_rd && i_memoryaccess_ce) begin //next value of rs2 is currently on second issue slot of stage 4
+                o_rs2 = i_alu_slot1_rd;
+            end
+            else if((i_decoder_rs2_addr_q == i_alu_rd_addr) && i_alu_wr_rd && i_memoryaccess_ce) begin //next value of rs2 is currently on stage 4
                 o_rs2 = i_alu_rd;
+                if(i_memoryaccess_data_load_bypass_valid) begin //next value of rs2 is the load data currently on the data bus
+                    o_rs2 = i_memoryaccess_data_load_bypass;
+                end
+                else if(i_alu_csr) begin //next value of rs2 is the CSR value read at stage 4
+                    o_rs2 = i_csr_data;
+                end
+                else if(!i_alu_rd_valid) begin   //if next value of rs2 comes from load instruction(rd is only available at stage 5) then we must stall from ALU stage and wait until 
+                    o_alu_force_stall = 1;   //load data is acknowledged or stage 4(Memoryaccess) becomes disabled (which implicitly means that next value of rs2 is already at stage 5)   
+                end
+            end
+            else if((i_decoder_rs2_addr_q == i_memoryaccess_slot1_rd_addr) && i_memoryaccess_slot1_wr_rd && i_writeback_ce) begin //next value of rs2 is currently on second issue slot of stage 5
+                o_rs2 = i_writeback_slot1_rd;
             end
             else if((i_decoder_rs2_addr_q == i_memoryaccess_rd_addr) && i_memoryaccess_wr_rd && i_writeback_ce) begin //next value of rs2 is currently on stage 5
                 o_rs2 = i_writeback_rd;
@@ -95,4 +157,51 @@ module rv32i_forwarding (
             if(i_decoder_rs2_addr_q == 0) o_rs2 = 0;
     end
 
+    //Operand Forwarding for decode stage (early branch resolution)
+    always @* begin
+        o_decoder_rs1 = i_decoder_rs1_orig; //original value from basereg
+        o_decoder_rs2 = i_decoder_rs2_orig; //original value from basereg
+        o_decoder_rs_valid = 1;
+
+            // Operand Forwarding for rs1
+            if(((i_decoder_rs1_addr == i_decoder_rd_addr) && i_alu_ce) || ((i_decoder_rs1_addr == i_decoder_slot1_rd_addr) && i_alu_slot1_ce)) begin //next value of rs1 is currently on stage 3 (not yet computed)
+                if(i_decoder_rs1_addr != 0) o_decoder_rs_valid = 0;
+            end
+            else if((i_decoder_rs1_addr == i_alu_slot1_rd_addr) && i_alu_slot1_wr_rd && i_memoryaccess_ce) begin //next value of rs1 is currently on second issue slot of stage 4
+                o_decoder_rs1 = i_alu_slot1_rd;
+            end
+            else if((i_decoder_rs1_addr == i_alu_rd_addr) && i_alu_wr_rd && i_memoryaccess_ce) begin //next value of rs1 is currently on stage 4
+                if(!i_alu_rd_valid && !i_alu_csr) o_decoder_rs_valid = 0; //next value of rs1 comes from load instruction
+                o_decoder_rs1 = i_alu_csr? i_csr_data : i_alu_rd;
+            end
+            else if((i_decoder_rs1_addr == i_memoryaccess_slot1_rd_addr) && i_memoryaccess_slot1_wr_rd && i_writeback_ce) begin //next value of rs1 is currently on second issue slot of stage 5
+                o_decoder_rs1 = i_writeback_slot1_rd;
+            end
+            else if((i_decoder_rs1_addr == i_memoryaccess_rd_addr) && i_memoryaccess_wr_rd && i_writeback_ce) begin //next value of rs1 is currently on stage 5
+                o_decoder_rs1 = i_writeback_rd;
+            end
+
+            // Operand Forwarding for rs2
+            if(((i_decoder_rs2_addr == i_decoder_rd_addr) && i_alu_ce) || ((i_decoder_rs2_addr == i_decoder_slot1_rd_addr) && i_alu_slot1_ce)) begin //next value of rs2 is currently on stage 3 (not yet computed)
+                if(i_decoder_rs2_addr != 0) o_decoder_rs_valid = 0;
+            end
+            else if((i_decoder_rs2_addr == i_alu_slot1_rd_addr) && i_alu_slot1_wr_rd && i_memoryaccess_ce) begin //next value of rs2 is currently on second issue slot of stage 4
+                o_decoder_rs2 = i_alu_slot1_rd;
+            end
+            else if((i_decoder_rs2_addr == i_alu_rd_addr) && i_alu_wr_rd && i_memoryaccess_ce) begin //next value of rs2 is currently on stage 4
+                if(!i_alu_rd_valid && !i_alu_csr) o_decoder_rs_valid = 0; //next value of rs2 comes from load instruction
+                o_decoder_rs2 = i_alu_csr? i_csr_data : i_alu_rd;
+            end
+            else if((i_decoder_rs2_addr == i_memoryaccess_slot1_rd_addr) && i_memoryaccess_slot1_wr_rd && i_writeback_ce) begin //next value of rs2 is currently on second issue slot of stage 5
+                o_decoder_rs2 = i_writeback_slot1_rd;
+            end
+            else if((i_decoder_rs2_addr == i_memoryaccess_rd_addr) && i_memoryaccess_wr_rd && i_writeback_ce) begin //next value of rs2 is currently on stage 5
+                o_decoder_rs2 = i_writeback_rd;
+            end
+
+            // No operation forwarding necessary when addr is zero since that address is hardwired to zero
+            if(i_decoder_rs1_addr == 0) o_decoder_rs1 = 0;
+            if(i_decoder_rs2_addr == 0) o_decoder_rs2 = 0;
+    end
+
 endmodule
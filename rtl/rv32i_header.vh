@@ -1,4 +1,4 @@
-`define ALU_WIDTH 14
+`define ALU_WIDTH 42
 `define ADD 0
 `define SUB 1
 `define SLT 2
@@ -13,8 +13,36 @@
 `define NEQ 11
 `define GE 12
 `define GEU 13
+`define MUL 14
+`define MULH 15
+`define MULHSU 16
+`define MULHU 17
+`define DIV 18
+`define DIVU 19
+`define REM 20
+`define REMU 21
+`define SH1ADD 22
+`define SH2ADD 23
+`define SH3ADD 24
+`define ANDN 25
+`define ORN 26
+`define XNOR 27
+`define CLZ 28
+`define CTZ 29
+`define CPOP 30
+`define MIN 31
+`define MINU 32
+`define MAX 33
+`define MAXU 34
+`define SEXTB 35
+`define SEXTH 36
+`define ZEXTH 37
+`define ROL 38
+`define ROR 39
+`define ORCB 40
+`define REV8 41
 
-`define OPCODE_WIDTH 11
+`define OPCODE_WIDTH 13
 `define RTYPE 0
 `define ITYPE 1
 `define LOAD 2
@@ -26,12 +54,15 @@
 `define AUIPC 8
 `define SYSTEM 9
 `define FENCE 10
+`define AMO 11
+`define CUSTOM 12
 
-`define EXCEPTION_WIDTH 4
+`define EXCEPTION_WIDTH 5
 `define ILLEGAL 0
 `define ECALL 1
 `define EBREAK 2
 `define MRET 3
+`define WFI 4
 
 `define OPCODE_RTYPE 7'b0110011 
 `define OPCODE_ITYPE 7'b0010011
@@ -44,6 +75,9 @@
 `define OPCODE_AUIPC 7'b0010111
 `define OPCODE_SYSTEM 7'b1110011
 `define OPCODE_FENCE 7'b0001111
+`define OPCODE_AMO 7'b0101111
+`define OPCODE_CUSTOM0 7'b0001011
+`define OPCODE_CUSTOM1 7'b0101011
                       
 `define FUNCT3_ADD 3'b000
 `define FUNCT3_SLT 3'b010 
@@ -59,4 +93,45 @@
 `define FUNCT3_GE 3'b101
 `define FUNCT3_LTU 3'b110
 `define FUNCT3_GEU 3'b111 
+`define FUNCT3_MUL 3'b000
+`define FUNCT3_MULH 3'b001
+`define FUNCT3_MULHSU 3'b010
+`define FUNCT3_MULHU 3'b011
+`define FUNCT3_DIV 3'b100
+`define FUNCT3_DIVU 3'b101
+`define FUNCT3_REM 3'b110
+`define FUNCT3_REMU 3'b111
+`define FUNCT3_SH1ADD 3'b010
+`define FUNCT3_SH2ADD 3'b100
+`define FUNCT3_SH3ADD 3'b110
+`define FUNCT3_ANDN 3'b111
+`define FUNCT3_ORN 3'b110
+`define FUNCT3_XNOR 3'b100
+`define FUNCT3_MIN 3'b100
+`define FUNCT3_MINU 3'b101
+`define FUNCT3_MAX 3'b110
+`define FUNCT3_MAXU 3'b111
+`define FUNCT3_ROL 3'b001
+`define FUNCT3_ROR 3'b101
+
+`define FUNCT7_MULDIV 7'b0000001
+`define FUNCT7_SHADD 7'b0010000
+`define FUNCT7_LOGICN 7'b0100000
+`define FUNCT7_MINMAX 7'b0000101
+`define FUNCT7_ROTATE 7'b0110000
+`define FUNCT7_ZEXTH 7'b0000100
+`define IMM_ORCB 12'h287
+`define IMM_REV8 12'h698
+
+`define FUNCT5_LR 5'b00010
+`define FUNCT5_SC 5'b00011
+`define FUNCT5_AMOSWAP 5'b00001
+`define FUNCT5_AMOADD 5'b00000
+`define FUNCT5_AMOXOR 5'b00100
+`define FUNCT5_AMOAND 5'b01100
+`define FUNCT5_AMOOR 5'b01000
+`define FUNCT5_AMOMIN 5'b10000
+`define FUNCT5_AMOMAX 5'b10100
+`define FUNCT5_AMOMINU 5'b11000
+`define FUNCT5_AMOMAXU 5'b11100
 
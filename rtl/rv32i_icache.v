@@ -0,0 +1,175 @@
+/* The rv32i_icache module is an optional instruction cache placed between the
+fetch stage and the instruction memory. It lets the core execute code from slow
+or external memory at near-BRAM speed. Key functionalities of the rv32i_icache
+module include:
+ - Cache organization: The cache is direct-mapped (WAYS = 1) or 2-way set-associative
+    (WAYS = 2) with 2**INDEX_WIDTH sets and LINE_WORDS 32-bit words per line.
+    The instruction address is split into {tag, index, word offset}. For 2-way,
+    the least recently used way of the set is replaced on a miss.
+ - Cache hit: The tag and data are read (block ram) at the clock cycle the fetch
+    stage requests an instruction (i_stb_inst) and compared on the next clock cycle.
+    On a hit, the instruction is acknowledged (o_ack_inst) on that clock cycle same
+    as the instruction memory, so a new request can be accepted every clock cycle.
+ - Burst refill: On a miss, the whole line is read from the instruction memory
+    by sending LINE_WORDS back-to-back requests (o_stb_inst_mem) without waiting
+    for each ack. Acks come back in order and each word is written to the line
+    of the replaced way. The requested instruction is acknowledged to the fetch
+    stage once the whole line is refilled.
+ - Doubleword fetch: With FETCH_WORDS = 2 (dual issue), the fetch stage and the
+    instruction memory both transfer 64-bit doublewords, so each cache entry is a 
+    doubleword and a line is refilled by LINE_WORDS/2 requests.
+ - Invalidation: All lines are invalidated by i_invalidate (FENCE.I). A line being
+    refilled while invalidation happens is not marked valid since its words may
+    be read before the stores before FENCE.I are written to memory.
+*/
+
+`timescale 1ns / 1ps
+`default_nettype none
+
+module rv32i_icache #(parameter WAYS = 1, //1 = direct-mapped, 2 = 2-way set-associative
+                      INDEX_WIDTH = 6, //cache has 2**INDEX_WIDTH sets
+                      LINE_WORDS = 4, //number of 32-bit words per cache line (power of 2 and at least 2*FETCH_WORDS)
+                      FETCH_WORDS = 1 //number of 32-bit words per request of the fetch stage and of the instruction memory (1 or 2)
+                      ) (
+    input wire i_clk, i_rst_n,
+    //Fetch Stage Interface
+    input wire[31:0] i_iaddr, //address of instruction from fetch stage
+    input wire i_stb_inst, //request for instruction from fetch stage
+    output reg o_ack_inst, //ack (high if instruction is ready)
+    output reg[32*FETCH_WORDS-1:0] o_inst, //retrieved instruction (doubleword at i_iaddr[31:3] when FETCH_WORDS = 2)
+    //Instruction Memory Interface (burst refill)
+    output wire[31:0] o_iaddr_mem, //address of instruction memory
+    output wire o_stb_inst_mem, //request for read access to instruction memory
+    input wire i_ack_inst_mem, //ack by instruction memory (in the same order as requests)
+    input wire[32*FETCH_WORDS-1:0] i_inst_mem, //instruction retrieved from instruction memory
+    // Cache Control
+    input wire i_invalidate //invalidate all cache lines (FENCE.I)
+);
+    localparam SETS = 2**INDEX_WIDTH;
+    localparam LINE_OFFSET = $clog2(LINE_WORDS); //number of word offset bits in the address
+    localparam FETCH_OFFSET = $clog2(FETCH_WORDS); //number of word offset bits within an entry
+    localparam ENTRY_OFFSET = LINE_OFFSET - FETCH_OFFSET; //number of entry offset bits in the address
+    localparam LINE_ENTRIES = LINE_WORDS/FETCH_WORDS; //number of entries per cache line (burst length of refill)
+    localparam TAG_WIDTH = 30 - INDEX_WIDTH - LINE_OFFSET;
+    localparam IDLE = 0,
+               REFILL = 1,
+               DONE = 2;
+
+    reg[32*FETCH_WORDS-1:0] data0[SETS*LINE_ENTRIES-1:0]; //instruction entries of way 0
+    reg[32*FETCH_WORDS-1:0] data1[SETS*LINE_ENTRIES-1:0]; //instruction entries of way 1
+    reg[TAG_WIDTH-1:0] tag0[SETS-1:0]; //tag of way 0
+    reg[TAG_WIDTH-1:0] tag1[SETS-1:0]; //tag of way 1
+    reg[SETS-1:0] valid0, valid1; //line is valid
+    reg[SETS-1:0] lru; //way to be replaced next on the set (least recently used)
+
+    reg[1:0] state;
+    reg req_valid; //high if there is a request being looked up
+    reg[31:0] req_addr; //address of request being looked up or refilled
+    reg[32*FETCH_WORDS-1:0] rd_data0, rd_data1; //instruction read from each way
+    reg[TAG_WIDTH-1:0] rd_tag0, rd_tag1; //tag read from each way
+    reg[ENTRY_OFFSET:0] req_count; //number of refill requests sent
+    reg[ENTRY_OFFSET:0] ack_count; //number of refill entries received
+    reg refill_way; //way where line is refilled
+    reg refill_invalidated; //high if invalidation happened while refilling
+    reg[32*FETCH_WORDS-1:0] refill_inst; //requested instruction captured during refill
+
+    wire[INDEX_WIDTH-1:0] req_index = req_addr[INDEX_WIDTH+LINE_OFFSET+1 : LINE_OFFSET+2];
+    wire[TAG_WIDTH-1:0] req_tag = req_addr[31 : INDEX_WIDTH+LINE_OFFSET+2];
+    wire[INDEX_WIDTH+ENTRY_OFFSET-1:0] req_word = req_addr[INDEX_WIDTH+LINE_OFFSET+1 : FETCH_OFFSET+2]; //{index, entry offset} of requested instruction
+    wire[INDEX_WIDTH+ENTRY_OFFSET-1:0] i_word = i_iaddr[INDEX_WIDTH+LINE_OFFSET+1 : FETCH_OFFSET+2]; //{index, entry offset} of new request
+    wire hit0 = valid0[req_index] && rd_tag0 == req_tag;
+    wire hit1 = WAYS == 2 && valid1[req_index] && rd_tag1 == req_tag;
+    wire hit = state == IDLE && req_valid && (hit0 || hit1);
+    wire miss = state == IDLE && req_valid && !(hit0 || hit1);
+    //new request is accepted when no request is being looked up, or when the current request is acknowledged
+    wire accept = i_stb_inst && ((state == IDLE && (!req_valid || hit)) || state == DONE);
+    wire[INDEX_WIDTH+ENTRY_OFFSET-1:0] refill_word = {req_index, ack_count[ENTRY_OFFSET-1:0]}; //{index, entry offset} of refill entry being received
+
+    assign o_stb_inst_mem = state == REFILL && req_count != LINE_ENTRIES;
+    assign o_iaddr_mem = {req_addr[31 : LINE_OFFSET+2], req_count[ENTRY_OFFSET-1:0], {(FETCH_OFFSET+2){1'b0}}}; //line is read from first entry
+
+    //instruction to fetch stage
+    always @* begin
+        o_ack_inst = hit || state == DONE;
+        o_inst = refill_inst;
+        if(state == IDLE) o_inst = hit0? rd_data0 : rd_data1;
+    end
+
+    //block ram read ports (read at the clock cycle the request is accepted)
+    always @(posedge i_clk) begin
+        if(accept) begin
+            rd_data0 <= data0[i_word];
+            rd_data1 <= data1[i_word];
+            rd_tag0 <= tag0[i_iaddr[INDEX_WIDTH+LINE_OFFSET+1 : LINE_OFFSET+2]];
+            rd_tag1 <= tag1[i_iaddr[INDEX_WIDTH+LINE_OFFSET+1 : LINE_OFFSET+2]];
+        end
+        //block ram write port (refill)
+        if(state == REFILL && i_ack_inst_mem) begin
+            if(refill_way) data1[refill_word] <= i_inst_mem;
+            else data0[refill_word] <= i_inst_mem;
+        end
+        if(state == REFILL && i_ack_inst_mem && ack_count == LINE_ENTRIES-1) begin
+            if(refill_way) tag1[req_index] <= req_tag;
+            else tag0[req_index] <= req_tag;
+        end
+    end
+
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            state <= IDLE;
+            req_valid <= 0;
+            valid0 <= 0;
+            valid1 <= 0;
+            lru <= 0;
+            req_count <= 0;
+            ack_count <= 0;
+            refill_way <= 0;
+            refill_invalidated <= 0;
+        end
+        else begin
+            case(state)
+                IDLE: if(miss) begin //start refill of the line to the replaced way (invalid way first)
+                        state <= REFILL;
+                        req_count <= 0;
+                        ack_count <= 0;
+                        refill_invalidated <= 0;
+                        if(WAYS == 1 || !valid0[req_index]) refill_way <= 0;
+                        else if(!valid1[req_index]) refill_way <= 1;
+                        else refill_way <= lru[req_index];
+                      end
+                      else if(hit && WAYS == 2) lru[req_index] <= hit0; //the way not used is replaced next
+
+              REFILL: begin
+                        if(o_stb_inst_mem) req_count <= req_count + 1;
+                        if(i_ack_inst_mem) begin
+                            ack_count <= ack_count + 1;
+                            if(ack_count[ENTRY_OFFSET-1:0] == req_word[ENTRY_OFFSET-1:0]) refill_inst <= i_inst_mem;
+                            if(ack_count == LINE_ENTRIES-1) begin //line is complete
+                                state <= DONE;
+                                if(refill_way) valid1[req_index] <= !refill_invalidated && !i_invalidate;
+                                else valid0[req_index] <= !refill_invalidated && !i_invalidate;
+                                if(WAYS == 2) lru[req_index] <= !refill_way;
+                            end
+                        end
+                      end
+                DONE: state <= IDLE; //requested instruction is acknowledged
+             default: state <= IDLE;
+            endcase
+
+            //register new request to be looked up on the next clock cycle
+            if(accept) begin
+                req_valid <= 1;
+                req_addr <= i_iaddr;
+            end
+            else if(hit || state == DONE) req_valid <= 0;
+
+            //invalidate all lines
+            if(i_invalidate) begin
+                valid0 <= 0;
+                valid1 <= 0;
+                if(state == REFILL) refill_invalidated <= 1;
+            end
+        end
+    end
+
+endmodule
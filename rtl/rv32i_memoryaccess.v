@@ -17,27 +17,75 @@
  - Register writeback control: The module i_wb_stall_datadetermines whether a destination register
  should be written (o_wr_rd) based on the input i_wr_rd signal. It passes the 
  destination register address (o_rd_addr) and the data to be written (o_rd) to the 
- next stage.
+ next stage. The rd of the instruction issued together with it (second issue slot
+ of dual issue, always an ALU instruction) is passed the same way (o_slot1_wr_rd).
  - Data memory control: The module controls the data memory read/write requests by
  generating the o_stb_data signal, which indicates a request for data memory access.
 It also generates the o_wb_we_data signal, which indicates whether a write operation 
-should be performed on the data memory.
+should be performed on the data memory. The data memory interface follows the Wishbone B4 
+pipelined mode: up to MAX_REQUESTS requests can be outstanding at the same time and 
+responses (i_wb_ack_data) always come back in the same order as the requests. Stores do not
+wait for their ack, so consecutive stores are streamed to the data memory one per clock cycle.
+A load waits only for its own ack which is the ack received when it is the last outstanding 
+request. The bus cycle (o_wb_cyc_data) stays high while there are outstanding requests.
+ - Store buffer: Stores are posted to a STORE_BUFFER_DEPTH-entry FIFO when the data memory 
+can not accept the request yet, so stores retire without stalling. Buffered stores are sent in 
+order ahead of any later load. A load whose bytes are all covered by buffered stores takes its 
+data directly from the store buffer (youngest store wins per byte) without accessing the data 
+memory, otherwise the load is sent after the buffered stores. FENCE waits until the store buffer
+is drained and all requests are acknowledged. Stores in the buffer are already retired so they 
+keep on draining even when a trap flushes the pipeline.
+ - Atomic instructions: LR.W loads a word and sets a reservation on its word address, 
+ SC.W writes rs2 only if the reservation is still valid (rd = 0 on success, 1 on failure 
+ without accessing the data memory). The reservation is cleared by any SC.W and by traps. 
+ An AMO reads the word, computes the new value (swap, add, xor, and, or, min, max, minu, maxu)
+ from the read data and rs2, then writes it back. The bus cycle (o_wb_cyc_data) stays high 
+ from the read request until the write request is sent so that the read-modify-write is one
+ locked Wishbone sequence. Atomic instructions are sent only after the store buffer is 
+ drained and never take their data from the store buffer. When MULTI_HART is enabled, the 
+ data bus is shared with other harts: their writes (i_snoop_we) to the reserved word clear
+ the reservation, and SC.W reads the word first like an AMO so that the reservation is checked
+ again while the bus is locked (no write of another hart can come between the check and the write).
+ - Coprocessor: A custom instruction (custom-0/custom-1) sends its rs1, rs2, funct3, funct7,
+ and custom-1 bit to the coprocessor (o_cop_req_valid, held until accepted by i_cop_req_ready)
+ and waits for the response (i_cop_rsp_valid) whose data is loaded to rd like a load. The
+ response may take any number of clock cycles. Only one request is outstanding at a time: a 
+ custom instruction flushed after sending its request still waits for its response (which is
+ discarded) before the next request is sent. Custom instructions never access the data memory.
+ - Parked load (multithreading): A load waiting for its ack (o_load_wait) can be parked by the
+ thread scheduler (i_park): it leaves this stage without its data so that another thread runs
+ while the data memory is busy. Its ack is the one received after the acks of all requests sent
+ before it, and its data is then written to the register bank of its thread (o_park_wr_rd). Only
+ one load is parked at a time.
+ - Data cache clean: FENCE.I requests the optional data cache to write back all its dirty 
+lines (o_dcache_clean) and waits until it is done (i_dcache_clean_done) so the instruction 
+memory sees all previous stores.
+ - Wait for interrupt: WFI (i_wfi) stalls this stage and thus holds the whole pipeline
+ (o_sleep) until an enabled interrupt is pending (i_wake), then leaves this stage like a NOP.
+ The fetch stage stops once its prefetch queue is full, so neither bus is used while sleeping.
  - Pipeline control: The module can stall the pipeline by asserting the o_stall signal
- if the data memory access is not yet acknowledged (i_wb_ack_data) or if there is a stall
+ if the data memory can not accept the request yet (i_wb_stall_data or MAX_REQUESTS outstanding 
+ requests), if the load data is not yet acknowledged (i_wb_ack_data), if the coprocessor response
+ is not yet received (i_cop_rsp_valid), if WFI waits for an interrupt, or if there is a stall
  request from the ALU stage (i_stall_from_alu). It can also flush the current stage and
- previous stages using the o_flush signal based on the input i_flush signal. The module 
- controls the clock enable signals (o_ce) for the next stage based on the stall and flush 
- conditions.
+ previous stages using the o_flush signal based on the input i_flush signal. A flushed
+ load/store never sends its request to the data memory. The module controls the clock 
+ enable signals (o_ce) for the next stage based on the stall and flush conditions.
 */ 
  
 `timescale 1ns / 1ps
 `default_nettype none
 `include "rv32i_header.vh"
 
-module rv32i_memoryaccess(
+module rv32i_memoryaccess #(parameter MAX_REQUESTS = 1, //maximum number of outstanding data memory requests
+                            STORE_BUFFER_DEPTH = 0, //number of entries of store buffer (0 = no store buffer)
+                            MULTI_HART = 0 //1 = data bus is shared with other harts (reservation snooping and locked SC.W)
+                            ) (
     input wire i_clk, i_rst_n,
     input wire[31:0] i_rs2, //data to be stored to memory is always i_rs2
     input wire[31:0] i_y, //y value from ALU (address of data to memory be stored or loaded)
+    input wire[4:0] i_amo_op, //funct5 of atomic instruction (LR, SC, or AMO operation)
+    input wire[7:0] i_cop_funct, //{custom-1, funct7} of custom instruction
     input wire[2:0] i_funct3, //funct3 from previous stage
     output reg[2:0] o_funct3, //funct3 (byte,halfword,word)
     input wire[`OPCODE_WIDTH-1:0] i_opcode, //determines if data_store will be to stored to data memory
@@ -51,6 +99,14 @@ module rv32i_memoryaccess(
     output reg[4:0] o_rd_addr, //address for destination register
     input wire[31:0] i_rd, //value to be written back to destination reg
     output reg[31:0] o_rd, //value to be written back to destination register
+    input wire i_slot1_ce, //high if an instruction is issued together at second issue slot (from previous stage)
+    output reg o_slot1_ce, //high if an instruction is issued together at second issue slot
+    input wire i_slot1_wr_rd, //write rd of second issue slot to base reg is enabled (from previous stage)
+    output reg o_slot1_wr_rd, //write rd of second issue slot to the base reg if enabled
+    input wire[4:0] i_slot1_rd_addr, //address for destination register of second issue slot (from previous stage)
+    output reg[4:0] o_slot1_rd_addr, //address for destination register of second issue slot
+    input wire[31:0] i_slot1_rd, //value to be written back to destination reg of second issue slot
+    output reg[31:0] o_slot1_rd, //value to be written back to destination register of second issue slot
     // Data Memory Control
     output reg o_wb_cyc_data, //bus cycle active (1 = normal operation, 0 = all ongoing transaction are to be cancelled)
     output reg o_wb_stb_data, //request for read/write access to data memory
@@ -62,6 +118,33 @@ module rv32i_memoryaccess(
     input wire i_wb_stall_data, //stall by data memory (1 = data memory is busy)
     input wire[31:0] i_wb_data_data, //data retrieve from data memory 
     output reg[31:0] o_data_load, //data to be loaded to base reg (z-or-s extended) 
+    output wire[31:0] o_data_load_bypass, //data to be loaded to base reg while still on the bus (z-or-s extended)
+    output wire o_data_load_bypass_valid, //high if o_data_load_bypass is valid (load data is acknowledged at this clock cycle)
+    output wire o_dcache_clean, //request data cache to write back all dirty lines (FENCE.I)
+    input wire i_dcache_clean_done, //all dirty lines of data cache are already written back
+    input wire i_snoop_we, //write of another hart is accepted by the data memory (only used when MULTI_HART is enabled)
+    input wire[31:0] i_snoop_addr, //address of the write of another hart
+    // Parked Load (multithreading)
+    output wire o_load_wait, //load at this stage is waiting for its ack (and can be parked)
+    input wire i_park, //park the load at this stage (leaves this stage without its data)
+    output reg o_park_wr_rd, //data of the parked load is acknowledged (write to base reg)
+    output reg[4:0] o_park_rd_addr, //address for destination register of the parked load
+    output reg[31:0] o_park_rd, //data of the parked load (z-or-s extended)
+    output wire o_reserved, //reservation set by LR is valid
+    // Coprocessor Interface
+    output reg o_cop_req_valid, //request to coprocessor (held until accepted)
+    input wire i_cop_req_ready, //coprocessor accepts the request
+    output reg o_cop_custom1, //opcode of custom instruction (0 = custom-0, 1 = custom-1)
+    output reg[2:0] o_cop_funct3, //funct3 of custom instruction
+    output reg[6:0] o_cop_funct7, //funct7 of custom instruction
+    output reg[31:0] o_cop_rs1, //rs1 value of custom instruction
+    output reg[31:0] o_cop_rs2, //rs2 value of custom instruction
+    input wire i_cop_rsp_valid, //response of coprocessor (i_cop_rsp_data is valid)
+    input wire[31:0] i_cop_rsp_data, //value to be loaded to rd of custom instruction
+    // Wait For Interrupt
+    input wire i_wfi, //instruction at this stage is WFI
+    input wire i_wake, //an enabled interrupt is pending (WFI is done)
+    output wire o_sleep, //WFI at this stage waits for an interrupt (pipeline is held)
     /// Pipeline Control ///
     input wire i_stall_from_alu, //stalls this stage when incoming instruction is a load/store
     input wire i_ce, // input clk enable for pipeline stalling of this stage
@@ -75,27 +158,125 @@ module rv32i_memoryaccess(
     reg[31:0] data_store_d; //data to be stored to memory
     reg[31:0] data_load_d; //data to be loaded to basereg
     reg[3:0] wr_mask_d; 
-    reg pending_request; //high if there is still a pending request (request which have not yet acknowledged)
+    reg[$clog2(MAX_REQUESTS+1)-1:0] pending_requests; //number of requests sent which are not yet acknowledged (including request still on stb)
+    reg request_sent; //high if the load/store at this stage already sent its request
     wire[1:0] addr_2 = i_y[1:0]; //last 2  bits of data memory address
     wire stall_bit = i_stall || o_stall;
+    //store buffer (FIFO of posted stores)
+    localparam SB_ENTRIES = (STORE_BUFFER_DEPTH == 0)? 1 : STORE_BUFFER_DEPTH; 
+    localparam SB_PTR_WIDTH = (SB_ENTRIES > 1)? $clog2(SB_ENTRIES) : 1;
+    reg[29:0] sb_addr[SB_ENTRIES-1:0]; //word address of buffered store
+    reg[31:0] sb_data[SB_ENTRIES-1:0]; //data of buffered store (mask-aligned)
+    reg[3:0] sb_sel[SB_ENTRIES-1:0]; //byte strobe of buffered store
+    reg[SB_PTR_WIDTH-1:0] sb_wr_ptr, sb_rd_ptr; //write pointer (push) and read pointer (oldest store)
+    reg[$clog2(SB_ENTRIES+1)-1:0] sb_count; //number of stores in store buffer
+    reg[31:0] sb_load_data; //load data taken from the store buffer
+    reg[3:0] sb_load_sel; //bytes of the load covered by the store buffer
+    reg[SB_PTR_WIDTH-1:0] sb_index;
+    integer i;
+    //atomic instructions
+    wire amo_lr = i_opcode[`AMO] && i_amo_op == `FUNCT5_LR; //load-reserved
+    wire amo_sc = i_opcode[`AMO] && i_amo_op == `FUNCT5_SC; //store-conditional
+    wire amo_rmw = i_opcode[`AMO] && !amo_lr && !amo_sc; //read-modify-write AMO
+    wire amo_sc_lock = MULTI_HART != 0 && amo_sc; //SC reads before writing under the bus lock
+    wire amo_locked = amo_rmw || amo_sc_lock; //read then write as one locked sequence
+    reg reserved; //high if reservation set by LR is valid
+    reg[29:0] reserved_addr; //word address of reservation
+    wire sc_success = reserved && reserved_addr == i_y[31:2] && addr_2 == 2'b00; //SC writes to memory only if reservation is valid
+    reg amo_loaded; //read data of AMO is already acked (write is next)
+    reg amo_written; //write of AMO is already sent 
+    reg[31:0] amo_rdata; //data read by AMO (loaded to rd)
+    reg[31:0] amo_wdata; //new value written back by AMO
+    //custom instructions
+    wire cop = i_opcode[`CUSTOM];
+    reg cop_sent; //request of the custom instruction at this stage is already sent
+    reg cop_pending; //request sent but response not yet received
+    reg cop_done; //response of the custom instruction at this stage is already received
+    reg[31:0] cop_rdata; //response data (loaded to rd)
+    //parked load
+    reg park_pending; //parked load is not yet acknowledged
+    reg[$clog2(MAX_REQUESTS+1)-1:0] park_acks; //acks to be received until the ack of the parked load
+    reg[2:0] park_funct3; //funct3 of the parked load
+    reg[1:0] park_addr_2; //last 2 bits of address of the parked load
+    reg[31:0] park_data_d; //data of the parked load (z-or-s extended)
+    wire park_ack = park_pending && park_acks == 1 && i_wb_ack_data;
+    //a flushed custom instruction never sends its request to the coprocessor
+    wire send_cop = i_ce && cop && !cop_sent && !cop_pending && !i_flush;
+    wire cop_ack = cop && cop_sent && !cop_done && i_cop_rsp_valid; //response for the custom instruction at this stage
+    //failed SC and misaligned AMO (exception) never access data memory
+    wire amo_skip = (amo_sc && !sc_success && !request_sent) || (amo_rmw && addr_2 != 2'b00); 
+    //locked SC whose reservation is cleared before its read is acked does not write
+    wire amo_sc_fail = amo_sc_lock && amo_loaded && !sc_success;
+    //a new request can be sent if the current request (if any) is accepted and there is still room for another outstanding request
+    wire request_ready = !(o_wb_stb_data && i_wb_stall_data) && (pending_requests != MAX_REQUESTS || i_wb_ack_data);
+    //oldest buffered store is always sent first to keep the stores and loads in order
+    wire send_store_buffer = request_ready && sb_count != 0;
+    //all bytes of the load at this stage are covered by buffered stores so memory access is not needed
+    wire load_from_store_buffer = i_ce && i_opcode[`LOAD] && !i_opcode[`AMO] && !cop && !request_sent && sb_count != 0 && (sb_load_sel & wr_mask_d) == wr_mask_d;
+    //send request for load/store at this stage (a flushed instruction must never reach the data memory)
+    wire send_request = i_ce && (i_opcode[`LOAD] || i_opcode[`STORE]) && !cop && !amo_skip && !request_sent && !i_flush && request_ready && sb_count == 0; 
+    //send write of AMO after its read data is acked
+    wire send_amo_write = i_ce && amo_locked && amo_loaded && !amo_written && !amo_sc_fail && !i_flush && request_ready;
+    //bus is locked from the read until the write of AMO
+    wire amo_lock = i_ce && amo_locked && (request_sent || send_request) && !amo_written && !send_amo_write && !amo_sc_fail && !i_flush;
+    //store at this stage is posted to the store buffer if it can not be sent directly
+    wire push_store_buffer = STORE_BUFFER_DEPTH != 0 && i_ce && i_opcode[`STORE] && !request_sent && !i_flush && !send_request && sb_count != STORE_BUFFER_DEPTH;
+    //responses are in-order and no request is sent while a load waits at this stage, so the
+    //ack for the load is the ack received when it is the last outstanding request
+    wire load_ack = i_opcode[`LOAD] && !cop && !(amo_sc && !amo_sc_lock) && !amo_loaded && request_sent && pending_requests == 1 && i_wb_ack_data;
+    //only an aligned load (no exception) which is not atomic can be parked
+    wire load_misaligned = (i_funct3[1:0] == 2'b01 && addr_2[0]) || (i_funct3[1:0] == 2'b10 && addr_2 != 2'b00);
+    assign o_load_wait = i_ce && i_opcode[`LOAD] && !i_opcode[`AMO] && !cop && !load_misaligned && request_sent && !load_ack && !park_pending && !o_park_wr_rd && !i_flush;
+    wire park = i_park && o_load_wait;
+    assign o_reserved = reserved;
+    wire[$clog2(MAX_REQUESTS+1)-1:0] pending_requests_d = pending_requests + (send_request || send_store_buffer || send_amo_write) - (i_wb_ack_data && pending_requests != 0);
+    //load/store at this stage is done with the data memory
+    wire access_done = amo_skip || (cop? (cop_ack || cop_done) : 
+                                    amo_locked? (amo_written || send_amo_write || amo_sc_fail) :
+                                    amo_sc? (request_sent || send_request) :
+                                    i_opcode[`LOAD]? (load_ack || load_from_store_buffer || park) : (request_sent || send_request || push_store_buffer));
+    //FENCE waits until all previous stores are already written to memory, FENCE.I also
+    //waits until the data cache has written back all dirty lines to memory
+    wire fence_stall = i_opcode[`FENCE] && (sb_count != 0 || pending_requests != 0 || (i_funct3 == 3'b001 && !i_dcache_clean_done));
+    assign o_sleep = i_ce && i_wfi && !i_wake && !i_flush; //WFI holds the pipeline until an interrupt is pending
+
+    wire[31:0] load_data = load_from_store_buffer? sb_load_data : i_wb_data_data; //load data from store buffer or from data memory
+
+    //load-to-use bypass: the aligned load data is forwarded to the ALU stage at the same
+    //clock cycle it is acknowledged instead of waiting for it to reach the writeback stage
+    assign o_data_load_bypass = data_load_d;
+    assign o_data_load_bypass_valid = i_ce && (load_ack || load_from_store_buffer || (amo_sc && access_done) || (amo_rmw && amo_loaded) || cop_ack || cop_done);
+    assign o_dcache_clean = i_ce && i_opcode[`FENCE] && i_funct3 == 3'b001 && sb_count == 0 && pending_requests == 0;
 
     //register the outputs of this module
     always @(posedge i_clk, negedge i_rst_n) begin
         if(!i_rst_n) begin
             o_wr_rd <= 0;
+            o_slot1_ce <= 0;
+            o_slot1_wr_rd <= 0;
             o_wb_we_data <= 0;
             o_ce <= 0;
             o_wb_stb_data <= 0;
-            pending_request <= 0;
+            pending_requests <= 0;
+            request_sent <= 0;
             o_wb_cyc_data <= 0;
+            reserved <= 0;
+            amo_loaded <= 0;
+            amo_written <= 0;
+            sb_wr_ptr <= 0;
+            sb_rd_ptr <= 0;
+            sb_count <= 0;
+            o_cop_req_valid <= 0;
+            cop_sent <= 0;
+            cop_pending <= 0;
+            cop_done <= 0;
+            park_pending <= 0;
+            o_park_wr_rd <= 0;
         end
         else begin
-            // wishbone cycle will only be high if this stage is enabled
-            o_wb_cyc_data <= i_ce;
-            //request completed after ack
-            if(i_wb_ack_data) begin 
-                pending_request <= 0;
-            end
+            // wishbone cycle will only be high while there are outstanding requests
+            pending_requests <= pending_requests_d;
+            o_wb_cyc_data <= pending_requests_d != 0 || amo_lock;
 
             //update register only if this stage is enabled and not stalled (after load/store operation)
             if(i_ce && !stall_bit) begin 
@@ -105,29 +286,114 @@ module rv32i_memoryaccess(
                 o_pc <= i_pc;
                 o_wr_rd <= i_wr_rd;
                 o_rd <= i_rd;
+                o_slot1_ce <= i_slot1_ce;
+                o_slot1_wr_rd <= i_slot1_wr_rd;
+                o_slot1_rd_addr <= i_slot1_rd_addr;
+                o_slot1_rd <= i_slot1_rd;
                 o_data_load <= data_load_d; 
             end
-            //update request to memory when no pending request yet
-            if(i_ce && !pending_request) begin
-                //stb goes high when instruction is a load/store and when
-                //request is not already high (request lasts for 1 clk cycle
-                //only)
-                o_wb_stb_data <= i_opcode[`LOAD] || i_opcode[`STORE]; 
+            //send new request to memory (request lasts until accepted by the data memory i.e. no stall)
+            if(send_store_buffer) begin
+                o_wb_stb_data <= 1; 
+                o_wb_sel_data <= sb_sel[sb_rd_ptr];
+                o_wb_we_data <= 1; 
+                o_wb_addr_data <= {sb_addr[sb_rd_ptr], 2'b00}; 
+                o_wb_data_data <= sb_data[sb_rd_ptr];
+            end
+            else if(send_request) begin
+                o_wb_stb_data <= 1; 
                 o_wb_sel_data <= wr_mask_d;
-                o_wb_we_data <= i_opcode[`STORE]; 
-                pending_request <= i_opcode[`LOAD] || i_opcode[`STORE]; 
+                o_wb_we_data <= i_opcode[`STORE] || (amo_sc && !amo_sc_lock); 
                 o_wb_addr_data <= i_y; 
                 o_wb_data_data <= data_store_d;
             end
-
-            // if there is pending request but no stall from memory: idle the stb line
-            if(pending_request && !i_wb_stall_data) begin
+            else if(send_amo_write) begin
+                o_wb_stb_data <= 1; 
+                o_wb_sel_data <= 4'b1111;
+                o_wb_we_data <= 1; 
+                o_wb_addr_data <= i_y; 
+                o_wb_data_data <= amo_wdata;
+            end
+            // request is accepted if no stall from memory: idle the stb line
+            else if(!i_wb_stall_data) begin
                 o_wb_stb_data <= 0;
             end
 
-            if(!i_ce) begin
-                o_wb_stb_data <= 0;
-            end 
+            //push store to store buffer and pop oldest store when sent to memory
+            if(push_store_buffer) begin
+                sb_addr[sb_wr_ptr] <= i_y[31:2];
+                sb_data[sb_wr_ptr] <= data_store_d;
+                sb_sel[sb_wr_ptr] <= wr_mask_d;
+                sb_wr_ptr <= (sb_wr_ptr == SB_ENTRIES-1)? 0 : sb_wr_ptr + 1;
+            end
+            if(send_store_buffer) begin
+                sb_rd_ptr <= (sb_rd_ptr == SB_ENTRIES-1)? 0 : sb_rd_ptr + 1;
+            end
+            sb_count <= sb_count + push_store_buffer - send_store_buffer;
+
+            //request of the instruction at this stage is already sent until it moves to next stage or is flushed
+            if(send_request || push_store_buffer) request_sent <= 1;
+            if(i_flush || !stall_bit) request_sent <= 0;
+
+            //AMO: keep the read data then send the write
+            if(amo_locked && load_ack) begin
+                amo_loaded <= 1;
+                amo_rdata <= i_wb_data_data;
+            end
+            if(send_amo_write) amo_written <= 1;
+            if(i_flush || !stall_bit) begin
+                amo_loaded <= 0;
+                amo_written <= 0;
+            end
+
+            //send request of custom instruction to coprocessor (request lasts until accepted)
+            if(send_cop) begin
+                o_cop_req_valid <= 1;
+                o_cop_custom1 <= i_cop_funct[7];
+                o_cop_funct3 <= i_funct3;
+                o_cop_funct7 <= i_cop_funct[6:0];
+                o_cop_rs1 <= i_y;
+                o_cop_rs2 <= i_rs2;
+            end
+            else if(i_cop_req_ready) o_cop_req_valid <= 0;
+            
+            //only one request is outstanding (response of a flushed custom instruction is discarded)
+            if(send_cop) cop_pending <= 1;
+            else if(i_cop_rsp_valid) cop_pending <= 0;
+
+            //custom instruction: keep the response data until it moves to next stage
+            if(send_cop) cop_sent <= 1;
+            if(cop_ack) begin
+                cop_done <= 1;
+                cop_rdata <= i_cop_rsp_data;
+            end
+            if(i_flush || !stall_bit) begin
+                cop_sent <= 0;
+                cop_done <= 0;
+            end
+
+            //parked load counts the acks of the requests sent before it (responses are in-order)
+            if(park) begin
+                park_pending <= 1;
+                park_acks <= pending_requests - (i_wb_ack_data && pending_requests != 0);
+                park_funct3 <= i_funct3;
+                park_addr_2 <= addr_2;
+                o_park_rd_addr <= i_rd_addr;
+            end
+            else if(park_pending && i_wb_ack_data) begin
+                park_pending <= park_acks != 1;
+                park_acks <= park_acks - 1;
+            end
+            o_park_wr_rd <= park_ack;
+            if(park_ack) o_park_rd <= park_data_d;
+
+            //LR sets the reservation, SC, traps, and writes of other harts to the reserved word clear it
+            if(amo_lr && load_ack) begin
+                reserved <= 1;
+                reserved_addr <= i_y[31:2];
+            end
+            else if(i_flush || (i_ce && amo_sc && !stall_bit)) reserved <= 0;
+            else if(MULTI_HART != 0 && i_snoop_we && i_snoop_addr[31:2] == reserved_addr && !amo_written) reserved <= 0;
             
             //flush this stage so clock-enable of next stage is disabled at next clock cycle
             if(i_flush && !stall_bit) begin 
@@ -146,9 +412,9 @@ module rv32i_memoryaccess(
 
     //determine data to be loaded to basereg or stored to data memory 
     always @* begin
-        //stall while data memory has not yet acknowledged i.e.write data is not yet written or
-        //read data is not yet available (no ack yet). Don't stall when need to flush by next stage
-        o_stall = ((i_stall_from_alu && i_ce && !i_wb_ack_data) || i_stall) && !i_flush;         
+        //stall while store request is not yet sent to data memory or while read data is not yet 
+        //available (no ack yet). Don't stall when need to flush by next stage
+        o_stall = ((i_stall_from_alu && i_ce && !access_done) || (i_ce && fence_stall) || o_sleep || i_stall) && !i_flush;         
         o_flush = i_flush; //flush this stage along with previous stages
         data_store_d = 0;
         data_load_d = 0;
@@ -157,23 +423,23 @@ module rv32i_memoryaccess(
         case(i_funct3[1:0]) 
             2'b00: begin //byte load/store
                     case(addr_2)  //choose which of the 4 byte will be loaded to basereg
-                        2'b00: data_load_d = {24'b0, i_wb_data_data[7:0]};
-                        2'b01: data_load_d = {24'b0, i_wb_data_data[15:8]};
-                        2'b10: data_load_d = {24'b0, i_wb_data_data[23:16]};
-                        2'b11: data_load_d = {24'b0, i_wb_data_data[31:24]};
+                        2'b00: data_load_d = {24'b0, load_data[7:0]};
+                        2'b01: data_load_d = {24'b0, load_data[15:8]};
+                        2'b10: data_load_d = {24'b0, load_data[23:16]};
+                        2'b11: data_load_d = {24'b0, load_data[31:24]};
                     endcase
                     data_load_d = {{{24{!i_funct3[2]}} & {24{data_load_d[7]}}} , data_load_d[7:0]}; //signed and unsigned extension in 1 equation
                     wr_mask_d = 4'b0001<<addr_2; //mask 1 of the 4 bytes
                     data_store_d = i_rs2<<{addr_2,3'b000}; //i_rs2<<(addr_2*8) , align data to mask
                    end
             2'b01: begin //halfword load/store
-                    data_load_d = addr_2[1]? {16'b0,i_wb_data_data[31:16]}: {16'b0,i_wb_data_data[15:0]}; //choose which of the 2 halfwords will be loaded to basereg
+                    data_load_d = addr_2[1]? {16'b0,load_data[31:16]}: {16'b0,load_data[15:0]}; //choose which of the 2 halfwords will be loaded to basereg
                     data_load_d = {{{16{!i_funct3[2]}} & {16{data_load_d[15]}}},data_load_d[15:0]}; //signed and unsigned extension in 1 equation
                     wr_mask_d = 4'b0011<<{addr_2[1],1'b0}; //mask either the upper or lower half-word
                     data_store_d = i_rs2<<{addr_2[1],4'b0000}; //i_rs2<<(addr_2[1]*16) , align data to mask
                    end
             2'b10: begin //word load/store
-                    data_load_d = i_wb_data_data;
+                    data_load_d = load_data;
                     wr_mask_d = 4'b1111; //mask all
                     data_store_d = i_rs2;
                    end
@@ -183,13 +449,60 @@ module rv32i_memoryaccess(
                     wr_mask_d = 0; 
                    end
         endcase
+        if(amo_sc) data_load_d = {31'b0, !sc_success}; //SC loads 0 to rd on success, 1 on failure
+        else if(amo_rmw && amo_loaded) data_load_d = amo_rdata; //AMO loads the original value to rd (still on the data bus when acknowledged)
+        else if(cop) data_load_d = cop_done? cop_rdata : i_cop_rsp_data; //custom instruction loads the response of coprocessor to rd
+    end
+
+    //data of parked load (aligned and z-or-s extended like a load at this stage)
+    always @* begin
+        park_data_d = i_wb_data_data >> {park_addr_2, 3'b000};
+        case(park_funct3[1:0])
+            2'b00: park_data_d = {{24{!park_funct3[2] && park_data_d[7]}}, park_data_d[7:0]};
+            2'b01: park_data_d = {{16{!park_funct3[2] && park_data_d[15]}}, park_data_d[15:0]};
+            default: park_data_d = park_data_d;
+        endcase
+    end
+
+    //new value written back by AMO
+    always @* begin
+        case(i_amo_op)
+            `FUNCT5_AMOADD: amo_wdata = amo_rdata + i_rs2;
+            `FUNCT5_AMOXOR: amo_wdata = amo_rdata ^ i_rs2;
+            `FUNCT5_AMOAND: amo_wdata = amo_rdata & i_rs2;
+             `FUNCT5_AMOOR: amo_wdata = amo_rdata | i_rs2;
+            `FUNCT5_AMOMIN: amo_wdata = ($signed(amo_rdata) < $signed(i_rs2))? amo_rdata : i_rs2;
+            `FUNCT5_AMOMAX: amo_wdata = ($signed(amo_rdata) > $signed(i_rs2))? amo_rdata : i_rs2;
+           `FUNCT5_AMOMINU: amo_wdata = (amo_rdata < i_rs2)? amo_rdata : i_rs2;
+           `FUNCT5_AMOMAXU: amo_wdata = (amo_rdata > i_rs2)? amo_rdata : i_rs2;
+                   default: amo_wdata = i_rs2; //AMOSWAP
+        endcase
+    end
+    
+    //search store buffer (oldest to youngest) for stores to the same word address as the load 
+    always @* begin
+        sb_load_data = 0;
+        sb_load_sel = 0;
+        sb_index = sb_rd_ptr;
+        for(i = 0; i < SB_ENTRIES; i = i + 1) begin
+            if(i < sb_count && sb_addr[sb_index] == i_y[31:2]) begin //younger store overwrites the bytes of older store
+                if(sb_sel[sb_index][0]) sb_load_data[7:0] = sb_data[sb_index][7:0];
+                if(sb_sel[sb_index][1]) sb_load_data[15:8] = sb_data[sb_index][15:8];
+                if(sb_sel[sb_index][2]) sb_load_data[23:16] = sb_data[sb_index][23:16];
+                if(sb_sel[sb_index][3]) sb_load_data[31:24] = sb_data[sb_index][31:24];
+                sb_load_sel = sb_load_sel | sb_sel[sb_index];
+            end
+            sb_index = (sb_index == SB_ENTRIES-1)? 0 : sb_index + 1;
+        end
     end
     
 `ifdef FORMAL
     always @* begin
         if(o_wb_stb_data) begin
-            assert(pending_request);
+            assert(pending_requests != 0);
         end
+        assert(pending_requests <= MAX_REQUESTS);
+        assert(sb_count <= STORE_BUFFER_DEPTH);
     end
 
 `endif 
@@ -0,0 +1,125 @@
+/* The rv32i_operand module is the extra pipeline stage of the deeper pipeline
+(DEEP_PIPELINE) placed between the decode stage and the ALU stage. The execute
+stage is split into two so that the operand forwarding and the ALU computation
+(and branch resolution) are no longer in the same clock cycle. Key functionalities
+of the rv32i_operand module include:
+ - Operand selection: The rs1 and rs2 values are read from the basereg and
+    forwarded from the memory-access and writeback stages (rv32i_forwarding) at
+    this stage, then registered for the ALU stage.
+ - Forwarding from the ALU stage: The result of the instruction currently at the
+    ALU stage is not yet available. When it is a producer of rs1 or rs2, only the
+    selection is registered and the ALU stage takes the operand directly from the
+    registered ALU output (i_alu_rd) on the next clock cycle. When its result is
+    not computed by the ALU (load or CSR instruction), this stage stalls until
+    the instruction moves to the memory-access stage.
+ - Pipeline control: Same as the decode stage, this stage stalls when the next
+    stages are stalled (i_stall) or when forced to stall (i_force_stall), and
+    is flushed along with the previous stages (i_flush).
+*/
+
+`timescale 1ns / 1ps
+`default_nettype none
+`include "rv32i_header.vh"
+
+module rv32i_operand (
+    input wire i_clk,i_rst_n,
+    input wire[`ALU_WIDTH-1:0] i_alu, //alu operation type from previous stage
+    output reg[`ALU_WIDTH-1:0] o_alu, //alu operation type
+    input wire[`OPCODE_WIDTH-1:0] i_opcode, //opcode type from previous stage
+    output reg[`OPCODE_WIDTH-1:0] o_opcode, //opcode type
+    input wire[31:0] i_pc, //PC value from previous stage
+    output reg[31:0] o_pc, //PC value
+    input wire i_compressed, //high if instruction is an expanded compressed instruction
+    output reg o_compressed, //high if instruction is an expanded compressed instruction
+    input wire[4:0] i_rs1_addr, //address for register source 1 (from previous stage)
+    output reg[4:0] o_rs1_addr, //address for register source 1
+    input wire[4:0] i_rs2_addr, //address for register source 2 (from previous stage)
+    output reg[4:0] o_rs2_addr, //address for register source 2
+    input wire[4:0] i_rd_addr, //address for destination register (from previous stage)
+    output reg[4:0] o_rd_addr, //address for destination register
+    input wire[31:0] i_imm, //immediate value from previous stage
+    output reg[31:0] o_imm, //immediate value
+    input wire[2:0] i_funct3, //function type from previous stage
+    output reg[2:0] o_funct3, //function type
+    input wire[`EXCEPTION_WIDTH-1:0] i_exception, //exception from decoder stage
+    output reg[`EXCEPTION_WIDTH-1:0] o_exception, //exceptions: illegal inst, ecall, ebreak, mret, wfi
+    /// Branch Prediction ///
+    input wire i_pred_taken, //high if instruction is predicted as a taken branch/jump by fetch stage
+    output reg o_pred_taken, //high if instruction is predicted as a taken branch/jump
+    input wire[31:0] i_pred_pc, //predicted target address from fetch stage
+    output reg[31:0] o_pred_pc, //predicted target address
+    /// Operands ///
+    input wire[31:0] i_rs1, //rs1 value at this stage (with operand forwarding from memory-access and writeback stages)
+    input wire[31:0] i_rs2, //rs2 value at this stage (with operand forwarding from memory-access and writeback stages)
+    input wire[31:0] i_alu_rd, //registered result of the ALU stage (rd value of the previous instruction)
+    output wire[31:0] o_rs1, //rs1 value for the ALU stage
+    output wire[31:0] o_rs2, //rs2 value for the ALU stage
+    /// Pipeline Control ///
+    input wire i_ce, // input clk enable for pipeline stalling of this stage
+    output reg o_ce, // output clk enable for pipeline stalling of next stage
+    input wire i_stall, //informs this stage to stall
+    input wire i_force_stall, //force this stage to stall
+    output reg o_stall, //informs pipeline to stall
+    input wire i_flush, //flush this stage
+    output reg o_flush //flush previous stages
+);
+
+    reg[31:0] rs1_q, rs2_q; //registered operands
+    reg rs1_alu, rs2_alu; //high if operand is taken from the result of the previous instruction (i_alu_rd)
+    wire stall_bit = o_stall || i_stall; //stall this stage when next stages are stalled
+    //instruction at the ALU stage (outputs of this stage) writes a destination register
+    wire alu_wr_rd = o_ce && o_rd_addr != 0 && !(o_opcode[`BRANCH] || o_opcode[`STORE] || (o_opcode[`SYSTEM] && o_funct3 == 0) || o_opcode[`FENCE]);
+    //result of load and CSR instructions are not computed at the ALU stage
+    wire alu_rd_valid = !(o_opcode[`LOAD] || (o_opcode[`SYSTEM] && o_funct3 != 0));
+    wire rs1_alu_d = alu_wr_rd && i_rs1_addr == o_rd_addr;
+    wire rs2_alu_d = alu_wr_rd && i_rs2_addr == o_rd_addr;
+
+    assign o_rs1 = rs1_alu? i_alu_rd : rs1_q;
+    assign o_rs2 = rs2_alu? i_alu_rd : rs2_q;
+
+    //register the operands and the outputs of decoder stage
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            o_ce <= 0;
+            o_exception <= 0;
+            rs1_alu <= 0;
+            rs2_alu <= 0;
+        end
+        else begin
+            if(i_ce && !stall_bit) begin //update registers only if this stage is enabled and pipeline is not stalled
+                o_alu <= i_alu;
+                o_opcode <= i_opcode;
+                o_pc <= i_pc;
+                o_compressed <= i_compressed;
+                o_rs1_addr <= i_rs1_addr;
+                o_rs2_addr <= i_rs2_addr;
+                o_rd_addr <= i_rd_addr;
+                o_imm <= i_imm;
+                o_funct3 <= i_funct3;
+                o_exception <= i_exception;
+                o_pred_taken <= i_pred_taken;
+                o_pred_pc <= i_pred_pc;
+                rs1_q <= i_rs1;
+                rs2_q <= i_rs2;
+                rs1_alu <= rs1_alu_d;
+                rs2_alu <= rs2_alu_d;
+            end
+            if(i_flush && !stall_bit) begin //flush this stage so clock-enable of next stage is disabled at next clock cycle
+                o_ce <= 0;
+            end
+            else if(!stall_bit) begin //clock-enable will change only when not stalled
+                o_ce <= i_ce;
+            end
+            else if(stall_bit && !i_stall) o_ce <= 0; //if this stage is stalled but next stage is not, disable
+                                                       //clock enable of next stage at next clock cycle (pipeline bubble)
+        end
+    end
+
+    always @* begin
+        //stall when next stages are stalled, when forced to stall by operand forwarding, or when an operand
+        //is produced by a load or CSR instruction at the ALU stage
+        o_stall = (i_stall || i_force_stall || (i_ce && (rs1_alu_d || rs2_alu_d) && !alu_rd_valid)) && !i_flush;
+        o_flush = i_flush; //flush this stage along with the previous stages
+    end
+
+endmodule
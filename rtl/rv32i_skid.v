@@ -0,0 +1,67 @@
+/* The rv32i_skid module is a skid buffer for the ready/valid handshake between two
+pipeline stages. It lets the previous stage see a registered stall signal instead of
+the combinational stall of all the next stages, so a stall reaches the previous stage
+one clock cycle later. Key functionalities of the rv32i_skid module include:
+ - Pass-through: When the buffer is empty, the data from the previous stage (i_data
+    and i_ce) goes directly to the next stage without additional latency.
+ - Skid: The previous stage only stalls when the buffer is full (o_stall is a register).
+    When the next stage stalls (i_stall) while the previous stage hands over an
+    instruction, the instruction is stored in the buffer and o_stall goes high at the
+    next clock cycle. The buffered instruction is given to the next stage first once
+    it is no longer stalled, and the previous stage resumes on the following clock cycle.
+ - Flush: The buffered instruction is discarded when the next stages are flushed (i_flush).
+*/
+
+`timescale 1ns / 1ps
+`default_nettype none
+
+module rv32i_skid #(parameter WIDTH = 32) ( //width of the data passed between the stages
+    input wire i_clk, i_rst_n,
+    //Previous Stage Interface
+    input wire[WIDTH-1:0] i_data, //data from previous stage
+    input wire i_ce, //high if i_data is valid (valid)
+    output wire o_stall, //stall previous stage (registered, high if buffer is full)
+    //Next Stage Interface
+    output wire[WIDTH-1:0] o_data, //data to next stage (buffered data first)
+    output wire o_ce, //high if o_data is valid (clk enable of next stage)
+    input wire i_stall, //next stage is stalled (o_data is not taken)
+    input wire i_flush //discard buffered data
+);
+    reg skid_valid; //buffer is full
+    reg[WIDTH-1:0] skid_data; //data taken from previous stage but not yet taken by next stage
+
+    assign o_stall = skid_valid;
+    assign o_ce = skid_valid || i_ce;
+    assign o_data = skid_valid? skid_data : i_data;
+
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            skid_valid <= 0;
+        end
+        else begin
+            if(i_flush) skid_valid <= 0; //buffered data is on the wrong path
+            else if(skid_valid) skid_valid <= i_stall; //buffered data is taken when next stage is not stalled
+            else skid_valid <= i_ce && i_stall; //data is taken from previous stage while next stage is stalled
+        end
+    end
+
+    always @(posedge i_clk) begin
+        if(!skid_valid) skid_data <= i_data;
+    end
+
+    `ifdef FORMAL
+        reg f_past_valid = 0;
+        always @(posedge i_clk) f_past_valid <= 1;
+
+        always @(posedge i_clk) begin
+            if(f_past_valid && $past(i_rst_n) && i_rst_n && !$past(i_flush)) begin
+                //data taken from previous stage while next stage is stalled is not lost
+                if(!$past(skid_valid) && $past(i_ce) && $past(i_stall)) assert(o_ce && o_stall && o_data == $past(i_data));
+                //buffered data is held until taken by next stage
+                if($past(skid_valid) && $past(i_stall)) assert(o_stall && o_data == $past(o_data));
+                //buffered data is given to next stage only once
+                if($past(skid_valid) && !$past(i_stall)) assert(!o_stall);
+            end
+        end
+    `endif
+endmodule
@@ -0,0 +1,149 @@
+/* The rv32i_threads module is the thread scheduler of the multithreaded core (THREADS > 1).
+The pipeline runs one thread at a time and switches to the next ready thread on events
+(switch-on-event multithreading), so the other threads keep the pipeline busy while a
+thread waits for a slow device. Each thread has its own register bank, CSRs, and PC and
+appears to software as its own hart. Key functionalities of the rv32i_threads module include:
+ - Thread state: The module keeps the thread running on the pipeline (o_thread), the PC
+    where each thread resumes, and which threads wait for a parked load. All threads start
+    at PC_RESET and thread 0 runs first.
+ - Switch on long-latency load: When a load at the memory access stage has waited for its
+    ack for SWITCH_LATENCY clock cycles, the load is parked (o_park): it leaves the memory
+    access stage without its data and the thread resumes at the instruction after the load
+    once the parked load has written its rd (i_park_done). Only one load is parked at a time.
+ - Round-robin switch: When a thread has run for QUANTUM clock cycles, the pipeline switches
+    to the next ready thread at the next ALU, branch, or jump instruction at the memory access stage. That
+    instruction is not executed (o_squash_q) and the thread resumes at it. A thread always does
+    at least one instruction before it is switched round-robin so every thread makes progress,
+    and a thread holding an LR reservation runs up to 64 more clock cycles so that its SC can
+    succeed (a switch clears the reservation).
+ - Switch on WFI: A WFI at the memory access stage which waits for an interrupt of its thread
+    (i_wfi) switches to the next ready thread right away (o_wfi_switch ends the wait of the
+    memory access stage). The WFI is not executed and the thread resumes at it, so it waits
+    again unless an interrupt is pending by then.
+ - Switch: Like a trap, the switch is decided at the memory access stage (registered to
+    o_switch_q) and done by the writeback stage which flushes the pipeline and fetches from
+    the resume PC of the next thread (o_next_pc). A trap or mret of the same instruction has
+    priority and the switch is tried again later.
+*/
+
+`timescale 1ns / 1ps
+`default_nettype none
+`include "rv32i_header.vh"
+
+module rv32i_threads #(parameter PC_RESET = 32'h00_00_00_00, //PC of all threads after reset
+                       THREADS = 2, //number of threads (2 to 4)
+                       SWITCH_LATENCY = 2, //clock cycles a load waits for its ack before the thread switches (0 = never switch on loads)
+                       QUANTUM = 256, //clock cycles a thread runs before switching to the next ready thread (0 = never switch round-robin)
+                       C_EXTENSION = 0 //1 = instructions can be compressed (2 bytes)
+                       ) (
+    input wire i_clk, i_rst_n,
+    output reg[1:0] o_thread, //thread running on the pipeline
+    // Stage 4 [MEMORYACCESS]
+    input wire[`OPCODE_WIDTH-1:0] i_opcode, //opcode type of instruction at memory access stage
+    input wire i_exception, //high if instruction at memory access stage has an exception from decoder
+    input wire[31:0] i_pc, //PC of instruction at memory access stage
+    input wire i_compressed, //high if instruction at memory access stage is an expanded compressed instruction
+    input wire i_load_wait, //load at memory access stage is waiting for its ack (and can be parked)
+    input wire i_reserved, //reservation set by LR is valid (round-robin switch waits for the SC)
+    input wire i_wfi, //WFI at memory access stage waits for an interrupt
+    output wire o_wfi_switch, //switch thread at the WFI (WFI at memory access stage is not executed)
+    output wire o_park, //park the load at memory access stage (its data is written later to the register bank of this thread)
+    input wire i_bank, //register bank used by the running thread (1 = shadow registers)
+    output reg[2:0] o_park_bank, //{thread, bank} of the registers written by the parked load
+    input wire i_park_done, //data of the parked load is written to the base reg
+    // Stage 5 [WRITEBACK]
+    output reg o_switch_q, //high before switching thread (instruction at writeback stage)
+    output reg o_squash_q, //instruction at writeback stage is executed again when the thread runs again (not retired)
+    output reg[31:0] o_next_pc, //PC where the next thread resumes
+    input wire i_switch, //thread switch is done by writeback stage
+    input wire i_writeback_change_pc, //high if writeback will issue change_pc (which will override this stage)
+    /// Pipeline Control ///
+    input wire i_ce, // input clk enable for pipeline stalling of memory access stage
+    input wire i_stall //informs this stage to stall
+);
+    localparam RESERVED_LIMIT = QUANTUM + 64; //clock cycles a thread holding an LR reservation can run (constrained LR/SC loops have at most 16 instructions)
+    localparam QUANTUM_WIDTH = $clog2(RESERVED_LIMIT+1);
+    localparam LATENCY_WIDTH = (SWITCH_LATENCY > 1)? $clog2(SWITCH_LATENCY+1) : 1;
+    reg[31:0] resume_pc[THREADS-1:0]; //PC where each thread resumes
+    reg[THREADS-1:0] waiting; //thread waits for its parked load
+    reg[1:0] next_thread; //next ready thread after the running thread (round-robin)
+    reg next_ready; //high if another thread is ready
+    reg[1:0] next_thread_q; //thread to switch to at writeback stage
+    reg[31:0] save_pc_q; //PC where the running thread resumes after the switch at writeback stage
+    reg park_q; //switch at writeback stage is for a parked load
+    reg progress; //running thread has done an instruction since the last switch
+    reg[QUANTUM_WIDTH-1:0] quantum_count; //clock cycles the running thread has run
+    reg[LATENCY_WIDTH-1:0] wait_count; //clock cycles the load at memory access stage has waited for its ack
+    integer i, t;
+    //only instructions without side effects before writeback are executed again after a round-robin switch
+    wire switchable = i_opcode[`RTYPE] || i_opcode[`ITYPE] || i_opcode[`LUI] || i_opcode[`AUIPC] || i_opcode[`BRANCH] || i_opcode[`JAL] || i_opcode[`JALR];
+    wire quantum_switch = QUANTUM != 0 && quantum_count >= QUANTUM && (!i_reserved || quantum_count == RESERVED_LIMIT) && progress && i_ce && switchable && !i_exception && next_ready && !i_writeback_change_pc;
+
+    assign o_wfi_switch = i_wfi && i_ce && next_ready && !i_writeback_change_pc;
+    assign o_park = SWITCH_LATENCY != 0 && i_load_wait && wait_count == SWITCH_LATENCY && !i_exception && next_ready && !i_writeback_change_pc;
+
+    //next ready thread after the running thread (round-robin)
+    always @* begin
+        next_thread = o_thread;
+        next_ready = 0;
+        for(i = THREADS-1; i > 0; i = i - 1) begin //nearest thread wins
+            t = o_thread + i;
+            if(t >= THREADS) t = t - THREADS;
+            if(!waiting[t]) begin
+                next_thread = t;
+                next_ready = 1;
+            end
+        end
+    end
+
+    always @(posedge i_clk, negedge i_rst_n) begin
+        if(!i_rst_n) begin
+            o_thread <= 0;
+            o_switch_q <= 0;
+            o_squash_q <= 0;
+            park_q <= 0;
+            progress <= 0;
+            waiting <= 0;
+            quantum_count <= 0;
+            wait_count <= 0;
+            for(i = 0; i < THREADS; i = i + 1) resume_pc[i] <= PC_RESET;
+        end
+        else begin
+            //count clock cycles until the switch (saturates)
+            if(i_switch) quantum_count <= 0;
+            else if(quantum_count != RESERVED_LIMIT) quantum_count <= quantum_count + 1;
+            if(!i_load_wait) wait_count <= 0;
+            else if(wait_count != SWITCH_LATENCY) wait_count <= wait_count + 1;
+
+            //switch decided at memory access stage goes to writeback stage together with its instruction
+            if(!i_stall) begin
+                if(i_ce) begin
+                    o_switch_q <= o_park || quantum_switch || o_wfi_switch;
+                    o_squash_q <= (quantum_switch || o_wfi_switch) && !o_park;
+                    park_q <= o_park;
+                    next_thread_q <= next_thread;
+                    o_next_pc <= resume_pc[next_thread];
+                    if(o_park) o_park_bank <= {o_thread, i_bank};
+                    save_pc_q <= o_park? i_pc + ((C_EXTENSION != 0 && i_compressed)? 32'd2 : 32'd4) : i_pc; //parked load is done, squashed instruction is not
+                    if(!quantum_switch && !o_wfi_switch && !i_writeback_change_pc) progress <= 1;
+                end
+                else begin
+                    o_switch_q <= 0;
+                    o_squash_q <= 0;
+                    park_q <= 0;
+                end
+            end
+
+            //writeback stage switches to the next thread (running thread resumes later at save_pc_q)
+            if(i_switch) begin
+                resume_pc[o_thread] <= save_pc_q;
+                o_thread <= next_thread_q;
+                progress <= 0;
+                if(park_q) waiting[o_thread] <= 1;
+            end
+            //thread of the parked load is ready again once the load data is written
+            if(i_park_done) waiting[o_park_bank[2:1]] <= 0;
+        end
+    end
+
+endmodule
@@ -17,11 +17,21 @@ stages. Key functionalities of the rv32i_writeback module include:
     (i_csr_out) is written back. In other cases, the data is computed at the ALU
     stage (i_rd) and is written back. The o_wr_rd signal is set based on the i_wr_rd 
     input and the current pipeline control state (i_ce and o_stall). The destination 
-    register address (o_rd_addr) is passed through from the i_rd_addr input.
+    register address (o_rd_addr) is passed through from the i_rd_addr input. The rd
+    of the instruction issued together with it (second issue slot of dual issue) is 
+    written in the same clock cycle (o_slot1_wr_rd) unless the pipeline goes to trap,
+    returns from trap, or fetches the next instructions again.
+ - Register bank switch: When a CSR write switches the register bank (i_bank_switch),
+    the instructions after it are fetched again so they read the new register bank.
+ - Thread switch: When the thread scheduler switches thread (i_thread_switch), the pipeline
+    is flushed and the next thread is fetched from its resume PC (i_thread_pc). The rd of the
+    instruction is not written (it is either a parked load whose rd is written later or an
+    instruction executed again when its thread runs again).
  - Trap-handler control: The module handles interrupts and exceptions by checking the
     i_go_to_trap and i_return_from_trap input signals. When the processor goes to a 
     trap, the o_next_pc register is set to the trap address (i_trap_address) and the
-    pipeline is flushed. When the processor returns from a trap, the o_next_pc register
+    pipeline is flushed, unless the ALU stage already fetched the trap handler of an
+    ECALL, EBREAK, or illegal instruction (i_trap_fetched). When the processor returns from a trap, the o_next_pc register
     is set to the return address (i_return_address) and the pipeline is flushed.
  - Pipeline control: The module can stall the pipeline by asserting the o_stall signal
     when necessary. It can also flush the current stage and previous stages by asserting
@@ -40,6 +50,7 @@ module rv32i_writeback (
     input wire[31:0] i_csr_out, //CSR value to be loaded to basereg
     input wire i_opcode_load,
     input wire i_opcode_system, 
+    input wire i_opcode_fence,
     // Basereg Control
     input wire i_wr_rd, //write rd to basereg if enabled (from previous stage)
     output reg o_wr_rd, //write rd to the base reg if enabled
@@ -47,15 +58,24 @@ module rv32i_writeback (
     output reg[4:0] o_rd_addr, //address for destination register
     input wire[31:0] i_rd, //value to be written back to destination register (from previous stage)
     output reg[31:0] o_rd, //value to be written back to destination register
+    input wire i_slot1_wr_rd, //write rd of second issue slot to basereg if enabled (from previous stage)
+    output reg o_slot1_wr_rd, //write rd of second issue slot to the base reg if enabled
     // PC Control
     input wire[31:0] i_pc, // pc value (from previous stage)
     output reg[31:0] o_next_pc, //new pc value
     output reg o_change_pc, //high if PC needs to jump
+    output reg o_fence_i, //high if FENCE.I is executed (invalidate instruction cache and fetch again the next instructions)
     // Trap-Handler
     input wire i_go_to_trap, //high before going to trap (if exception/interrupt detected)
+    input wire i_trap_fetched, //trap handler is already fetched by ALU stage (pipeline is not flushed)
     input wire i_return_from_trap, //high before returning from trap (via mret)
+    input wire i_bank_switch, //high before switching the register bank by a CSR write (fetch again the next instructions)
     input wire[31:0] i_return_address, //mepc CSR
     input wire[31:0] i_trap_address, //mtvec CSR
+    // Multithreading
+    input wire i_thread_switch, //high before switching to the next thread
+    input wire[31:0] i_thread_pc, //PC where the next thread resumes
+    output reg o_thread_switch, //high if the thread switch is done
     /// Pipeline Control ///
     input wire i_ce, // input clk enable for pipeline stalling of this stage
     output reg o_stall, //informs pipeline to stall
@@ -67,16 +87,20 @@ module rv32i_writeback (
         o_stall = 0; //stall when this stage needs wait time
         o_flush = 0; //flush this stage along with previous stages when changing PC
         o_wr_rd = i_wr_rd && i_ce && !o_stall;
+        o_slot1_wr_rd = i_slot1_wr_rd && i_ce && !o_stall;
         o_rd_addr = i_rd_addr;
         o_rd = 0;
         o_next_pc = 0;
         o_change_pc = 0;
+        o_fence_i = 0;
+        o_thread_switch = 0;
 
         if(i_go_to_trap) begin
-            o_change_pc = 1; //change PC only when ce of this stage is high (o_change_pc is valid)
+            o_change_pc = !i_trap_fetched; //change PC only when ce of this stage is high (o_change_pc is valid)
             o_next_pc = i_trap_address;  //interrupt or exception detected so go to trap address (mtvec value)
-            o_flush = i_ce;
+            o_flush = i_ce && !i_trap_fetched; //instructions after an early-fetched trap are already the trap handler
             o_wr_rd = 0;
+            o_slot1_wr_rd = 0;
         end
         
         else if(i_return_from_trap) begin
@@ -84,6 +108,32 @@ module rv32i_writeback (
              o_next_pc = i_return_address; //return from trap via mret (mepc value)
              o_flush = i_ce;
              o_wr_rd = 0;
+             o_slot1_wr_rd = 0;
+        end
+        
+        else if(i_bank_switch) begin //CSR write switched the register bank (next instructions must read the new register bank)
+            o_change_pc = i_ce; 
+            o_next_pc = i_pc + 4;
+            o_flush = i_ce;
+            o_rd = i_csr_out; //rd of CSR instruction is still written to the old register bank
+            o_slot1_wr_rd = 0;
+        end
+        
+        else if(i_opcode_fence && i_funct3 == 3'b001) begin //FENCE.I (all previous stores are already written to memory)
+            o_fence_i = i_ce;
+            o_change_pc = i_ce; //instructions after FENCE.I must be fetched again
+            o_next_pc = i_pc + 4;
+            o_flush = i_ce;
+            o_slot1_wr_rd = 0;
+        end
+        
+        else if(i_thread_switch) begin //switch to the next thread (fetch from its resume PC)
+            o_thread_switch = i_ce;
+            o_change_pc = i_ce;
+            o_next_pc = i_thread_pc;
+            o_flush = i_ce;
+            o_wr_rd = 0; //rd of parked load is written later, squashed instruction is executed again
+            o_slot1_wr_rd = 0;
         end
         
         else begin //normal operation
@@ -13,6 +13,7 @@ _start:
         # it has to be copied over from Flash to RAM by the startup code.
      # 6. Set-up call to main function
      # 7. Set-up exit routine
+     # Harts other than hart 0 (multi-hart rv32i_soc) do not run the program and just wait in a loop.
            
      # Initialize base registers to zero
         li  x0, 0       
@@ -47,6 +48,10 @@ _start:
         li  x29, 0        
         li  x30, 0       
         li  x31, 0       
+
+    # Only hart 0 runs the program
+        csrr t0, mhartid
+        bnez t0, secondary_hart_wait
         
     # Set-up stack pointer
         la sp, __stack_pointer
@@ -78,6 +83,10 @@ _start:
         li    a0, 0         # set a0 (x10) to 0 to indicate a pass code
         li    a7, 93        # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
         ebreak
+
+    # Harts other than hart 0 wait here
+    secondary_hart_wait:
+        j    secondary_hart_wait
         
         
         
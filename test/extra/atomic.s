@@ -0,0 +1,140 @@
+#
+# TEST CODE FOR ATOMIC INSTRUCTIONS (RV32A)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      s0, data
+
+        # lr/sc: successful pair updates memory and returns 0
+        lr.w    a0, (s0)        # a0 = 0x00000010
+        li      a5, 0x10
+        bne     a0, a5, fail
+        addi    a0, a0, 1
+        sc.w    a1, a0, (s0)    # data = 0x00000011
+        bnez    a1, fail
+        lw      a2, 0(s0)
+        li      a5, 0x11
+        bne     a2, a5, fail
+
+        # sc without a reservation (cleared by the previous sc) fails and does not write
+        li      a0, 0x55
+        sc.w    a1, a0, (s0)
+        beqz    a1, fail
+        lw      a2, 0(s0)
+        li      a5, 0x11
+        bne     a2, a5, fail
+
+        # sc to a different address than the reservation fails
+        addi    s1, s0, 4
+        lr.w    a0, (s0)
+        sc.w    a1, a0, (s1)
+        beqz    a1, fail
+        lw      a2, 0(s1)
+        li      a5, -8
+        bne     a2, a5, fail
+
+        # lr/sc retry loop (atomic increment)
+        li      a3, 3
+retry:  lr.w    a0, (s0)
+        addi    a0, a0, 1
+        sc.w    a1, a0, (s0)
+        bnez    a1, retry
+        addi    a3, a3, -1
+        bnez    a3, retry
+        lw      a2, 0(s0)
+        li      a5, 0x14
+        bne     a2, a5, fail
+
+        # amo: rd gets the original value, memory gets the new value
+        li      a0, 5           # mem at s1 = 0xfffffff8 (-8)
+        amoadd.w a1, a0, (s1)   # mem = -3
+        li      a5, -8
+        bne     a1, a5, fail
+        li      a0, 0x0f
+        amoxor.w a1, a0, (s1)   # mem = 0xfffffff2
+        li      a5, -3
+        bne     a1, a5, fail
+        li      a0, 0xff
+        amoand.w a1, a0, (s1)   # mem = 0x000000f2
+        li      a5, 0xfffffff2
+        bne     a1, a5, fail
+        li      a0, 0x100
+        amoor.w a1, a0, (s1)    # mem = 0x000001f2
+        li      a5, 0xf2
+        bne     a1, a5, fail
+        li      a0, -1
+        amomin.w a1, a0, (s1)   # mem = -1 (signed)
+        li      a5, 0x1f2
+        bne     a1, a5, fail
+        li      a0, 7
+        amomax.w a1, a0, (s1)   # mem = 7 (signed)
+        li      a5, -1
+        bne     a1, a5, fail
+        li      a0, -1
+        amominu.w a1, a0, (s1)  # mem = 7 (unsigned)
+        li      a5, 7
+        bne     a1, a5, fail
+        amomaxu.w a1, a0, (s1)  # mem = 0xffffffff (unsigned)
+        li      a5, 7
+        bne     a1, a5, fail
+        li      a0, 0x1234
+        amoswap.w a1, a0, (s1)  # mem = 0x00001234
+        li      a5, -1
+        bne     a1, a5, fail
+        lw      a2, 0(s1)
+        li      a5, 0x1234
+        bne     a2, a5, fail
+
+        # amo result used by the next instruction (forwarding) and rd = x0
+        amoadd.w a1, a0, (s1)   # mem = 0x00002468
+        addi    a1, a1, 1
+        li      a5, 0x1235
+        bne     a1, a5, fail
+        amoadd.w x0, a0, (s1)   # mem = 0x0000369c
+        lw      a2, 0(s1)
+        li      a5, 0x369c
+        bne     a2, a5, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000010
+        .word 0xfffffff8
+        .word 0x00000000
+        .word 0x00000000
@@ -0,0 +1,148 @@
+#
+# TEST CODE FOR BIT-MANIPULATION INSTRUCTIONS (Zba AND Zbb)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # address generation (Zba)
+        li      x2, 5
+        li      x3, 0x1000
+        sh1add  x4, x2, x3      # x4 = 0x100a
+        li      x5, 0x100a
+        bne     x4, x5, fail
+        sh2add  x4, x2, x3      # x4 = 0x1014
+        li      x5, 0x1014
+        bne     x4, x5, fail
+        sh3add  x4, x2, x3      # x4 = 0x1028
+        li      x5, 0x1028
+        bne     x4, x5, fail
+
+        # logic with negate
+        li      x2, 0xff00ff00
+        li      x3, 0x0ff00ff0
+        andn    x4, x2, x3      # x4 = 0xf000f000
+        li      x5, 0xf000f000
+        bne     x4, x5, fail
+        orn     x4, x2, x3      # x4 = 0xff0fff0f
+        li      x5, 0xff0fff0f
+        bne     x4, x5, fail
+        xnor    x4, x2, x3      # x4 = 0x0f0f0f0f
+        li      x5, 0x0f0f0f0f
+        bne     x4, x5, fail
+
+        # count leading/trailing zeros and set bits
+        li      x2, 0x00012300
+        clz     x4, x2          # x4 = 15
+        li      x5, 15
+        bne     x4, x5, fail
+        ctz     x4, x2          # x4 = 8
+        li      x5, 8
+        bne     x4, x5, fail
+        cpop    x4, x2          # x4 = 4
+        li      x5, 4
+        bne     x4, x5, fail
+        clz     x4, x0          # x4 = 32
+        li      x5, 32
+        bne     x4, x5, fail
+        ctz     x4, x0          # x4 = 32
+        bne     x4, x5, fail
+        li      x2, -1
+        cpop    x4, x2          # x4 = 32
+        bne     x4, x5, fail
+
+        # signed and unsigned minimum/maximum
+        li      x2, -2
+        li      x3, 3
+        min     x4, x2, x3      # x4 = -2
+        bne     x4, x2, fail
+        max     x4, x2, x3      # x4 = 3
+        bne     x4, x3, fail
+        minu    x4, x2, x3      # x4 = 3
+        bne     x4, x3, fail
+        maxu    x4, x2, x3      # x4 = -2
+        bne     x4, x2, fail
+
+        # sign and zero extension
+        li      x2, 0x12348281
+        sext.b  x4, x2          # x4 = 0xffffff81
+        li      x5, 0xffffff81
+        bne     x4, x5, fail
+        sext.h  x4, x2          # x4 = 0xffff8281
+        li      x5, 0xffff8281
+        bne     x4, x5, fail
+        zext.h  x4, x2          # x4 = 0x00008281
+        li      x5, 0x00008281
+        bne     x4, x5, fail
+
+        # rotate
+        li      x2, 0x80000001
+        li      x3, 4
+        rol     x4, x2, x3      # x4 = 0x00000018
+        li      x5, 0x18
+        bne     x4, x5, fail
+        ror     x4, x2, x3      # x4 = 0x18000000
+        li      x5, 0x18000000
+        bne     x4, x5, fail
+        rori    x4, x2, 1       # x4 = 0xc0000000
+        li      x5, 0xc0000000
+        bne     x4, x5, fail
+        rol     x4, x2, x0      # x4 = 0x80000001
+        bne     x4, x2, fail
+
+        # byte operations
+        li      x2, 0x12003400
+        orc.b   x4, x2          # x4 = 0xff00ff00
+        li      x5, 0xff00ff00
+        bne     x4, x5, fail
+        rev8    x4, x2          # x4 = 0x00340012
+        li      x5, 0x00340012
+        bne     x4, x5, fail
+
+        # operand from a load (load-use) and result used right away
+        la      x8, data
+        lw      x2, 0(x8)       # x2 = 0x00f00000
+        clz     x4, x2          # x4 = 8
+        sh2add  x4, x4, x8      # x4 = data + 32
+        addi    x4, x4, -32
+        bne     x4, x8, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00f00000
+
@@ -0,0 +1,123 @@
+#
+# TEST CODE FOR BRANCH PREDICTION
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # backward loop branch: taken 9 times then not-taken on exit
+        li      x1, 0           # x1 = loop counter
+        li      x2, 10          # x2 = loop count
+        li      x3, 0           # x3 = sum
+loop1:
+        addi    x1, x1, 1
+        add     x3, x3, x1      # sum = 1+2+...+10 = 55
+        bne     x1, x2, loop1   # backward branch (taken 9 times)
+        li      x4, 55
+        bne     x3, x4, fail
+
+        # alternating forward branch inside a loop: taken on odd iterations only
+        li      x1, 0
+        li      x3, 0           # x3 = number of odd iterations
+        li      x5, 0           # x5 = number of even iterations
+loop2:
+        addi    x1, x1, 1
+        andi    x6, x1, 1
+        beqz    x6, even        # forward branch (alternates taken/not-taken)
+        addi    x3, x3, 1
+        j       next
+even:
+        addi    x5, x5, 1
+next:
+        bne     x1, x2, loop2
+        li      x4, 5
+        bne     x3, x4, fail
+        bne     x5, x4, fail
+
+        # branch that is always taken then changes direction (predictor must recover)
+        li      x1, 0
+        li      x3, 0
+loop3:
+        addi    x1, x1, 1
+        slti    x6, x1, 8       # x6 = 1 for first 7 iterations
+        bnez    x6, skip        # taken 7 times, then not-taken
+        addi    x3, x3, 1       # executed only when not-taken (3 times)
+skip:
+        bne     x1, x2, loop3
+        li      x4, 3
+        bne     x3, x4, fail
+
+        # jal/jalr called repeatedly from different places (BTB must not cause wrong return address)
+        li      x11, 0          # x11 = loop counter (x1 is the return address)
+        li      x3, 0
+loop4:
+        jal     ra, func        # x3 += 1
+        jal     ra, func        # x3 += 1
+        addi    x11, x11, 1
+        bne     x11, x2, loop4
+        li      x4, 20
+        bne     x3, x4, fail
+
+        # indirect jump with changing target
+        li      x1, 0
+        li      x3, 0
+        la      x7, target1
+        la      x8, target2
+loop5:
+        andi    x6, x1, 1
+        mv      x9, x7
+        beqz    x6, jump
+        mv      x9, x8
+jump:
+        jalr    x0, 0(x9)       # alternates between target1 and target2
+target1:
+        addi    x3, x3, 1       # target1 adds 1 (then falls through to target2)
+target2:
+        addi    x3, x3, 1       # target2 adds 1
+        addi    x1, x1, 1
+        bne     x1, x2, loop5
+        li      x4, 15          # 5*2 + 5*1
+        bne     x3, x4, fail
+
+        j   pass
+
+func:
+        addi    x3, x3, 1
+        ret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+
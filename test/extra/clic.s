@@ -0,0 +1,220 @@
+#
+# TEST CODE FOR CLIC INTERRUPT CONTROLLER (level threshold, preemption, selective hardware vectoring, only tested when CLIC is enabled)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+        .equ    mtvt, 0x307             # base address of jump table of interrupts with selective hardware vectoring
+        .equ    mintthresh, 0x347       # interrupt level threshold
+        .equ    mintstatus, 0xfb1       # [31:24] = interrupt level of running trap handler
+        .equ    clicint3, 0xbc3         # {clicintctl, clicintattr, clicintie, clicintip} of software interrupt (id 3)
+        .equ    clicint7, 0xbc7         # timer interrupt (id 7)
+        .equ    clicint11, 0xbcb        # external interrupt (id 11)
+        .equ    mbank, 0x7c0            # register bank (when SHADOW_REGS is enabled, trap handlers use the shadow bank)
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # detect the CLIC (mtvt reads as zero if not implemented)
+        la      t0, jump_table
+        csrw    mtvt, t0
+        csrr    t1, mtvt
+        beqz    t1, pass                # no CLIC
+        bne     t0, t1, fail
+        la      t0, trap_handler
+        ori     t0, t0, 3               # CLIC interrupt mode
+        csrw    mtvec, t0
+        csrwi   mbank, 1                # registers of trap handlers are initialized in both register banks
+        la      s0, data                # log of trap handler entries {mcause.interrupt, mcause.mpil, mintstatus.mil, mcause.id}
+        addi    sp, s0, 64              # stack pointer of trap handlers
+        csrwi   mbank, 0
+        la      s0, data
+        addi    sp, s0, 64
+        la      s1, data
+        csrr    t0, mintstatus
+        bnez    t0, fail
+
+        # interrupt with level not above the threshold is not taken
+        li      t0, 0x40
+        csrw    mintthresh, t0
+        li      t0, 0x40020101          # level 0x40, edge-triggered, enabled, pending
+        csrw    clicint3, t0
+        csrsi   mstatus, 8              # global interrupt enable
+        nop
+        nop
+        nop
+        nop
+        lw      t1, 0(s1)
+        bnez    t1, fail                # no interrupt taken
+        csrr    t1, clicint3
+        bne     t0, t1, fail            # still pending
+
+        # interrupt is taken after lowering the threshold
+        li      t0, 0x3f
+        csrw    mintthresh, t0
+        nop
+        nop
+        csrci   mstatus, 8
+        csrw    mintthresh, zero
+        lw      t1, 0(s1)
+        beqz    t1, fail
+        lw      t1, 4(s1)
+        bnez    t1, fail                # one interrupt taken
+        csrr    t1, clicint3
+        andi    t1, t1, 1
+        bnez    t1, fail                # edge-triggered interrupt is no longer pending
+        csrr    t1, mintstatus
+        bnez    t1, fail                # mret restored the interrupt level
+
+        # nested interrupts: external (level 0x20) is preempted by timer (level 0x80, hardware vectored)
+        # then software interrupt (level 0x40) waits until the timer handler returns and preempts the external handler
+        li      t0, 0x80030100          # level 0x80, edge-triggered, hardware vectored, enabled, not pending
+        csrw    clicint7, t0
+        li      t0, 0x20020101          # level 0x20, edge-triggered, enabled, pending
+        csrsi   mstatus, 8
+        csrw    clicint11, t0
+        nop
+        nop
+        csrci   mstatus, 8
+        csrr    t1, mintstatus
+        bnez    t1, fail
+
+        # check the log of trap handler entries
+        lw      t0, 16(s1)
+        bnez    t0, fail                # four interrupts taken
+        mv      t1, s1
+        lw      t0, 0(t1)
+        li      t2, 0x80004003          # software interrupt: level 0x40, previous level 0
+        bne     t0, t2, fail
+        lw      t0, 4(t1)
+        li      t2, 0x8000200b          # external interrupt: level 0x20, previous level 0
+        bne     t0, t2, fail
+        lw      t0, 8(t1)
+        li      t2, 0x80208007          # timer interrupt: level 0x80, previous level 0x20
+        bne     t0, t2, fail
+        lw      t0, 12(t1)
+        li      t2, 0x80204003          # software interrupt: level 0x40, previous level 0x20
+        bne     t0, t2, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+trap_handler:                           # common handler (interrupts without hardware vectoring)
+        addi    sp, sp, -12
+        csrr    t0, mepc
+        sw      t0, 0(sp)
+        csrr    t0, mcause
+        sw      t0, 4(sp)
+        csrr    t1, mbank
+        sw      t1, 8(sp)
+        li      t1, 0x80ff001f
+        and     t0, t0, t1
+        csrr    t1, mintstatus
+        srli    t1, t1, 16
+        or      t0, t0, t1
+        sw      t0, 0(s0)               # log entry
+        addi    s0, s0, 4
+        andi    t0, t0, 31
+        li      t1, 11
+        bne     t0, t1, trap_return
+        li      t0, 0x80030101          # external handler makes the timer interrupt pending
+        csrw    clicint7, t0
+        csrsi   mstatus, 8              # allow preemption by higher level interrupts
+        nop
+        nop
+        nop
+        nop
+        csrci   mstatus, 8
+trap_return:
+        lw      t0, 0(sp)
+        csrw    mepc, t0
+        lw      t0, 4(sp)
+        csrw    mcause, t0              # also restores mcause.mpil
+        lw      t0, 8(sp)
+        csrw    mbank, t0               # register bank restored by mret
+        addi    sp, sp, 12
+        mret
+
+timer_handler:                          # hardware vectored handler
+        csrr    t0, mcause
+        li      t1, 0x80ff001f
+        and     t0, t0, t1
+        csrr    t1, mintstatus
+        srli    t1, t1, 16
+        or      t0, t0, t1
+        sw      t0, 0(s0)               # log entry
+        addi    s0, s0, 4
+        li      t0, 0x40020101          # lower level software interrupt does not preempt this handler
+        csrw    clicint3, t0
+        csrsi   mstatus, 8
+        nop
+        nop
+        nop
+        nop
+        csrci   mstatus, 8
+        lw      t0, 0(s0)
+        bnez    t0, fail
+        mret
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+        .align  6               # jump table is 64-byte aligned (entry id = jump to handler of interrupt id)
+jump_table:
+        j       fail
+        j       fail
+        j       fail
+        j       fail
+        j       fail
+        j       fail
+        j       fail
+        j       timer_handler
+        j       fail
+        j       fail
+        j       fail
+        j       fail
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
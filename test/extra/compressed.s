@@ -0,0 +1,157 @@
+#
+# TEST CODE FOR COMPRESSED INSTRUCTIONS (RV32C)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+        .option rvc     # compressed instructions are enabled only in this test (-march has no C)
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # register-immediate and register-register operations
+        c.li    a0, 5
+        c.addi  a0, 12          # a0 = 17
+        li      a5, 17
+        bne     a0, a5, fail
+        c.li    a1, -3
+        c.add   a0, a1          # a0 = 14
+        li      a5, 14
+        bne     a0, a5, fail
+        c.sub   a0, a1          # a0 = 17
+        li      a5, 17
+        bne     a0, a5, fail
+        c.mv    a2, a0          # a2 = 17
+        bne     a2, a5, fail
+        c.li    a3, 0x0c
+        c.and   a2, a3          # a2 = 0x00
+        bnez    a2, fail
+        c.or    a2, a3          # a2 = 0x0c
+        c.xor   a2, a0          # a2 = 0x1d
+        li      a5, 0x1d
+        bne     a2, a5, fail
+        c.andi  a2, 0x0f        # a2 = 0x0d
+        li      a5, 0x0d
+        bne     a2, a5, fail
+        c.slli  a2, 28          # a2 = 0xd0000000
+        c.srai  a2, 4           # a2 = 0xfd000000
+        li      a5, 0xfd000000
+        bne     a2, a5, fail
+        c.srli  a2, 24          # a2 = 0xfd
+        li      a5, 0xfd
+        bne     a2, a5, fail
+        c.lui   a3, 0x1f        # a3 = 0x1f000
+        li      a5, 0x1f000
+        bne     a3, a5, fail
+
+        # loads and stores (sp-relative and register-relative)
+        la      sp, data
+        c.addi16sp sp, 32       # sp = data + 32
+        c.addi4spn s0, sp, 8    # s0 = data + 40
+        c.lw    a0, 0(s0)       # a0 = 0x12345678
+        li      a5, 0x12345678
+        bne     a0, a5, fail
+        c.swsp  a0, 4(sp)       # data + 36 = 0x12345678
+        c.lwsp  a1, 4(sp)
+        bne     a1, a5, fail
+        c.li    a0, -1
+        c.sw    a0, 4(s0)       # data + 44 = 0xffffffff
+        lw      a1, 12(sp)
+        bne     a0, a1, fail
+
+        # 32-bit instructions straddling two words (misaligned by a compressed instruction)
+        c.li    a0, 0
+        .option norvc
+        addi    a0, a0, 1
+        addi    a0, a0, 2
+        .option rvc
+        c.addi  a0, 4
+        .option norvc
+        addi    a0, a0, 8
+        .option rvc
+        c.nop
+        .option norvc
+        addi    a0, a0, 16
+        .option rvc
+        li      a5, 31
+        bne     a0, a5, fail
+
+        # compressed branches and jumps (taken and not taken, halfword-aligned targets)
+        c.li    a0, 0
+        c.li    a1, 3
+loop:   c.addi  a0, 2
+        c.addi  a1, -1
+        c.bnez  a1, loop        # a0 = 6
+        li      a5, 6
+        bne     a0, a5, fail
+        c.beqz  a1, skip1
+        j       fail
+skip1:  c.nop
+        c.j     skip2
+        j       fail
+skip2:  c.jal   func            # a0 = 7
+        li      a5, 7
+        bne     a0, a5, fail
+        la      a2, func
+        c.jalr  a2              # a0 = 8
+        li      a5, 8
+        bne     a0, a5, fail
+        la      a2, skip3
+        c.jr    a2
+        j       fail
+        c.nop
+skip3:  .option norvc
+        jal     x1, func        # a0 = 9 (32-bit jump returning to a compressed instruction)
+        .option rvc
+        c.li    a5, 9
+        bne     a0, a5, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+func:   c.addi  a0, 1
+        c.jr    ra
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x00000000
+        .word 0x12345678
+        .word 0x00000000
@@ -0,0 +1,116 @@
+#
+# TEST CODE FOR COPROCESSOR INTERFACE (custom instructions of the example accelerator in rv32i_soc: multi-cycle CRC-32 and multiply-accumulate)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # crc32.b (custom-0, funct3 = 0): CRC-32 of "123456789" one byte at a time
+        la      s0, data
+        li      s1, 9
+        li      a0, -1                  # initial value
+        mv      t0, s0
+crc_loop:
+        lbu     t1, 0(t0)
+        .insn r CUSTOM_0, 0, 0, a0, a0, t1      # result used right away by the next crc32.b
+        addi    t0, t0, 1
+        addi    s1, s1, -1
+        bnez    s1, crc_loop
+        not     a0, a0                  # final value
+        li      a1, 0xcbf43926
+        bne     a0, a1, fail
+
+        # crc32.w and crc32.h (funct3 = 2 and 1) back-to-back, then crc32.b
+        li      a2, -1
+        lw      t1, 0(s0)               # "1234"
+        lw      t2, 4(s0)               # "5678"
+        lhu     t3, 8(s0)               # "9"
+        .insn r CUSTOM_0, 2, 0, a2, a2, t1
+        .insn r CUSTOM_0, 2, 0, a2, a2, t2
+        .insn r CUSTOM_0, 0, 0, a2, a2, t3
+        not     a2, a2
+        bne     a2, a1, fail
+        li      a3, -1
+        lhu     t1, 0(s0)               # "12"
+        lhu     t2, 2(s0)               # "34"
+        .insn r CUSTOM_0, 1, 0, a3, a3, t1
+        .insn r CUSTOM_0, 1, 0, a3, a3, t2
+        li      a4, -1
+        lw      t1, 0(s0)
+        .insn r CUSTOM_0, 2, 0, a4, a4, t1      # same CRC as the two halfwords
+        bne     a3, a4, fail
+
+        # mac and swap (custom-1, funct3 = 0 and 1): accumulator inside the coprocessor
+        li      t1, 3
+        li      t2, 4
+        .insn r CUSTOM_1, 1, 0, s2, zero, zero  # acc = 0
+        .insn r CUSTOM_1, 0, 0, s3, t1, t2      # acc = 12
+        li      t1, 5
+        li      t2, 6
+        .insn r CUSTOM_1, 0, 0, zero, t1, t2    # acc = 42 (rd = x0 is not written)
+        .insn r CUSTOM_1, 1, 0, s4, t2, zero    # s4 = 42, acc = 6
+        .insn r CUSTOM_1, 0, 0, s5, s4, t1      # acc = 6 + 42*5 = 216
+        li      a1, 12
+        bne     s3, a1, fail
+        li      a1, 42
+        bne     s4, a1, fail
+        li      a1, 216
+        bne     s5, a1, fail
+
+        # result of custom instruction used as address of a load, and stored to memory
+        li      t1, 1
+        .insn r CUSTOM_1, 1, 0, zero, s0, zero  # acc = data address
+        .insn r CUSTOM_1, 0, 0, s6, t1, t1      # s6 = data address + 1
+        lbu     s7, 0(s6)
+        li      a1, 0x32                # "2"
+        bne     s7, a1, fail
+        .insn r CUSTOM_1, 0, 0, s8, t1, t1      # s8 = data address + 2
+        sw      s8, 12(s0)
+        lw      s9, 12(s0)
+        bne     s9, s8, fail
+
+        # unimplemented custom instruction writes 0
+        li      s10, -1
+        .insn r CUSTOM_0, 7, 0, s10, t1, t1
+        bnez    s10, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x34333231        # "1234"
+        .word 0x38373635        # "5678"
+        .word 0x00000039        # "9"
+        .word 0x00000000
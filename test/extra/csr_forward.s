@@ -0,0 +1,117 @@
+#
+# TEST CODE FOR CSR READ FORWARDING
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      x8, data        # x8 = base address of data
+        li      x2, 0x12345678
+        csrw    mscratch, x2
+
+        # CSR value used right away as rs1
+        csrr    x3, mscratch
+        addi    x4, x3, 1       # x4 = 0x12345679
+        li      x5, 0x12345679
+        bne     x4, x5, fail
+
+        # CSR value used right away as rs2
+        csrr    x3, mscratch
+        sub     x4, x0, x3      # x4 = -0x12345678
+        li      x5, -0x12345678
+        bne     x4, x5, fail
+
+        # old CSR value of a CSR swap used right away, new value is written in order
+        li      x6, 0x0badf00d
+        csrrw   x3, mscratch, x6
+        xor     x4, x3, x2      # x4 = 0 (old value)
+        bnez    x4, fail
+        csrrs   x3, mscratch, x0
+        bne     x3, x6, fail    # CSR value used right away by a branch
+        csrrci  x3, mscratch, 0x0d
+        csrr    x4, mscratch
+        and     x4, x4, x3      # x4 = 0x0badf000
+        li      x5, 0x0badf000
+        bne     x4, x5, fail
+
+        # CSR value used right away as store data and as store address
+        csrw    mscratch, x8
+        csrr    x3, mscratch
+        sw      x2, 0(x3)       # data[0] = 0x12345678
+        csrr    x3, mscratch
+        sw      x3, 4(x8)       # data[1] = address of data
+        lw      x4, 0(x8)
+        bne     x4, x2, fail
+        lw      x4, 4(x8)
+        bne     x4, x8, fail
+
+        # CSR value used by the next two instructions
+        csrr    x3, mscratch
+        add     x4, x3, x3
+        sub     x4, x4, x3
+        bne     x4, x8, fail
+
+        # back-to-back cycle counter reads (timing code), the counter only moves forward
+        csrr    x3, mcycle
+        csrr    x4, mcycle
+        sub     x5, x4, x3
+        blez    x5, fail
+        li      x6, 8
+        bgeu    x5, x6, fail
+
+        # trap entry reads mcause and mepc and uses them right away
+        la      x6, trap_handler
+        csrw    mtvec, x6
+        li      x9, 0           # x9 = number of traps
+        .word   0xffffffff      # illegal instruction (an ecall would end the simulation)
+        li      x5, 1
+        bne     x9, x5, fail
+
+        j   pass
+
+trap_handler:
+        csrr    x3, mcause
+        addi    x4, x3, -2      # mcause = 2 (illegal instruction)
+        bnez    x4, fail
+        csrr    x3, mepc
+        addi    x3, x3, 4       # return after the illegal instruction
+        csrw    mepc, x3
+        addi    x9, x9, 1
+        mret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000000
+        .word 0x00000000
@@ -0,0 +1,108 @@
+#
+# TEST CODE FOR DATA CACHE (LINE CONFLICTS AND WRITEBACK OF DIRTY LINES)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      x8, data        # x8 = base address of data
+        li      x9, 1024        # x9 = stride (addresses 1KB apart map to the same cache set)
+
+        # store to 4 addresses mapped to the same set (dirty lines are evicted)
+        mv      x3, x8
+        li      x4, 0x11111111
+        li      x5, 4
+store_loop:
+        sw      x4, 0(x3)
+        sb      x5, 5(x3)       # byte store to the same line
+        add     x3, x3, x9
+        add     x4, x4, x4
+        addi    x5, x5, -1
+        bnez    x5, store_loop
+
+        # load back in reverse order (evicted lines are refilled from memory)
+        li      x5, 3
+load_loop:
+        mv      x3, x8
+        mv      x6, x5
+addr_loop:
+        beqz    x6, addr_done
+        add     x3, x3, x9
+        addi    x6, x6, -1
+        j       addr_loop
+addr_done:
+        li      x4, 0x11111111
+        mv      x6, x5
+val_loop:
+        beqz    x6, val_done
+        add     x4, x4, x4
+        addi    x6, x6, -1
+        j       val_loop
+val_done:
+        lw      x7, 0(x3)
+        bne     x7, x4, fail
+        lbu     x7, 5(x3)
+        li      x6, 4
+        sub     x6, x6, x5      # byte stored is 4 - index
+        bne     x7, x6, fail
+        addi    x5, x5, -1
+        bgez    x5, load_loop
+
+        # load right after store to the same word and to the same line
+        sw      x9, 8(x8)
+        lw      x7, 8(x8)
+        bne     x7, x9, fail
+        sh      x0, 8(x8)
+        lw      x7, 8(x8)
+        bnez    x7, fail
+        sw      x9, 12(x8)
+        lhu     x7, 12(x8)
+        bne     x7, x9, fail
+
+        # FENCE.I writes back all dirty lines then data is still correct
+        fence.i
+        lw      x7, 0(x8)
+        li      x4, 0x11111111
+        bne     x7, x4, fail
+        lw      x7, 12(x8)
+        bne     x7, x9, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .space 4096
+
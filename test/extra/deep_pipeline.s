@@ -0,0 +1,123 @@
+#
+# TEST CODE FOR DEEPER PIPELINE (forwarding from the ALU stage, load/CSR to use, registered misprediction)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # chain of dependent ALU instructions (rs1, rs2, and both from the previous instruction)
+        li      t0, 3
+        addi    t1, t0, 4               # t1 = 7
+        add     t2, t0, t1              # t2 = 10
+        sub     t3, t2, t2              # t3 = 0
+        or      t4, t3, t1              # t4 = 7
+        slli    t4, t4, 2               # t4 = 28
+        li      a1, 28
+        bne     t4, a1, fail
+
+        # result of previous and second previous instructions used together
+        li      s2, 0x100
+        li      s3, 0x23
+        add     s4, s3, s2              # s4 = 0x123
+        add     s5, s4, s3              # s5 = 0x146
+        li      a1, 0x146
+        bne     s5, a1, fail
+
+        # load and CSR results used right away
+        la      s0, data
+        lw      s6, 0(s0)
+        addi    s6, s6, 1               # s6 = 0x1235
+        li      a1, 0x1235
+        bne     s6, a1, fail
+        csrw    mscratch, s6
+        csrr    s7, mscratch
+        add     s7, s7, s7              # s7 = 0x246a
+        li      a1, 0x246a
+        bne     s7, a1, fail
+
+        # store data and load address from the previous instruction
+        addi    s8, s6, 2               # s8 = 0x1237
+        sw      s8, 4(s0)
+        addi    s9, s0, 4
+        lw      s10, 0(s9)
+        bne     s10, s8, fail
+
+        # jump target from the previous instruction
+        la      s11, target
+        jalr    ra, 0(s11)
+        j       fail
+target:
+
+        # instructions after a mispredicted branch are not executed
+        li      a2, 5
+        li      a3, 5
+        beq     a2, a3, taken
+        li      a2, 9
+        li      a3, 9
+        j       fail
+taken:
+        addi    a2, a2, 1               # uses a2 of the instruction before the branch
+        li      a1, 6
+        bne     a2, a1, fail
+
+        # result used by a branch right away in a loop
+        li      a4, 8
+        li      a5, 0
+loop:
+        addi    a5, a5, 2
+        addi    a4, a4, -1
+        bnez    a4, loop
+        li      a1, 16
+        bne     a5, a1, fail
+
+        # taken branch of a loop is predicted by the BTB after its first iteration (the BTB gets the
+        # target of the resolved branch, not the registered redirect of the instruction before it)
+        li      t0, 2
+        csrw    mhpmevent3, t0          # mhpmcounter3 counts branch/jump mispredictions at the ALU stage
+        csrw    mhpmcounter3, zero
+        li      a4, 32
+btb_loop:
+        addi    a4, a4, -1
+        bnez    a4, btb_loop
+        csrr    t1, mhpmcounter3
+        li      a1, 4
+        bgeu    t1, a1, fail            # first iterations and loop exit only
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00001234
+        .word 0x00000000
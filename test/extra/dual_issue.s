@@ -0,0 +1,123 @@
+#
+# TEST CODE FOR DUAL ISSUE (pairs of independent instructions, write-after-write and dependent pairs, forwarding from the second issue slot)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # independent ALU instructions (issued in pairs when dual issue is enabled)
+        .align  3
+        li      t0, 5
+        li      t1, 7
+        add     t2, t0, t1              # forwarded from both slots of the previous pair
+        sub     t3, t1, t0
+        xor     t4, t2, t3              # 12 ^ 2
+        slli    t5, t3, 4
+        li      a1, 14
+        bne     t4, a1, fail
+        li      a1, 32
+        bne     t5, a1, fail
+
+        # write-after-write in the same pair (second slot is younger)
+        .align  3
+        li      s2, 1
+        li      s2, 2
+        li      a1, 2
+        bne     s2, a1, fail
+        addi    s3, zero, 3
+        addi    s3, s3, 4               # dependent (not paired)
+        li      a1, 7
+        bne     s3, a1, fail
+
+        # second slot writing x0 is discarded
+        .align  3
+        li      s4, 9
+        addi    zero, s4, 1
+        bnez    zero, fail
+
+        # load paired with an ALU instruction, load result and second slot result used right after
+        .align  3
+        la      s0, data
+        li      s5, 0x55
+        lw      s6, 0(s0)
+        addi    s7, s5, 1
+        add     s8, s6, s7              # load-to-use and forwarding from the second slot
+        li      a1, 0x128a
+        bne     s8, a1, fail
+
+        # store paired with an ALU instruction which overwrites the stored register
+        .align  3
+        li      s9, 0x77
+        nop
+        sw      s9, 4(s0)
+        li      s9, 0x88
+        lw      s10, 4(s0)
+        li      a1, 0x77
+        bne     s10, a1, fail
+        li      a1, 0x88
+        bne     s9, a1, fail
+
+        # second slot result used as address of a load
+        .align  3
+        li      s11, 8
+        add     a2, s0, s11
+        lw      a3, 0(a2)
+        li      a1, 0x9abc
+        bne     a3, a1, fail
+
+        # loop of independent ALU instructions
+        li      a4, 16
+        li      a5, 0
+        li      a6, 0
+        .align  3
+loop:
+        addi    a5, a5, 3
+        addi    a6, a6, 5
+        addi    a4, a4, -1
+        xor     t6, a5, a6
+        bnez    a4, loop
+        li      a1, 48
+        bne     a5, a1, fail
+        li      a1, 80
+        bne     a6, a1, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00001234
+        .word 0x00000000
+        .word 0x00009abc
+        .word 0x00000000
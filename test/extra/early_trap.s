@@ -0,0 +1,129 @@
+#
+# TEST CODE FOR EARLY TRAP (handler of ECALL/EBREAK/illegal instruction fetched from the ALU stage)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      x8, data        # x8 = base address of data
+        li      x9, 0           # x9 = number of traps
+        li      x20, 0          # x20 = sum of mcause of all traps
+
+        # ecall right after the write to mtvec goes to the new handler
+        la      x6, trap_handler
+        csrw    mtvec, x6
+        ecall
+        li      x5, 1
+        bne     x9, x5, fail
+        li      x5, 11          # mcause = 11 (ecall from M-mode)
+        bne     x20, x5, fail
+
+        # ebreak, handler reads mepc and mcause right away
+        li      x20, 0
+        ebreak
+        li      x5, 2
+        bne     x9, x5, fail
+        li      x5, 3           # mcause = 3 (breakpoint)
+        bne     x20, x5, fail
+
+        # illegal instruction with an rd, the rd is not written
+        li      x20, 0
+        li      x7, 0x5a5a
+        .word   0x0000039f      # reserved opcode with rd = x7 (always illegal)
+        li      x5, 0x5a5a
+        bne     x7, x5, fail
+        li      x5, 3
+        bne     x9, x5, fail
+        li      x5, 2           # mcause = 2 (illegal instruction)
+        bne     x20, x5, fail
+
+        # ecall right after a load, a store, and a taken branch
+        li      x20, 0
+        lw      x5, 0(x8)
+        ecall
+        sw      x9, 4(x8)
+        ecall
+        beqz    x0, taken
+        j       fail
+taken:
+        ecall
+        li      x5, 6
+        bne     x9, x5, fail
+        li      x5, 33          # 3 x mcause = 11
+        bne     x20, x5, fail
+        lw      x5, 4(x8)
+        li      x6, 4
+        bne     x5, x6, fail
+
+        # instructions after the ecall are not executed before the trap
+        li      x7, 0
+        ecall
+        addi    x7, x7, 1
+        li      x5, 1
+        bne     x7, x5, fail
+
+        # repeated ecalls in a loop
+        li      x20, 0
+        li      x11, 10
+ecall_loop:
+        ecall
+        addi    x11, x11, -1
+        bnez    x11, ecall_loop
+        li      x5, 17
+        bne     x9, x5, fail
+        li      x5, 110         # 10 x mcause = 11
+        bne     x20, x5, fail
+
+        j   pass
+
+trap_handler:
+        csrr    x3, mcause
+        add     x20, x20, x3
+        csrr    x3, mepc
+        lhu     x4, 0(x3)       # first halfword of trapping instruction
+        andi    x4, x4, 3
+        addi    x3, x3, 2
+        li      x5, 3
+        bne     x4, x5, trap_return     # compressed instruction (c.ebreak)
+        addi    x3, x3, 2       # return after a 32-bit instruction
+trap_return:
+        csrw    mepc, x3
+        addi    x9, x9, 1
+        mret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000000
+        .word 0x00000000
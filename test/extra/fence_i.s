@@ -0,0 +1,74 @@
+#
+# TEST CODE FOR FENCE.I (SELF-MODIFYING CODE WITH INSTRUCTION CACHE)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # run the code once so it is already fetched (and cached)
+        li      x3, 0
+        call    patched         # x3 = 1
+        li      x4, 1
+        bne     x3, x4, fail
+
+        # modify the code then run it again after FENCE.I
+        la      x8, patched
+        li      x2, 0x02a00193  # encoding of "addi x3, x0, 42"
+        sw      x2, 0(x8)
+        fence.i
+        call    patched         # x3 = 42
+        li      x4, 42
+        bne     x3, x4, fail
+
+        # modified instruction right after FENCE.I (instructions after FENCE.I must be fetched again)
+        la      x8, next
+        li      x2, 0x00700193  # encoding of "addi x3, x0, 7"
+        sw      x2, 0(x8)
+        fence.i
+next:
+        addi    x3, x0, 1       # replaced by "addi x3, x0, 7"
+        li      x4, 7
+        bne     x3, x4, fail
+
+        j   pass
+
+patched:
+        addi    x3, x0, 1       # replaced by "addi x3, x0, 42"
+        ret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+
@@ -0,0 +1,132 @@
+#
+# TEST CODE FOR HARDWARE PERFORMANCE-MONITORING COUNTERS (mhpmcounter3..6)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      t0, trap_handler
+        csrw    mtvec, t0
+        li      t0, -1
+        csrw    mcountinhibit, t0       # stop all counters while setting up
+
+        # select events: 3 = forwarding stall, 4 = misprediction, 5 = data memory wait, 6 = trap
+        li      t0, 1
+        csrw    mhpmevent3, t0
+        li      t0, 2
+        csrw    mhpmevent4, t0
+        li      t0, 3
+        csrw    mhpmevent5, t0
+        li      t0, 5
+        csrw    mhpmevent6, t0
+        csrr    t1, mhpmevent6
+        bne     t0, t1, fail
+        li      t0, 31                  # unsupported event reads back as zero (not counted)
+        csrw    mhpmevent7, t0
+        csrr    t1, mhpmevent7
+        bnez    t1, fail
+        csrw    mhpmcounter3, zero
+        csrw    mhpmcounter3h, zero
+        csrw    mhpmcounter4, zero
+        csrw    mhpmcounter4h, zero
+        csrw    mhpmcounter5, zero
+        csrw    mhpmcounter5h, zero
+        csrw    mhpmcounter6, zero
+        csrw    mhpmcounter6h, zero
+        csrr    t1, mhpmcounter6
+        bnez    t1, fail
+        csrw    mcountinhibit, zero     # start counting
+
+        # three traps (illegal instructions, since the testbench halts on ecall)
+        .word   0xffffffff
+        .word   0xffffffff
+        .word   0xffffffff
+
+        # load-use dependencies (forwarding stall and data memory wait)
+        la      s0, data
+        lw      a1, 0(s0)
+        addi    a1, a1, 1
+        lw      a2, 4(s0)
+        add     a2, a2, a1
+
+        # a loop whose exit is mispredicted at least once
+        li      a3, 4
+loop:   addi    a3, a3, -1
+        bnez    a3, loop
+
+        li      t0, -1
+        csrw    mcountinhibit, t0       # stop all counters before reading
+        csrr    t1, mhpmcounter6
+        li      t0, 3
+        bne     t0, t1, fail            # exactly 3 traps
+        csrr    t1, mhpmcounter3
+        beqz    t1, fail                # forwarding stalls happened
+        csrr    t1, mhpmcounter4
+        beqz    t1, fail                # mispredictions happened
+        csrr    t1, mhpmcounter5
+        beqz    t1, fail                # data memory waits happened
+        csrr    t1, mhpmcounter6h
+        bnez    t1, fail
+
+        # inhibited counter does not increment
+        csrr    t1, mhpmcounter6
+        .word   0xffffffff              # illegal instruction
+        csrr    t2, mhpmcounter6
+        bne     t1, t2, fail
+
+        # written counter keeps the written value
+        li      t0, 0x12345678
+        csrw    mhpmcounter6h, t0
+        csrr    t1, mhpmcounter6h
+        bne     t0, t1, fail
+
+        # unimplemented counter is hardwired to zero
+        csrw    mhpmcounter31, t0
+        csrr    t1, mhpmcounter31
+        bnez    t1, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+trap_handler:
+        csrr    t0, mepc
+        addi    t0, t0, 4               # return to instruction after the illegal instruction
+        csrw    mepc, t0
+        mret
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000010
+        .word 0x00000020
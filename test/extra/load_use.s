@@ -0,0 +1,104 @@
+#
+# TEST CODE FOR LOAD-TO-USE BYPASS
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      x8, data        # x8 = base address of data
+        li      x2, 0x80f1e2d3
+        sw      x2, 0(x8)       # data[0] = 0x80f1e2d3
+
+        # loaded value used right away as rs1
+        lw      x3, 0(x8)
+        addi    x4, x3, 1       # x4 = 0x80f1e2d4
+        li      x5, 0x80f1e2d4
+        bne     x4, x5, fail
+
+        # loaded value used right away as rs2
+        lbu     x3, 1(x8)       # x3 = 0xe2
+        sub     x4, x0, x3      # x4 = -0xe2
+        li      x5, -0xe2
+        bne     x4, x5, fail
+
+        # sign-extended byte and halfword used right away
+        lb      x3, 3(x8)       # x3 = 0xffffff80
+        add     x4, x3, x3      # x4 = 0xffffff00
+        li      x5, 0xffffff00
+        bne     x4, x5, fail
+        lh      x3, 2(x8)       # x3 = 0xffff80f1
+        xor     x4, x3, x0
+        li      x5, 0xffff80f1
+        bne     x4, x5, fail
+        lhu     x3, 0(x8)       # x3 = 0x0000e2d3
+        or      x4, x0, x3
+        li      x5, 0xe2d3
+        bne     x4, x5, fail
+
+        # loaded value used right away by a branch
+        lw      x3, 0(x8)
+        bne     x3, x2, fail
+
+        # loaded value used right away as store data and as load address
+        sw      x8, 4(x8)       # data[1] = address of data
+        lw      x3, 0(x8)
+        sw      x3, 8(x8)       # data[2] = data[0]
+        lw      x6, 4(x8)
+        lw      x7, 8(x6)       # x7 = data[2] (address from previous load)
+        bne     x7, x2, fail
+
+        # chain of dependent loads (pointer chasing)
+        la      x3, node0
+        li      x4, 0           # x4 = number of nodes
+chase:
+        lw      x3, 0(x3)       # x3 = next node
+        addi    x4, x4, 1
+        bnez    x3, chase
+        li      x5, 3
+        bne     x4, x5, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0, 0, 0
+node0:
+        .word node1
+node1:
+        .word node2
+node2:
+        .word 0
+
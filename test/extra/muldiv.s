@@ -0,0 +1,127 @@
+#
+# TEST CODE FOR MULTIPLY/DIVIDE INSTRUCTIONS (RV32M)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # multiply (low and high parts, signed and unsigned)
+        li      x2, 0x80000001
+        li      x3, -3
+        mul     x4, x2, x3      # x4 = 0x7ffffffd
+        li      x5, 0x7ffffffd
+        bne     x4, x5, fail
+        mulh    x4, x2, x3      # x4 = 0x00000001
+        li      x5, 1
+        bne     x4, x5, fail
+        mulhsu  x4, x2, x3      # x4 = 0x80000002
+        li      x5, 0x80000002
+        bne     x4, x5, fail
+        mulhu   x4, x2, x3      # x4 = 0x7fffffff
+        li      x5, 0x7fffffff
+        bne     x4, x5, fail
+
+        # product used right away (operand forwarding)
+        li      x2, 1000
+        mul     x4, x2, x2
+        addi    x4, x4, 1       # x4 = 1000001
+        li      x5, 1000001
+        bne     x4, x5, fail
+
+        # signed/unsigned division and remainder
+        li      x2, -20
+        li      x3, 6
+        div     x4, x2, x3      # x4 = -3
+        li      x5, -3
+        bne     x4, x5, fail
+        rem     x4, x2, x3      # x4 = -2 (same sign as dividend)
+        li      x5, -2
+        bne     x4, x5, fail
+        divu    x4, x2, x3      # x4 = 0xffffffec / 6 = 0x2aaaaaa7
+        li      x5, 0x2aaaaaa7
+        bne     x4, x5, fail
+        remu    x4, x2, x3      # x4 = 2
+        li      x5, 2
+        bne     x4, x5, fail
+
+        # small dividend (early termination) and dividend smaller than divisor
+        li      x2, 7
+        li      x3, 2
+        divu    x4, x2, x3      # x4 = 3
+        li      x5, 3
+        bne     x4, x5, fail
+        li      x3, 100
+        remu    x4, x2, x3      # x4 = 7
+        bne     x4, x2, fail
+        div     x4, x0, x3      # x4 = 0
+        bnez    x4, fail
+
+        # division by zero
+        li      x2, -7
+        div     x4, x2, x0      # x4 = -1
+        li      x5, -1
+        bne     x4, x5, fail
+        divu    x4, x2, x0      # x4 = 0xffffffff
+        bne     x4, x5, fail
+        rem     x4, x2, x0      # x4 = -7
+        bne     x4, x2, fail
+        remu    x4, x2, x0      # x4 = -7
+        bne     x4, x2, fail
+
+        # signed overflow (-2^31 / -1)
+        li      x2, 0x80000000
+        li      x3, -1
+        div     x4, x2, x3      # x4 = 0x80000000
+        bne     x4, x2, fail
+        rem     x4, x2, x3      # x4 = 0
+        bnez    x4, fail
+
+        # divide operands from a load (load-use) and quotient used right away
+        la      x8, data
+        lw      x2, 0(x8)       # x2 = 1000000
+        lw      x3, 4(x8)       # x3 = 7
+        div     x4, x2, x3      # x4 = 142857
+        rem     x6, x2, x3      # x6 = 1
+        mul     x7, x4, x3
+        add     x7, x7, x6      # x7 = 1000000
+        bne     x7, x2, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 1000000, 7
+
@@ -0,0 +1,142 @@
+#
+# TEST CODE FOR RETURN ADDRESS STACK
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        li      sp, 0x1800      # stack pointer for recursive calls
+
+        # same function called from different call sites (return address changes every call)
+        li      x11, 0          # x11 = loop counter
+        li      x12, 10         # x12 = loop count
+        li      x3, 0           # x3 = sum
+loop1:
+        call    add1            # x3 += 1
+        call    add2            # x3 += 2 (nested call to add1)
+        call    add1            # x3 += 1
+        addi    x11, x11, 1
+        bne     x11, x12, loop1
+        li      x4, 40
+        bne     x3, x4, fail
+
+        # recursive call deeper than the return address stack (overflow then underflow)
+        li      a0, 12
+        call    sum_rec         # a0 = 12+11+...+1 = 78
+        li      x4, 78
+        bne     a0, x4, fail
+
+        # return address changed before return (return is mispredicted but must still be correct)
+        li      x3, 0
+        call    skip_ret        # returns to ret_here instead of the instruction after call
+        addi    x3, x3, 100     # skipped
+ret_here:
+        bnez    x3, fail
+
+        # call through t0 (x5) as link register
+        li      x3, 0
+        jal     t0, add1_t0
+        addi    x3, x3, 1
+        li      x4, 2
+        bne     x3, x4, fail
+
+        # branch mispredicted after a call with a return and a call on its wrong path (RAS is restored
+        # to the state right after the branch so the return of outer is still predicted)
+        li      t0, 2
+        csrw    mhpmevent3, t0          # mhpmcounter3 counts branch/jump mispredictions at the ALU stage
+        li      x3, 0
+        li      x4, 1
+        csrw    mhpmcounter3, zero
+        jal     outer                   # x3 += 2 (JAL so that the calls are not mispredicted)
+        jal     add1                    # x3 += 1 (also fetched on the wrong path of outer)
+        csrr    t1, mhpmcounter3
+        li      x4, 3
+        bne     x3, x4, fail
+        li      x4, 2
+        bgeu    t1, x4, fail            # only the branch of outer is mispredicted
+
+        j   pass
+
+outer:
+        addi    sp, sp, -4
+        sw      ra, 0(sp)
+        jal     add1
+        lw      ra, 0(sp)
+        addi    sp, sp, 4
+        addi    x3, x3, 1
+        bnez    x4, outer_ret           # forward branch predicted as not taken
+        ret                             # wrong path: pops the return address of outer
+outer_ret:
+        ret
+
+add1:
+        addi    x3, x3, 1
+        ret
+
+add2:
+        addi    sp, sp, -4
+        sw      ra, 0(sp)
+        addi    x3, x3, 1
+        call    add1
+        lw      ra, 0(sp)
+        addi    sp, sp, 4
+        ret
+
+sum_rec:                        # a0 = a0 + sum_rec(a0-1), sum_rec(0) = 0
+        beqz    a0, sum_rec_end
+        addi    sp, sp, -8
+        sw      ra, 0(sp)
+        sw      a0, 4(sp)
+        addi    a0, a0, -1
+        call    sum_rec
+        lw      x4, 4(sp)
+        add     a0, a0, x4
+        lw      ra, 0(sp)
+        addi    sp, sp, 8
+sum_rec_end:
+        ret
+
+skip_ret:
+        la      ra, ret_here
+        ret
+
+add1_t0:
+        addi    x3, x3, 1
+        jr      t0
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+
@@ -0,0 +1,114 @@
+#
+# TEST CODE FOR SHADOW REGISTER BANK (mbank CSR, only tested when SHADOW_REGS is enabled)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+        .equ    mbank, 0x7c0    # custom CSR: [0] = register bank used, [1] = register bank restored by mret
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      t0, trap_handler
+        csrw    mtvec, t0
+
+        # detect the shadow register bank (mbank reads as zero if not implemented)
+        csrwi   mbank, 2        # set the register bank restored by mret (no bank switch)
+        csrr    t0, mbank
+        beqz    t0, pass        # no shadow register bank
+        li      t1, 2
+        bne     t0, t1, fail
+        csrwi   mbank, 0
+
+        # switch to the shadow register bank by a CSR write and initialize it
+        li      s0, 0x55
+        li      s1, 0x66
+        csrrwi  a0, mbank, 1    # a0 (old bank) = 0
+        li      s0, 0x11        # shadow s0
+        la      sp, data        # stack pointer of the trap handler
+        li      s1, 0           # shadow s1 = number of traps
+        csrrwi  a1, mbank, 0    # shadow a1 = 1
+        bnez    a0, fail
+        li      t0, 0x55
+        bne     s0, t0, fail    # base s0 is unchanged
+        li      t0, 0x66
+        bne     s1, t0, fail    # base s1 is unchanged
+        csrr    t0, mbank
+        bnez    t0, fail
+
+        # trap handler uses the shadow register bank without saving registers
+        li      a2, 7
+        .word   0xffffffff      # illegal instruction (trap)
+        li      t0, 7
+        bne     a2, t0, fail    # base a2 is unchanged by trap handler
+        .word   0xffffffff      # illegal instruction (trap)
+        la      t1, data
+        lw      t0, 0(t1)
+        li      t2, 2
+        bne     t0, t2, fail    # shadow s1 (number of traps) is kept between traps
+        lw      t0, 4(t1)
+        li      t2, 1
+        bne     t0, t2, fail    # mbank inside trap handler = 1 (bank 1, previous bank 0)
+
+        # trap handler switches to the base register bank to change the registers of the interrupted code
+        li      t0, 1
+        csrw    mscratch, t0    # request the trap handler to write base a3
+        li      a3, 0
+        .word   0xffffffff      # illegal instruction (trap)
+        li      t0, 42
+        bne     a3, t0, fail
+        csrr    t0, mbank
+        bnez    t0, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+trap_handler:                   # runs in the shadow register bank
+        addi    s1, s1, 1
+        sw      s1, 0(sp)
+        csrr    t0, mbank
+        sw      t0, 4(sp)
+        csrr    t0, mepc
+        addi    t0, t0, 4       # return to instruction after the illegal instruction
+        csrw    mepc, t0
+        csrr    t0, mscratch
+        beqz    t0, trap_return
+        csrw    mscratch, zero
+        csrwi   mbank, 0        # base register bank (mret restores base register bank too)
+        li      a3, 42          # base a3
+trap_return:
+        mret
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000000
+        .word 0x00000000
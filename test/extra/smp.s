@@ -0,0 +1,183 @@
+#
+# TEST CODE FOR MULTI-HART SOC (runs on a 2-hart rv32i_soc: shared counter with AMO and LR/SC, per-hart mtimecmp/msip, inter-processor interrupt)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+        .equ    HARTS, 2                # number of harts (test.sh runs testfiles with "smp" on their name on a 2-hart rv32i_soc)
+        .equ    COUNT, 50               # increments of the shared counter per hart for each of AMO and LR/SC
+        .equ    MTIMECMP, 0x80000008    # mtimecmp of hart h is at MTIMECMP + 8*h
+        .equ    MSIP, 0x80000018        # msip of hart h is at MSIP + 4*h (MTIMECMP + 8*HARTS)
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # all harts run this code, hart 0 checks the results
+        csrr    s11, mhartid
+        la      s0, counter
+        la      s1, ids
+        la      s2, finished
+        la      s3, errors
+        la      s4, acked
+
+        # every hart sets its bit in ids
+        li      t0, 1
+        sll     t0, t0, s11
+        amoor.w zero, t0, (s1)
+
+        # every hart increments the shared counter with AMO and with LR/SC (the AMO of another hart
+        # often writes the counter between lr.w and sc.w, which must then fail)
+        li      t1, 1
+        li      t2, COUNT
+count_loop:
+        amoadd.w zero, t1, (s0)
+lrsc_retry:
+        lr.w    t3, (s0)
+        addi    t3, t3, 1
+        sc.w    t4, t3, (s0)
+        bnez    t4, lrsc_retry          # retry when another hart wrote the counter after lr.w
+        addi    t2, t2, -1
+        bnez    t2, count_loop
+
+        # mtimecmp of this hart makes only this hart's timer interrupt pending
+        li      s5, MTIMECMP
+        slli    t0, s11, 3
+        add     s5, s5, t0
+        sw      zero, 4(s5)
+        sw      zero, 0(s5)             # mtimecmp = 0 (mtime >= mtimecmp)
+        li      a2, 0x80                # MTIP
+        jal     ra, wait_mip_set
+        li      t0, -1
+        sw      t0, 0(s5)
+        sw      t0, 4(s5)               # mtimecmp = max
+        jal     ra, wait_mip_clear
+
+        # msip of this hart makes only this hart's software interrupt pending
+        li      s6, MSIP
+        slli    t0, s11, 2
+        add     s6, s6, t0
+        li      t0, 1
+        sw      t0, 0(s6)
+        li      a2, 0x08                # MSIP
+        jal     ra, wait_mip_set
+        sw      zero, 0(s6)
+        jal     ra, wait_mip_clear
+
+        li      t1, 1
+        amoadd.w zero, t1, (s2)         # this hart is finished
+        beqz    s11, hart0
+
+        # harts other than hart 0 wait for the inter-processor interrupt from hart 0 (interrupts are disabled)
+wait_ipi:
+        csrr    t0, mip
+        andi    t0, t0, 0x08
+        beqz    t0, wait_ipi
+        sw      zero, 0(s6)             # clear own msip
+        amoadd.w zero, t1, (s4)         # acknowledge the interrupt
+park:
+        j       park
+
+hart0:
+        # wait until all harts are finished (hart 0 never sees the interrupts of the other harts)
+        li      t2, HARTS
+wait_finished:
+        csrr    t0, mip
+        andi    t0, t0, 0x88
+        bnez    t0, fail
+        lw      t0, 0(s2)
+        bne     t0, t2, wait_finished
+
+        # no increment is lost
+        lw      t0, 0(s0)
+        li      a1, 2*COUNT*HARTS
+        bne     t0, a1, fail
+        # all harts are running with a distinct mhartid
+        lw      t0, 0(s1)
+        li      a1, (1 << HARTS) - 1
+        bne     t0, a1, fail
+        # other harts saw their own interrupts
+        lw      t0, 0(s3)
+        bnez    t0, fail
+
+        # inter-processor interrupt to all other harts
+        li      t0, MSIP + 4
+        li      t1, MSIP + 4*HARTS
+        li      t3, 1
+send_ipi:
+        sw      t3, 0(t0)
+        addi    t0, t0, 4
+        bne     t0, t1, send_ipi
+        li      t2, HARTS - 1
+wait_acked:
+        lw      t0, 0(s4)
+        bne     t0, t2, wait_acked
+        csrr    t0, mip
+        andi    t0, t0, 0x08
+        bnez    t0, fail
+
+        j   pass
+
+        # wait until the mip bits a2 are set (or clear) after the write to the CLINT reaches it, a
+        # hart other than hart 0 counts the errors while hart 0 fails right away
+wait_mip_set:
+        li      t5, 64
+1:      csrr    t0, mip
+        and     t0, t0, a2
+        bnez    t0, 2f
+        addi    t5, t5, -1
+        bnez    t5, 1b
+        j       mip_error
+wait_mip_clear:
+        li      t5, 64
+1:      csrr    t0, mip
+        and     t0, t0, a2
+        beqz    t0, 2f
+        addi    t5, t5, -1
+        bnez    t5, 1b
+mip_error:
+        beqz    s11, fail
+        li      t0, 1
+        amoadd.w zero, t0, (s3)
+2:      ret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+counter:
+        .word 0x00000000        # shared counter
+ids:
+        .word 0x00000000        # bit h is set by hart h
+finished:
+        .word 0x00000000        # number of finished harts
+errors:
+        .word 0x00000000        # errors seen by the harts other than hart 0
+acked:
+        .word 0x00000000        # number of harts that got the inter-processor interrupt
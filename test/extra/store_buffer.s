@@ -0,0 +1,95 @@
+#
+# TEST CODE FOR STORE BUFFER (POSTED STORES AND STORE-TO-LOAD FORWARDING)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      x8, data        # x8 = base address of data
+        li      x2, 0x11223344
+        li      x5, 0x55
+        li      x6, 0x6677
+
+        # stores to the same word with different byte masks then load right away (bytes merged from buffered stores)
+        sw      x0, 0(x8)
+        sw      x0, 4(x8)
+        sw      x0, 8(x8)
+        sw      x2, 12(x8)      # data[3] = 0x11223344
+        sb      x5, 13(x8)      # data[3] = 0x11225544
+        sh      x6, 14(x8)      # data[3] = 0x66775544
+        lw      x3, 12(x8)
+        li      x4, 0x66775544
+        bne     x3, x4, fail
+        lbu     x3, 13(x8)      # x3 = 0x55
+        bne     x3, x5, fail
+        lh      x3, 14(x8)      # x3 = 0x6677
+        bne     x3, x6, fail
+
+        # load only partially covered by buffered stores (other bytes come from memory)
+        sw      x2, 16(x8)      # data[4] = 0x11223344
+        sw      x0, 20(x8)
+        sw      x0, 24(x8)
+        sw      x0, 28(x8)
+        sb      x5, 16(x8)      # data[4] = 0x11223355
+        lw      x3, 16(x8)
+        li      x4, 0x11223355
+        bne     x3, x4, fail
+
+        # load to a word not in the store buffer right after many stores
+        li      x3, 1
+        sw      x3, 0(x8)
+        sw      x3, 4(x8)
+        sw      x3, 8(x8)
+        sw      x3, 20(x8)
+        sw      x3, 24(x8)
+        sw      x3, 28(x8)
+        lw      x3, 12(x8)
+        li      x4, 0x66775544
+        bne     x3, x4, fail
+
+        # fence waits until all stores are written to memory
+        sw      x5, 32(x8)
+        sb      x0, 32(x8)      # data[8] = 0x00000000
+        fence
+        lw      x3, 32(x8)
+        bnez    x3, fail
+
+        j   pass
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0, 0, 0, 0, 0, 0, 0, 0, 0
+
@@ -0,0 +1,133 @@
+#
+# TEST CODE FOR CONSECUTIVE STORES (MULTIPLE OUTSTANDING DATA MEMORY REQUESTS)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        li      sp, 0x1800      # stack pointer for context save/restore
+
+        # save registers back-to-back (like a context switch), clobber them, then restore
+        li      x5, 5
+        li      x6, 6
+        li      x7, 7
+        li      x8, 8
+        li      x9, 9
+        li      x11, 11
+        li      x12, 12
+        li      x13, 13
+        addi    sp, sp, -32
+        sw      x5, 0(sp)
+        sw      x6, 4(sp)
+        sw      x7, 8(sp)
+        sw      x8, 12(sp)
+        sw      x9, 16(sp)
+        sw      x11, 20(sp)
+        sw      x12, 24(sp)
+        sw      x13, 28(sp)
+        li      x5, 0
+        li      x6, 0
+        li      x7, 0
+        li      x8, 0
+        li      x9, 0
+        li      x11, 0
+        li      x12, 0
+        li      x13, 0
+        lw      x5, 0(sp)
+        lw      x6, 4(sp)
+        lw      x7, 8(sp)
+        lw      x8, 12(sp)
+        lw      x9, 16(sp)
+        lw      x11, 20(sp)
+        lw      x12, 24(sp)
+        lw      x13, 28(sp)
+        addi    sp, sp, 32
+        add     x3, x5, x6
+        add     x3, x3, x7
+        add     x3, x3, x8
+        add     x3, x3, x9
+        add     x3, x3, x11
+        add     x3, x3, x12
+        add     x3, x3, x13     # x3 = 5+6+7+8+9+11+12+13 = 71
+        li      x4, 71
+        bne     x3, x4, fail
+
+        # load right after stores to the same address (load must see all previous stores)
+        la      x8, data
+        li      x2, 0x11223344
+        sw      x2, 0(x8)
+        sb      x0, 0(x8)       # data[0] = 0x11223300
+        sh      x0, 2(x8)       # data[0] = 0x00003300
+        lw      x3, 0(x8)
+        li      x4, 0x3300
+        bne     x3, x4, fail
+
+        # stores to the same address in a row (last store wins)
+        li      x2, 1
+        sw      x2, 4(x8)
+        li      x2, 2
+        sw      x2, 4(x8)
+        li      x2, 3
+        sw      x2, 4(x8)
+        lw      x3, 4(x8)
+        li      x4, 3
+        bne     x3, x4, fail
+
+        # store after a trapping instruction must not be written when trap is taken before it (handler just returns)
+        la      x2, trap_handler
+        csrw    mtvec, x2
+        sw      x0, 8(x8)
+        li      x2, 0x55
+        .word   0xffffffff      # illegal instruction
+        sw      x2, 8(x8)       # executed only after returning from trap
+        lw      x3, 8(x8)
+        bne     x3, x2, fail
+
+        j   pass
+
+        .align  2               # mtvec is word-aligned
+trap_handler:
+        lw      x3, 8(x8)       # store after illegal instruction must not be written yet
+        bnez    x3, fail
+        csrr    x3, mepc
+        addi    x3, x3, 4
+        csrw    mepc, x3
+        mret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0, 0, 0
+
@@ -0,0 +1,206 @@
+#
+# TEST CODE FOR HARDWARE MULTITHREADING (runs on a 2-thread rv32i_soc: per-thread registers and CSRs, parked loads, shared counter with AMO and LR/SC, per-thread mtimecmp/msip)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+        .equ    THREADS, 2              # number of threads (test.sh runs testfiles with "threads" on their name on a 2-thread rv32i_soc)
+        .equ    COUNT, 50               # increments of the shared counter per thread for each of AMO and LR/SC
+        .equ    WORDS, 16               # words of the table summed by each thread
+        .equ    MTIMECMP, 0x80000008    # mtimecmp of thread h is at MTIMECMP + 8*h
+        .equ    MSIP, 0x80000018        # msip of thread h is at MSIP + 4*h (MTIMECMP + 8*THREADS)
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        # all threads run this code, thread 0 checks the results
+        csrr    s11, mhartid
+        la      s0, counter
+        la      s1, ids
+        la      s2, finished
+        la      s3, errors
+        la      s4, sums
+
+        # every thread keeps its own mscratch
+        addi    t0, s11, 0x5a
+        csrw    mscratch, t0
+
+        # every thread sets its bit in ids
+        li      t0, 1
+        sll     t0, t0, s11
+        amoor.w zero, t0, (s1)
+
+        # every thread sums the table scaled by (mhartid + 1) with back-to-back loads and load-use
+        # dependencies (a load waiting for the data memory is parked and the other thread runs)
+        la      a2, table
+        li      a3, WORDS
+        addi    a4, s11, 1
+        li      a5, 0
+sum_loop:
+        lw      t0, 0(a2)
+        lhu     t1, 0(a2)
+        lb      t2, 3(a2)
+        mul     t0, t0, a4
+        add     a5, a5, t0
+        sub     a5, a5, t1
+        add     a5, a5, t2
+        addi    a2, a2, 4
+        addi    a3, a3, -1
+        bnez    a3, sum_loop
+        slli    t0, s11, 2
+        add     t0, t0, s4
+        sw      a5, 0(t0)
+
+        # every thread increments the shared counter with AMO and with LR/SC (a thread switch
+        # between lr.w and sc.w clears the reservation so the sc.w fails and is retried)
+        li      t1, 1
+        li      t2, COUNT
+count_loop:
+        amoadd.w zero, t1, (s0)
+lrsc_retry:
+        lr.w    t3, (s0)
+        addi    t3, t3, 1
+        sc.w    t4, t3, (s0)
+        bnez    t4, lrsc_retry
+        addi    t2, t2, -1
+        bnez    t2, count_loop
+
+        # mtimecmp of this thread makes only this thread's timer interrupt pending
+        li      s5, MTIMECMP
+        slli    t0, s11, 3
+        add     s5, s5, t0
+        sw      zero, 4(s5)
+        sw      zero, 0(s5)             # mtimecmp = 0 (mtime >= mtimecmp)
+        li      a2, 0x80                # MTIP
+        jal     ra, wait_mip_set
+        li      t0, -1
+        sw      t0, 0(s5)
+        sw      t0, 4(s5)               # mtimecmp = max
+        jal     ra, wait_mip_clear
+
+        # msip of this thread makes only this thread's software interrupt pending
+        li      s6, MSIP
+        slli    t0, s11, 2
+        add     s6, s6, t0
+        li      t0, 1
+        sw      t0, 0(s6)
+        li      a2, 0x08                # MSIP
+        jal     ra, wait_mip_set
+        sw      zero, 0(s6)
+        jal     ra, wait_mip_clear
+
+        # mscratch of this thread is not changed by the other thread
+        csrr    t0, mscratch
+        addi    t1, s11, 0x5a
+        beq     t0, t1, 1f
+        li      t0, 1
+        amoadd.w zero, t0, (s3)
+1:
+        li      t1, 1
+        amoadd.w zero, t1, (s2)         # this thread is finished
+        beqz    s11, thread0
+park:
+        wfi                             # no interrupt is enabled, WFI switches to the other thread
+        j       park
+
+thread0:
+        # wait until all threads are finished (thread 0 never sees the interrupts of the other thread)
+        li      t2, THREADS
+wait_finished:
+        csrr    t0, mip
+        andi    t0, t0, 0x88
+        bnez    t0, fail
+        lw      t0, 0(s2)
+        bne     t0, t2, wait_finished
+
+        # no increment is lost
+        lw      t0, 0(s0)
+        li      a1, 2*COUNT*THREADS
+        bne     t0, a1, fail
+        # all threads are running with a distinct mhartid
+        lw      t0, 0(s1)
+        li      a1, (1 << THREADS) - 1
+        bne     t0, a1, fail
+        # other thread saw its own interrupts and its own mscratch
+        lw      t0, 0(s3)
+        bnez    t0, fail
+        # sums of the table (each thread used its own registers)
+        lw      t0, 0(s4)
+        li      a1, 0xb226ffac
+        bne     t0, a1, fail
+        lw      t0, 4(s4)
+        li      a1, 0x64537b69
+        bne     t0, a1, fail
+
+        j   pass
+
+        # wait until the mip bits a2 are set (or clear) after the write to the CLINT reaches it, a
+        # thread other than thread 0 counts the errors while thread 0 fails right away
+wait_mip_set:
+        li      t5, 64
+1:      csrr    t0, mip
+        and     t0, t0, a2
+        bnez    t0, 2f
+        addi    t5, t5, -1
+        bnez    t5, 1b
+        j       mip_error
+wait_mip_clear:
+        li      t5, 64
+1:      csrr    t0, mip
+        and     t0, t0, a2
+        beqz    t0, 2f
+        addi    t5, t5, -1
+        bnez    t5, 1b
+mip_error:
+        beqz    s11, fail
+        li      t0, 1
+        amoadd.w zero, t0, (s3)
+2:      ret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+counter:
+        .word 0x00000000        # shared counter
+ids:
+        .word 0x00000000        # bit h is set by thread h
+finished:
+        .word 0x00000000        # number of finished threads
+errors:
+        .word 0x00000000        # errors seen by the thread other than thread 0
+sums:
+        .word 0x00000000        # sum of the table by thread 0
+        .word 0x00000000        # sum of the table by thread 1
+table:
+        .word 0x01020304, 0x8090a0b0, 0x11223344, 0xfedcba98
+        .word 0x00010001, 0x7fff8000, 0x55aa55aa, 0x0f0f0f0f
+        .word 0xdeadbeef, 0x12345678, 0x80000000, 0x000000ff
+        .word 0x0000ff00, 0x00ff0000, 0xff000000, 0xcafef00d
@@ -0,0 +1,137 @@
+#
+# TEST CODE FOR WFI (WAIT FOR INTERRUPT: PENDING INTERRUPT, TIMER WAKE-UP WITH INTERRUPTS DISABLED, INTERRUPT TAKEN AFTER WFI)
+#
+        # -----------------------------------------
+        # Program section (known as text)
+        # -----------------------------------------
+        .text
+
+        .equ    MTIME, 0x80000000
+        .equ    MTIMECMP, 0x80000008
+        .equ    MSIP, 0x80000010
+        .equ    SLEEP, 200              # clock cycles until the timer interrupt (mtime increments every clock cycle)
+
+# Start symbol (must be present), exported as a global symbol.
+_start: .global _start
+
+# Export main as a global symbol
+        .global main
+
+# Label for entry point of test code
+main:
+        ### TEST CODE STARTS HERE ###
+
+        la      t0, trap_handler
+        csrw    mtvec, t0
+        li      s0, MTIME
+        li      s1, MTIMECMP
+        li      s2, MSIP
+        li      s3, 0                   # s3 = pc after the WFI ended by an interrupt (mepc)
+        li      s9, 0                   # s9 = number of interrupts taken
+        li      t0, -1
+        sw      t0, 0(s1)
+        sw      t0, 4(s1)               # mtimecmp = max (no timer interrupt)
+        csrw    mstatus, x0             # interrupts disabled
+
+        # WFI does not wait when an enabled interrupt is already pending
+        li      t0, 0x08
+        csrw    mie, t0                 # MSIE
+        li      t0, 1
+        sw      t0, 0(s2)               # msip = 1
+wait_msip_set:
+        csrr    t0, mip
+        andi    t0, t0, 0x08
+        beqz    t0, wait_msip_set
+        wfi
+        bnez    s9, fail                # no trap (mstatus.MIE is clear)
+        sw      zero, 0(s2)             # msip = 0
+wait_msip_clear:
+        csrr    t0, mip
+        andi    t0, t0, 0x08
+        bnez    t0, wait_msip_clear
+
+        # timer interrupt ends WFI even with mstatus.MIE clear, and the pipeline is held meanwhile
+        li      t0, 0x80
+        csrw    mie, t0                 # MTIE
+        lw      t1, 0(s0)
+        addi    t1, t1, SLEEP
+        sw      t1, 0(s1)
+        sw      zero, 4(s1)             # mtimecmp = mtime + SLEEP
+        csrr    s4, minstret
+        wfi
+        csrr    s5, minstret
+        lw      t2, 0(s0)
+        bltu    t2, t1, fail            # WFI ended only once mtime reached mtimecmp
+        sub     t3, t2, t1
+        li      t4, 32
+        bgeu    t3, t4, fail            # and within a few clock cycles
+        sub     t3, s5, s4
+        li      t4, 4
+        bgeu    t3, t4, fail            # no instruction retired while waiting
+        csrr    t0, mip
+        andi    t0, t0, 0x80
+        beqz    t0, fail                # timer interrupt is still pending
+        bnez    s9, fail                # but not taken
+        li      t0, -1
+        sw      t0, 4(s1)
+        sw      t0, 0(s1)               # mtimecmp = max
+wait_mtip_clear:
+        csrr    t0, mip
+        andi    t0, t0, 0x80
+        bnez    t0, wait_mtip_clear
+
+        # with mstatus.MIE set the interrupt ending WFI is taken at the next instruction (mepc is the pc after WFI)
+        lw      t1, 0(s0)
+        addi    t1, t1, SLEEP
+        sw      t1, 0(s1)
+        sw      zero, 4(s1)             # mtimecmp = mtime + SLEEP
+        la      s3, after_wfi
+        csrsi   mstatus, 0x08
+        wfi
+after_wfi:
+        csrci   mstatus, 0x08
+        li      t0, 1
+        bne     s9, t0, fail
+
+        j   pass
+
+trap_handler:
+        csrr    t5, mcause
+        li      t6, 0x80000007          # timer interrupt
+        bne     t5, t6, fail
+        csrr    t5, mepc
+        bne     t5, s3, fail
+        li      t6, -1
+        sw      t6, 4(s1)
+        sw      t6, 0(s1)               # mtimecmp = max
+handler_mtip_clear:
+        csrr    t5, mip
+        andi    t5, t5, 0x80
+        bnez    t5, handler_mtip_clear
+        addi    s9, s9, 1
+        mret
+        ###    END OF TEST CODE   ###
+
+        # Exit test using RISC-V International's riscv-tests pass/fail criteria
+
+fail:
+        li      a0, 1           # fail code
+        li      a7, 93          # reached end of code
+        ebreak
+
+pass:
+        li      a0, 0           # set a0 (x10) to 0 to indicate a pass code
+        li      a7, 93          # set a7 (x17) to 93 (5dh) to indicate reached the end of the test
+        ebreak
+
+
+
+        # -----------------------------------------
+        # Data section. Note starts at 0x1000, as
+        # set by DATAADDR variable in rv_asm.bat.
+        # -----------------------------------------
+        .data
+
+        # Data section
+data:
+        .word 0x00000000
@@ -8,6 +8,11 @@ volatile uint32_t *mtimecmp_low = (volatile uint32_t *) MTIMECMP_BASE_ADDRESS;
 volatile uint32_t *mtimecmp_hi = (volatile uint32_t *) (MTIMECMP_BASE_ADDRESS + 4);
 volatile uint32_t *software_interrupt = (volatile uint32_t *) MSIP_BASE_ADDRESS;
 
+// Each hart has its own MTIMECMP (2 words) and MSIP (1 word) 
+#define HART_MTIMECMP_LOW (mtimecmp_low + 2*csr_read(MHARTID))
+#define HART_MTIMECMP_HI (mtimecmp_hi + 2*csr_read(MHARTID))
+#define HART_MSIP (software_interrupt + csr_read(MHARTID))
+
 // Set current system time.
 void mtime_set_time(uint64_t time) {
 
@@ -51,9 +56,9 @@ void mtime_set_timecmp(uint64_t timecmp) {
 
   timecmp_union.uint64 = timecmp;
 
-  *mtimecmp_low = -1; // prevent MTIMECMP from temporarily becoming smaller than the lesser of the old and new values
-  *mtimecmp_hi = timecmp_union.uint32[1];
-  *mtimecmp_low = timecmp_union.uint32[0];
+  *HART_MTIMECMP_LOW = -1; // prevent MTIMECMP from temporarily becoming smaller than the lesser of the old and new values
+  *HART_MTIMECMP_HI = timecmp_union.uint32[1];
+  *HART_MTIMECMP_LOW = timecmp_union.uint32[0];
 }
 
 
@@ -65,8 +70,8 @@ uint64_t mtime_get_timecmp(void) {
     uint32_t uint32[sizeof(uint64_t)/sizeof(uint32_t)];
   } timecmp_union;
 
-  timecmp_union.uint32[0] = *mtimecmp_low;
-  timecmp_union.uint32[1] = *mtimecmp_hi;
+  timecmp_union.uint32[0] = *HART_MTIMECMP_LOW;
+  timecmp_union.uint32[1] = *HART_MTIMECMP_HI;
 
   return timecmp_union.uint64;
 }
@@ -83,12 +88,17 @@ void trap_handler_setup(void (*trap_handler)(void)) { //this is a pointer to a f
 
 // trurn on software interrupt
 void enable_software_interrupt(void){
-	*software_interrupt = 1;
+	*HART_MSIP = 1;
 }
 
 // turn off software interrupt
 void disable_software_interrupt(void){
-	*software_interrupt = 0;
+	*HART_MSIP = 0;
+}
+
+// turn on software interrupt of another hart (inter-processor interrupt)
+void send_software_interrupt(uint32_t hart){
+	software_interrupt[hart] = 1;
 }
 
 
@@ -111,27 +121,40 @@ uint32_t cpu_ticks_to_us (uint64_t ticks){
 }
 
 
+// wait until mtime reaches the given time
+// with interrupts disabled the core sleeps (WFI) until the timer interrupt is pending instead of reading mtime all the time
+// (mtimecmp and mie are reprogrammed for the sleep and restored before returning),
+// with interrupts enabled mtimecmp is left to the trap handler and mtime is polled
+static void wait_until(uint64_t time) {
+	if(csr_read(MSTATUS) & (1 << MSTATUS_MIE)) {
+		while (time > (uint64_t)mtime_get_time()){ //do nothing while delay has not yet passed
+		}
+		return;
+	}
+	uint64_t timecmp = mtime_get_timecmp();
+	uint32_t mie = csr_read(MIE);
+	mtime_set_timecmp(time);
+	csr_set(MIE, 1 << MIE_MTIE);
+	while (time > (uint64_t)mtime_get_time()){ //sleep while delay has not yet passed (timer interrupt ends WFI but is not taken)
+		wfi();
+	}
+	csr_write(MIE, mie);
+	mtime_set_timecmp(timecmp);
+}
+
 // delay function based on milliseconds
 void delay_ms(uint64_t ms) {
-	uint64_t initial_time = mtime_get_time();
-	uint64_t ms_in_ticks = ms_to_cpu_ticks(ms);
-	while ((initial_time + ms_in_ticks) > (uint64_t)mtime_get_time()){ //do nothing while delay has not yet passed
-	}
+	wait_until(mtime_get_time() + ms_to_cpu_ticks(ms));
 }
 
 // delay function based on microseconds
 void delay_us(uint64_t us) {
-	uint64_t initial_time = mtime_get_time();
-	uint64_t us_in_ticks = us_to_cpu_ticks(us);
-	while ((initial_time + us_in_ticks) > (uint64_t)mtime_get_time()){ //do nothing while delay has not yet passed
-	}
+	wait_until(mtime_get_time() + us_to_cpu_ticks(us));
 }
 
 // delay function based on cpu clock tick
 void delay_ticks(uint32_t ticks) {
-	uint64_t initial_time = mtime_get_time();
-	while ((initial_time + ticks) > (uint64_t)mtime_get_time()){ //do nothing while delay has not yet passed
-	}
+	wait_until(mtime_get_time() + ticks);
 }
 
 
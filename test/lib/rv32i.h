@@ -22,9 +22,12 @@
 
 // CLINT memory-mapped registers
 #define CPU_CLK_HZ 12000000
+#ifndef HARTS
+#define HARTS 1 // number of harts (HARTS*THREADS of rv32i_soc, given by test.sh with -DHARTS)
+#endif
 #define MTIME_BASE_ADDRESS 0x80000000
-#define MTIMECMP_BASE_ADDRESS 0x80000008
-#define MSIP_BASE_ADDRESS 0x80000010
+#define MTIMECMP_BASE_ADDRESS 0x80000008 // mtimecmp of hart h is at MTIMECMP_BASE_ADDRESS + 8*h
+#define MSIP_BASE_ADDRESS (MTIMECMP_BASE_ADDRESS + 8*HARTS) // msip of hart h is at MSIP_BASE_ADDRESS + 4*h
 
 // Registers used in HygroPMOD
 #define HYGROI2C_I2C_ADDR   0x40
@@ -91,7 +94,10 @@ uint64_t mtime_get_timecmp(void); // Get compare time register
 void trap_handler_setup(void (*trap_handler)(void)); //setup trap handler by setting MTVEC and initially disabling all interrupts (NOTE: trap handler function MUST HAVE ATTRIBUTE INTERRUPT)
 void enable_software_interrupt(void); // trurn on software interrupt
 void disable_software_interrupt(void); // turn off software interrupt
+void send_software_interrupt(uint32_t hart); // turn on software interrupt of another hart (inter-processor interrupt)
 uint64_t ms_to_cpu_ticks (uint64_t ms); // convert milliseconds input to cpu clock ticks
+// delay functions: with interrupts disabled (MSTATUS.MIE = 0) the core sleeps with WFI, so MTIMECMP and MIE are changed
+// during the delay (set to the end of the delay and MIE.MTIE) and restored afterwards; with interrupts enabled MTIME is polled
 void delay_ms(uint64_t ms); // delay function based on milliseconds
 void delay_ticks(uint32_t ticks); // delay function based on cpu clock tick
 void delay_us(uint64_t us); // delay function based on microseconds
@@ -106,6 +112,14 @@ inline void __attribute__ ((always_inline)) csr_write(const int csr_id, uint32_t
   uint32_t csr_data = data;
   asm volatile ("csrw %[input_i], %[input_j]" :  : [input_i] "i" (csr_id), [input_j] "r" (csr_data));
 }
+static inline uint32_t __attribute__ ((always_inline)) csr_read(const int csr_id) { // read csr
+  uint32_t csr_data;
+  asm volatile ("csrr %[output_i], %[input_i]" : [output_i] "=r" (csr_data) : [input_i] "i" (csr_id));
+  return csr_data;
+}
+static inline void __attribute__ ((always_inline)) wfi(void) { // wait for interrupt (core sleeps until an interrupt enabled in MIE is pending)
+  asm volatile ("wfi");
+}
 
 // Function prototypes for i2c.c [[REPEATED START NOT SUPPORTED]]
 uint8_t i2c_write_address(uint8_t addr); // start i2c by writing slave address (returns slave ack)
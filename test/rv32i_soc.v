@@ -5,7 +5,25 @@
 //`define ICARUS use faster UARt and I2C rate for faster simulation
 
 //complete package containing the rv32i_core, RAM, and IO peripherals (I2C and UART)
-module rv32i_soc #(parameter CLK_FREQ_MHZ=12, PC_RESET=32'h00_00_00_00, TRAP_ADDRESS=32'h00_00_00_00, ZICSR_EXTENSION=1, MEMORY_DEPTH=81920, GPIO_COUNT = 12) ( 
+//HARTS > 1 is a multi-hart (SMP) system: all harts run the same program from PC_RESET (mhartid
+//tells them apart), share the data bus through a round-robin arbiter, and have their own 
+//mtimecmp/msip in the CLINT. Each hart has its own instruction port of the main memory.
+//THREADS > 1 makes each core multithreaded: thread t of core h is hart h*THREADS + t with its
+//own mtimecmp/msip in the CLINT.
+module rv32i_soc #(parameter CLK_FREQ_MHZ=12, PC_RESET=32'h00_00_00_00, TRAP_ADDRESS=32'h00_00_00_00, ZICSR_EXTENSION=1, MEMORY_DEPTH=81920, GPIO_COUNT = 12,
+                   HARTS = 1, //number of harts (1 to 6, hart 0 is m0)
+                   THREADS = 1, //number of hardware threads of each hart (1 to 4, HARTS*THREADS must be at most 6)
+                   ICACHE_WAYS = 0, //instruction cache of each hart (0 = none, 1 = direct-mapped, 2 = 2-way set-associative)
+                   DCACHE_WAYS = 0, //data cache of each hart (0 = none, 1 = direct-mapped, 2 = 2-way set-associative, not coherent between harts)
+                   M_EXTENSION = 1, //multiply/divide instructions (RV32M) of each hart
+                   ZB_EXTENSION = 1, //Zba/Zbb bit-manipulation instructions of each hart
+                   C_EXTENSION = 1, //compressed instructions (RV32C) of each hart
+                   A_EXTENSION = 1, //atomic instructions (RV32A) of each hart
+                   SHADOW_REGS = 0, //shadow register bank for trap handlers of each hart
+                   CLIC = 0, //CLIC interrupt mode of each hart (no local interrupts are connected)
+                   DUAL_ISSUE = 0, //dual issue of each hart (needs C_EXTENSION = 0, instruction ports of main memory return 64-bit doublewords)
+                   DEEP_PIPELINE = 0 //6-stage pipeline of each hart (DUAL_ISSUE is ignored)
+                   ) ( 
     input wire i_clk,
     input wire i_rst,
     //UART
@@ -19,13 +37,28 @@ module rv32i_soc #(parameter CLK_FREQ_MHZ=12, PC_RESET=32'h00_00_00_00, TRAP_ADD
     );
 
     
-    //Instruction Memory Interface
-    wire[31:0] inst; 
-    wire[31:0] iaddr;  
-    wire i_stb_inst;
-    wire o_ack_inst;
+    localparam INST_WORDS = (DUAL_ISSUE != 0 && C_EXTENSION == 0 && DEEP_PIPELINE == 0)? 2 : 1; //32-bit words per instruction fetch (doubleword for dual issue)
+
+    //Instruction Memory Interface (one per hart, hart h at [32*h +: 32] and instruction at [32*INST_WORDS*h +: 32*INST_WORDS])
+    wire[32*INST_WORDS*HARTS-1:0] inst; 
+    wire[32*HARTS-1:0] hart_iaddr;  
+    wire[HARTS-1:0] i_stb_inst;
+    wire[HARTS-1:0] o_ack_inst;
+    wire[31:0] iaddr = hart_iaddr[31:0]; //instruction address of hart 0
     
-    //Data Memory Interface
+    //Data Memory Interface of the harts (hart h at bit h, [32*h +: 32], and [4*h +: 4])
+    wire[HARTS-1:0] core_wb_cyc; //bus cycle active
+    wire[HARTS-1:0] core_wb_stb; //request for read/write access to data memory
+    wire[HARTS-1:0] core_wb_we; //write-enable (1 = write, 0 = read) 
+    wire[32*HARTS-1:0] core_wb_addr; //address of data memory for store/load
+    wire[32*HARTS-1:0] core_wb_data; //data to be stored to memory
+    wire[4*HARTS-1:0] core_wb_sel; //byte strobe for write
+    wire[HARTS-1:0] core_wb_ack; //ack by data memory
+    wire[HARTS-1:0] core_wb_stall; //stall by data memory (or bus is granted to another hart)
+    wire[HARTS-1:0] snoop_we; //write of another hart is accepted by the data memory
+    wire[31:0] snoop_addr; //address of the accepted write
+    
+    //Data Memory Interface (granted hart)
     wire[31:0] i_wb_data_data; //data retrieved from memory
     wire[31:0] o_wb_data_data; //data to be stored to memory
     wire[31:0] wb_addr_data; //address of data memory for store/load
@@ -37,9 +70,20 @@ module rv32i_soc #(parameter CLK_FREQ_MHZ=12, PC_RESET=32'h00_00_00_00, TRAP_ADD
     wire wb_stall_data; //stall by data memory
     
     //Interrupts
-    wire i_external_interrupt = 0; //interrupt from external source
-    wire o_timer_interrupt; //interrupt from CLINT
-    wire o_software_interrupt; //interrupt from CLINT
+    wire[THREADS-1:0] i_external_interrupt = 0; //interrupt from external source (one per thread of hart 0)
+    wire[HARTS*THREADS-1:0] o_timer_interrupt; //interrupt from CLINT (one per hart and thread)
+    wire[HARTS*THREADS-1:0] o_software_interrupt; //interrupt from CLINT (one per hart and thread)
+
+    //Coprocessor Interface
+    wire cop_req_valid; //request to coprocessor
+    wire cop_req_ready; //coprocessor accepts the request
+    wire cop_custom1; //opcode of custom instruction (0 = custom-0, 1 = custom-1)
+    wire[2:0] cop_funct3; //funct3 of custom instruction
+    wire[6:0] cop_funct7; //funct7 of custom instruction
+    wire[31:0] cop_rs1; //rs1 value of custom instruction
+    wire[31:0] cop_rs2; //rs2 value of custom instruction
+    wire cop_rsp_valid; //response of coprocessor
+    wire[31:0] cop_rsp_data; //value to be written to rd of custom instruction
     
     //Memory Wrapper
     wire device0_wb_cyc;
@@ -102,31 +146,149 @@ module rv32i_soc #(parameter CLK_FREQ_MHZ=12, PC_RESET=32'h00_00_00_00, TRAP_ADD
     wire device5_wb_stall;
     wire[31:0] i_device5_wb_data;
 
-    rv32i_core #(.PC_RESET(PC_RESET), .TRAP_ADDRESS(TRAP_ADDRESS), .ZICSR_EXTENSION(ZICSR_EXTENSION)) m0( //main RV32I core
+    rv32i_core #(.PC_RESET(PC_RESET), .TRAP_ADDRESS(TRAP_ADDRESS), .ZICSR_EXTENSION(ZICSR_EXTENSION), .COPROCESSOR(1), .HART_ID(0), .MULTI_HART(HARTS > 1), .THREADS(THREADS),
+                 .M_EXTENSION(M_EXTENSION), .ZB_EXTENSION(ZB_EXTENSION), .C_EXTENSION(C_EXTENSION), .A_EXTENSION(A_EXTENSION), .HPM_COUNTERS(4), .SHADOW_REGS(SHADOW_REGS), .CLIC(CLIC), .DUAL_ISSUE(DUAL_ISSUE), .DEEP_PIPELINE(DEEP_PIPELINE), .BRANCH_PREDICTOR(2), .RAS_DEPTH(8), .EARLY_BRANCH(1), .EARLY_TRAP(1), .PREFETCH_DEPTH(4), .DATA_MAX_REQUESTS(4), .STORE_BUFFER_DEPTH(4), .ICACHE_WAYS(ICACHE_WAYS), .DCACHE_WAYS(DCACHE_WAYS)) m0( //main RV32I core (hart 0)
         .i_clk(i_clk),
         .i_rst_n(!i_rst),
         //Instruction Memory Interface
-        .i_inst(inst), //32-bit instruction
-        .o_iaddr(iaddr), //address of instruction 
-        .o_stb_inst(i_stb_inst), //request for read access to instruction memory
-        .i_ack_inst(o_ack_inst),  //ack (high if new instruction is ready)
+        .i_inst(inst[32*INST_WORDS-1:0]), //32-bit instruction (64-bit doubleword when dual issue)
+        .o_iaddr(hart_iaddr[31:0]), //address of instruction 
+        .o_stb_inst(i_stb_inst[0]), //request for read access to instruction memory
+        .i_ack_inst(o_ack_inst[0]),  //ack (high if new instruction is ready)
         //Data Memory Interface
-        .o_wb_cyc_data(wb_cyc_data), //bus cycle active (1 = normal operation, 0 = all ongoing transaction are to be cancelled)
-        .o_wb_stb_data(wb_stb_data), //request for read/write access to data memory
-        .o_wb_we_data(wb_we_data), //write-enable (1 = write, 0 = read)
-        .o_wb_addr_data(wb_addr_data), //address of data memory for store/load
-        .o_wb_data_data(o_wb_data_data), //data to be stored to memory
-        .o_wb_sel_data(wb_sel_data), //byte strobe for write (1 = write the byte) {byte3,byte2,byte1,byte0}
-        .i_wb_ack_data(wb_ack_data), //ack by data memory (high when read data is ready or when write data is already written)
-        .i_wb_stall_data(wb_stall_data), //stall by data memory
+        .o_wb_cyc_data(core_wb_cyc[0]), //bus cycle active (1 = normal operation, 0 = all ongoing transaction are to be cancelled)
+        .o_wb_stb_data(core_wb_stb[0]), //request for read/write access to data memory
+        .o_wb_we_data(core_wb_we[0]), //write-enable (1 = write, 0 = read)
+        .o_wb_addr_data(core_wb_addr[31:0]), //address of data memory for store/load
+        .o_wb_data_data(core_wb_data[31:0]), //data to be stored to memory
+        .o_wb_sel_data(core_wb_sel[3:0]), //byte strobe for write (1 = write the byte) {byte3,byte2,byte1,byte0}
+        .i_wb_ack_data(core_wb_ack[0]), //ack by data memory (high when read data is ready or when write data is already written)
+        .i_wb_stall_data(core_wb_stall[0]), //stall by data memory
         .i_wb_data_data(i_wb_data_data), //data retrieved from memory
+        .i_snoop_we(snoop_we[0]), //write of another hart is accepted by the data memory
+        .i_snoop_addr(snoop_addr), //address of the write of another hart
         //Interrupts
         .i_external_interrupt(i_external_interrupt), //interrupt from external source
-        .i_software_interrupt(o_software_interrupt), //interrupt from software (inter-processor interrupt)
-        .i_timer_interrupt(o_timer_interrupt) //interrupt from timer
+        .i_software_interrupt(o_software_interrupt[THREADS-1:0]), //interrupt from software (inter-processor interrupt)
+        .i_timer_interrupt(o_timer_interrupt[THREADS-1:0]), //interrupt from timer
+        .i_clic_interrupt(16'b0), //local interrupts (CLIC)
+        //Coprocessor Interface
+        .o_cop_req_valid(cop_req_valid), //request to coprocessor (held until accepted)
+        .i_cop_req_ready(cop_req_ready), //coprocessor accepts the request
+        .o_cop_custom1(cop_custom1), //opcode of custom instruction (0 = custom-0, 1 = custom-1)
+        .o_cop_funct3(cop_funct3), //funct3 of custom instruction
+        .o_cop_funct7(cop_funct7), //funct7 of custom instruction
+        .o_cop_rs1(cop_rs1), //rs1 value of custom instruction
+        .o_cop_rs2(cop_rs2), //rs2 value of custom instruction
+        .i_cop_rsp_valid(cop_rsp_valid), //response of coprocessor
+        .i_cop_rsp_data(cop_rsp_data) //value to be written to rd of custom instruction
      );
+
+    cop_accelerator accelerator( //example coprocessor for custom instructions (CRC-32 and multiply-accumulate)
+        .clk(i_clk),
+        .rst_n(!i_rst),
+        .i_req_valid(cop_req_valid), //request from core
+        .o_req_ready(cop_req_ready), //request is accepted
+        .i_custom1(cop_custom1), //opcode of custom instruction (0 = custom-0, 1 = custom-1)
+        .i_funct3(cop_funct3), //funct3 of custom instruction
+        .i_funct7(cop_funct7), //funct7 of custom instruction
+        .i_rs1(cop_rs1), //rs1 value of custom instruction
+        .i_rs2(cop_rs2), //rs2 value of custom instruction
+        .o_rsp_valid(cop_rsp_valid), //response to core
+        .o_rsp_data(cop_rsp_data) //value to be written to rd
+    );
+
+    //harts 1 to HARTS-1 (same configuration as hart 0 but with their own mhartid and coprocessor)
+    genvar h;
+    generate
+        for(h = 1; h < HARTS; h = h + 1) begin : harts
+            wire cop_req_valid, cop_req_ready, cop_custom1, cop_rsp_valid;
+            wire[2:0] cop_funct3;
+            wire[6:0] cop_funct7;
+            wire[31:0] cop_rs1, cop_rs2, cop_rsp_data;
+
+            rv32i_core #(.PC_RESET(PC_RESET), .TRAP_ADDRESS(TRAP_ADDRESS), .ZICSR_EXTENSION(ZICSR_EXTENSION), .COPROCESSOR(1), .HART_ID(h*THREADS), .MULTI_HART(1), .THREADS(THREADS),
+                         .M_EXTENSION(M_EXTENSION), .ZB_EXTENSION(ZB_EXTENSION), .C_EXTENSION(C_EXTENSION), .A_EXTENSION(A_EXTENSION), .HPM_COUNTERS(4), .SHADOW_REGS(SHADOW_REGS), .CLIC(CLIC), .DUAL_ISSUE(DUAL_ISSUE), .DEEP_PIPELINE(DEEP_PIPELINE), .BRANCH_PREDICTOR(2), .RAS_DEPTH(8), .EARLY_BRANCH(1), .EARLY_TRAP(1), .PREFETCH_DEPTH(4), .DATA_MAX_REQUESTS(4), .STORE_BUFFER_DEPTH(4), .ICACHE_WAYS(ICACHE_WAYS), .DCACHE_WAYS(DCACHE_WAYS)) core( //hart h
+                .i_clk(i_clk),
+                .i_rst_n(!i_rst),
+                //Instruction Memory Interface
+                .i_inst(inst[32*INST_WORDS*h +: 32*INST_WORDS]),
+                .o_iaddr(hart_iaddr[32*h +: 32]),
+                .o_stb_inst(i_stb_inst[h]),
+                .i_ack_inst(o_ack_inst[h]),
+                //Data Memory Interface
+                .o_wb_cyc_data(core_wb_cyc[h]),
+                .o_wb_stb_data(core_wb_stb[h]),
+                .o_wb_we_data(core_wb_we[h]),
+                .o_wb_addr_data(core_wb_addr[32*h +: 32]),
+                .o_wb_data_data(core_wb_data[32*h +: 32]),
+                .o_wb_sel_data(core_wb_sel[4*h +: 4]),
+                .i_wb_ack_data(core_wb_ack[h]),
+                .i_wb_stall_data(core_wb_stall[h]),
+                .i_wb_data_data(i_wb_data_data),
+                .i_snoop_we(snoop_we[h]),
+                .i_snoop_addr(snoop_addr),
+                //Interrupts
+                .i_external_interrupt({THREADS{1'b0}}),
+                .i_software_interrupt(o_software_interrupt[THREADS*h +: THREADS]),
+                .i_timer_interrupt(o_timer_interrupt[THREADS*h +: THREADS]),
+                .i_clic_interrupt(16'b0),
+                //Coprocessor Interface
+                .o_cop_req_valid(cop_req_valid),
+                .i_cop_req_ready(cop_req_ready),
+                .o_cop_custom1(cop_custom1),
+                .o_cop_funct3(cop_funct3),
+                .o_cop_funct7(cop_funct7),
+                .o_cop_rs1(cop_rs1),
+                .o_cop_rs2(cop_rs2),
+                .i_cop_rsp_valid(cop_rsp_valid),
+                .i_cop_rsp_data(cop_rsp_data)
+            );
+
+            cop_accelerator accelerator(
+                .clk(i_clk),
+                .rst_n(!i_rst),
+                .i_req_valid(cop_req_valid),
+                .o_req_ready(cop_req_ready),
+                .i_custom1(cop_custom1),
+                .i_funct3(cop_funct3),
+                .i_funct7(cop_funct7),
+                .i_rs1(cop_rs1),
+                .i_rs2(cop_rs2),
+                .o_rsp_valid(cop_rsp_valid),
+                .o_rsp_data(cop_rsp_data)
+            );
+        end
+    endgenerate
+
+    bus_arbiter #(.MASTERS(HARTS)) arbiter( //round-robin arbiter of the data bus of the harts
+        .i_clk(i_clk),
+        .i_rst(i_rst),
+        //Harts
+        .i_wb_cyc(core_wb_cyc),
+        .i_wb_stb(core_wb_stb),
+        .i_wb_we(core_wb_we),
+        .i_wb_addr(core_wb_addr),
+        .i_wb_data(core_wb_data),
+        .i_wb_sel(core_wb_sel),
+        .o_wb_ack(core_wb_ack),
+        .o_wb_stall(core_wb_stall),
+        .o_snoop_we(snoop_we),
+        .o_snoop_addr(snoop_addr),
+        //Memory Wrapper
+        .o_wb_cyc(wb_cyc_data),
+        .o_wb_stb(wb_stb_data),
+        .o_wb_we(wb_we_data),
+        .o_wb_addr(wb_addr_data),
+        .o_wb_data(o_wb_data_data),
+        .o_wb_sel(wb_sel_data),
+        .i_wb_ack(wb_ack_data),
+        .i_wb_stall(wb_stall_data)
+    );
         
     memory_wrapper wrapper( //decodes address and access the corresponding memory-mapped device
+        .i_clk(i_clk),
+        .i_rst(i_rst),
         //RISC-V Core
         .i_wb_cyc(wb_cyc_data),
         .i_wb_stb(wb_stb_data),
@@ -206,10 +368,10 @@ module rv32i_soc #(parameter CLK_FREQ_MHZ=12, PC_RESET=32'h00_00_00_00, TRAP_ADD
     );   
 
     // DEVICE 0
-     main_memory #(.MEMORY_DEPTH(MEMORY_DEPTH)) m1( //Instruction and Data memory (combined memory) 
+     main_memory #(.MEMORY_DEPTH(MEMORY_DEPTH), .INST_PORTS(HARTS), .INST_WORDS(INST_WORDS)) m1( //Instruction and Data memory (combined memory) 
         .i_clk(i_clk),
         // Instruction Memory
-        .i_inst_addr(iaddr[$clog2(MEMORY_DEPTH)-1:0]),
+        .i_inst_addr(hart_iaddr),
         .o_inst_out(inst),
         .i_stb_inst(i_stb_inst), 
         .o_ack_inst(o_ack_inst), 
@@ -225,12 +387,20 @@ module rv32i_soc #(parameter CLK_FREQ_MHZ=12, PC_RESET=32'h00_00_00_00, TRAP_ADD
         .o_wb_data(i_device0_wb_data)
     );
 
+    //the CLINT registers of at most 6 harts (every thread is a hart) fit below the UART at h50
+    generate
+        if(HARTS*THREADS > 6) begin : clint_check
+            HARTS_times_THREADS_must_be_at_most_6 invalid_parameters(); //undefined module: elaboration fails
+        end
+    endgenerate
+
     // DEVICE 1
     rv32i_clint #( //Core Logic Interrupt [memory-mapped to < h50 (MSB=1)]
         .CLK_FREQ_MHZ(CLK_FREQ_MHZ), //input clock frequency in MHz
         .MTIME_BASE_ADDRESS(32'h8000_0000),  //Machine-level timer register (64-bits, 2 words)
-        .MTIMECMP_BASE_ADDRESS(32'h8000_0008), //Machine-level Time Compare register (64-bits, 2 words)
-        .MSIP_BASE_ADDRESS(32'h8000_0010) //Machine-level Software Interrupt register
+        .MTIMECMP_BASE_ADDRESS(32'h8000_0008), //Machine-level Time Compare register (64-bits, 2 words per hart)
+        .MSIP_BASE_ADDRESS(32'h8000_0008 + 8*HARTS*THREADS), //Machine-level Software Interrupt register (1 word per hart, 32'h8000_0010 for a single hart)
+        .HARTS(HARTS*THREADS) //number of harts (every thread is a hart)
     ) clint  (
         .clk(i_clk),
         .rst_n(!i_rst),
@@ -437,6 +607,7 @@ endmodule
 
 
 module memory_wrapper ( //decodes address and access the corresponding memory-mapped device
+    input wire i_clk, i_rst,
     //RISC-V Core
     input wire i_wb_cyc,
     input wire i_wb_stb,
@@ -516,6 +687,43 @@ module memory_wrapper ( //decodes address and access the corresponding memory-ma
 );
 
 
+    //the core can have multiple outstanding requests (pipelined wishbone) and acks must come back
+    //in order, so a request to another device must wait until all requests to the current device
+    //are acknowledged. Ack and read data are taken from the device with outstanding requests.
+    reg[2:0] device_d; //device addressed by the current request (0 = RAM, 1 = CLINT, 2 = UART, 3 = I2C, 4 = GPIO, 5 = DDR3, 7 = none)
+    reg[2:0] device_q; //device with outstanding requests
+    reg[3:0] pending_requests; //number of requests sent to device_q which are not yet acknowledged
+    wire[2:0] device = (pending_requests != 0)? device_q : device_d; //device currently connected to the core
+    wire stb = i_wb_stb && (device == device_d); //request is sent only if addressed device is the one connected to the core
+
+    always @(posedge i_clk, posedge i_rst) begin
+        if(i_rst) begin
+            device_q <= 0;
+            pending_requests <= 0;
+        end
+        else if(!i_wb_cyc) begin //bus cycle ended so all outstanding requests are cancelled
+            pending_requests <= 0;
+        end
+        else begin
+            if(stb && !o_wb_stall) device_q <= device_d;
+            pending_requests <= pending_requests + {3'b0,(stb && !o_wb_stall)} - {3'b0,o_wb_ack};
+        end
+    end
+
+    always @* begin 
+        // Memory-mapped peripherals address has MSB set to 1
+        device_d = 7;
+        if(i_wb_addr[31]) begin
+            if(i_wb_addr[30]) device_d = 5; //Device 5 Interface (DDR3) (last two bits of address are high)
+            else if(i_wb_addr[11:0] < 12'h50) device_d = 1; //Device 1 Interface (CLINT) (20 words)
+            else if(i_wb_addr[11:0] < 12'hA0) device_d = 2; //Device 2 Interface (UART) (20 words)
+            else if(i_wb_addr[11:0] < 12'hF0) device_d = 3; //Device 3 Interface (I2C) (20 words)
+            else if(i_wb_addr[11:0] < 12'h140) device_d = 4; //Device 4 Interface (GPIO) (20 words)
+        end
+        // Else access RAM
+        else device_d = 0; //Device 0 Interface (RAM)
+    end
+
     always @* begin 
         o_wb_ack = 0;
         o_wb_stall = 0;
@@ -563,11 +771,22 @@ module memory_wrapper ( //decodes address and access the corresponding memory-ma
         o_device5_wb_data = 0;
         o_device5_wb_sel = 0;
 
-        // Memory-mapped peripherals address has MSB set to 1
-        if(i_wb_addr[31]) begin
-            if(i_wb_addr[11:0] < 12'h50) begin //Device 1 Interface (CLINT) (20 words)
+        case(device)
+            0: begin //Device 0 Interface (RAM)
+                o_device0_wb_cyc = i_wb_cyc;
+                o_device0_wb_stb = stb;
+                o_device0_wb_we = i_wb_we;
+                o_device0_wb_addr = i_wb_addr; 
+                o_device0_wb_data = i_wb_data;
+                o_device0_wb_sel = i_wb_sel; 
+                o_wb_ack = i_device0_wb_ack;
+                o_wb_stall = i_device0_wb_stall;
+                o_wb_data = i_device0_wb_data;
+            end
+
+            1: begin //Device 1 Interface (CLINT)
                 o_device1_wb_cyc = i_wb_cyc;
-                o_device1_wb_stb = i_wb_stb;
+                o_device1_wb_stb = stb;
                 o_device1_wb_we = i_wb_we;
                 o_device1_wb_addr = i_wb_addr; 
                 o_device1_wb_data = i_wb_data;
@@ -577,9 +796,9 @@ module memory_wrapper ( //decodes address and access the corresponding memory-ma
                 o_wb_data = i_device1_wb_data;
             end
             
-            if(i_wb_addr[11:0] >= 12'h50 && i_wb_addr[11:0] < 12'hA0) begin //Device 2 Interface (UART) (20 words)
+            2: begin //Device 2 Interface (UART)
                 o_device2_wb_cyc = i_wb_cyc;
-                o_device2_wb_stb = i_wb_stb;
+                o_device2_wb_stb = stb;
                 o_device2_wb_we = i_wb_we;
                 o_device2_wb_addr = i_wb_addr; 
                 o_device2_wb_data = i_wb_data;
@@ -589,9 +808,9 @@ module memory_wrapper ( //decodes address and access the corresponding memory-ma
                 o_wb_data = i_device2_wb_data;
             end
 
-            if(i_wb_addr[11:0] >= 12'hA0 && i_wb_addr[11:0] < 12'hF0) begin //Device 3 Interface (I2C) (20 words)
+            3: begin //Device 3 Interface (I2C)
                 o_device3_wb_cyc = i_wb_cyc;
-                o_device3_wb_stb = i_wb_stb;
+                o_device3_wb_stb = stb;
                 o_device3_wb_we = i_wb_we;
                 o_device3_wb_addr = i_wb_addr; 
                 o_device3_wb_data = i_wb_data;
@@ -601,9 +820,9 @@ module memory_wrapper ( //decodes address and access the corresponding memory-ma
                 o_wb_data = i_device3_wb_data;
             end
             
-            if(i_wb_addr[11:0] >= 12'hF0 && i_wb_addr[11:0] < 12'h140) begin //Device 4 Interface (GPIO) (20 words)
+            4: begin //Device 4 Interface (GPIO)
                 o_device4_wb_cyc = i_wb_cyc;
-                o_device4_wb_stb = i_wb_stb;
+                o_device4_wb_stb = stb;
                 o_device4_wb_we = i_wb_we;
                 o_device4_wb_addr = i_wb_addr; 
                 o_device4_wb_data = i_wb_data;
@@ -613,9 +832,9 @@ module memory_wrapper ( //decodes address and access the corresponding memory-ma
                 o_wb_data = i_device4_wb_data;
             end
 
-            if(i_wb_addr[30]) begin //Device 5 Interface (DDR3) (last two bits of address are high)
+            5: begin //Device 5 Interface (DDR3)
                 o_device5_wb_cyc = i_wb_cyc;
-                o_device5_wb_stb = i_wb_stb;
+                o_device5_wb_stb = stb;
                 o_device5_wb_we = i_wb_we;
                 o_device5_wb_addr = i_wb_addr; 
                 o_device5_wb_data = i_wb_data;
@@ -624,30 +843,87 @@ module memory_wrapper ( //decodes address and access the corresponding memory-ma
                 o_wb_stall = i_device5_wb_stall;
                 o_wb_data = i_device5_wb_data;
             end
+
+            default: ;
+        endcase
+
+        //request to another device must wait until connected device has acknowledged all its requests
+        if(i_wb_stb && !stb) o_wb_stall = 1;
+    end
+ 
+endmodule
+module bus_arbiter #(parameter MASTERS = 2) ( //round-robin arbiter that shares the data bus of the harts (masters) with the memory wrapper
+    input wire i_clk, i_rst,
+    //Harts (master m at bit m, [32*m +: 32], and [4*m +: 4])
+    input wire[MASTERS-1:0] i_wb_cyc,
+    input wire[MASTERS-1:0] i_wb_stb,
+    input wire[MASTERS-1:0] i_wb_we,
+    input wire[32*MASTERS-1:0] i_wb_addr,
+    input wire[32*MASTERS-1:0] i_wb_data,
+    input wire[4*MASTERS-1:0] i_wb_sel,
+    output reg[MASTERS-1:0] o_wb_ack,
+    output reg[MASTERS-1:0] o_wb_stall,
+    output reg[MASTERS-1:0] o_snoop_we, //write of another master is accepted (clears the LR reservation of master m)
+    output wire[31:0] o_snoop_addr, //address of the accepted write
+
+    //Memory Wrapper
+    output wire o_wb_cyc,
+    output wire o_wb_stb,
+    output wire o_wb_we,
+    output wire[31:0] o_wb_addr,
+    output wire[31:0] o_wb_data,
+    output wire[3:0] o_wb_sel,
+    input wire i_wb_ack,
+    input wire i_wb_stall
+);
+
+    //the bus is granted to one master for its whole bus cycle (i_wb_cyc) so its outstanding requests 
+    //are acknowledged in order and the read-modify-write of AMO (locked by i_wb_cyc) is atomic. The
+    //grant only moves when the granted master ends its bus cycle, and goes to the next requesting
+    //master after it (round-robin). Read data is shared by all masters (only the granted one gets the ack).
+    localparam GRANT_WIDTH = (MASTERS > 1)? $clog2(MASTERS) : 1;
+    reg[GRANT_WIDTH-1:0] grant; //master that owns the bus
+    reg[GRANT_WIDTH-1:0] grant_d; //next requesting master after the granted master
+    integer m, k, n;
+
+    always @* begin
+        grant_d = grant;
+        for(k = MASTERS - 1; k > 0; k = k - 1) begin //nearest requesting master after the granted master wins
+            n = grant + k;
+            if(n >= MASTERS) n = n - MASTERS;
+            if(i_wb_cyc[n]) grant_d = n[GRANT_WIDTH-1:0];
         end
-        
-        // Else access RAM
-        else begin  //Device 0 Interface (RAM)
-            o_device0_wb_cyc = i_wb_cyc;
-            o_device0_wb_stb = i_wb_stb;
-            o_device0_wb_we = i_wb_we;
-            o_device0_wb_addr = i_wb_addr; 
-            o_device0_wb_data = i_wb_data;
-            o_device0_wb_sel = i_wb_sel; 
-            o_wb_ack = i_device0_wb_ack;
-            o_wb_stall = i_device0_wb_stall;
-            o_wb_data = i_device0_wb_data;
+    end
+
+    always @(posedge i_clk, posedge i_rst) begin
+        if(i_rst) grant <= 0;
+        else if(!i_wb_cyc[grant]) grant <= grant_d; //granted master is idle
+    end
+
+    assign o_wb_cyc = i_wb_cyc[grant];
+    assign o_wb_stb = i_wb_stb[grant];
+    assign o_wb_we = i_wb_we[grant];
+    assign o_wb_addr = i_wb_addr[32*grant +: 32];
+    assign o_wb_data = i_wb_data[32*grant +: 32];
+    assign o_wb_sel = i_wb_sel[4*grant +: 4];
+    assign o_snoop_addr = o_wb_addr;
+
+    always @* begin
+        for(m = 0; m < MASTERS; m = m + 1) begin
+            o_wb_ack[m] = i_wb_ack && grant == m;
+            o_wb_stall[m] = i_wb_stall || grant != m; //masters without the bus wait 
+            o_snoop_we[m] = o_wb_cyc && o_wb_stb && o_wb_we && !i_wb_stall && grant != m;
         end
     end
- 
+
 endmodule
-module main_memory #(parameter MEMORY_DEPTH=1024) ( //Instruction and Data memory (combined memory)
+module main_memory #(parameter MEMORY_DEPTH=1024, INST_PORTS=1, INST_WORDS=1) ( //Instruction and Data memory (combined memory)
     input wire i_clk,
-    // Instruction Memory
-    input wire[$clog2(MEMORY_DEPTH)-1:0] i_inst_addr,
-    output reg[31:0] o_inst_out,
-    input wire i_stb_inst, // request for instruction
-    output reg o_ack_inst, //ack (high if new instruction is now on the bus)
+    // Instruction Memory (INST_PORTS read ports, port p at [32*p +: 32], [32*INST_WORDS*p +: 32*INST_WORDS], and bit p)
+    input wire[32*INST_PORTS-1:0] i_inst_addr,
+    output reg[32*INST_WORDS*INST_PORTS-1:0] o_inst_out, //INST_WORDS = 2 reads the doubleword at i_inst_addr[31:3]
+    input wire[INST_PORTS-1:0] i_stb_inst, // request for instruction
+    output reg[INST_PORTS-1:0] o_ack_inst, //ack (high if new instruction is now on the bus)
     // Data Memory
     input wire i_wb_cyc,
     input wire i_wb_stb,
@@ -660,7 +936,7 @@ module main_memory #(parameter MEMORY_DEPTH=1024) ( //Instruction and Data memor
     output reg[31:0] o_wb_data
 );
     reg[31:0] memory_regfile[MEMORY_DEPTH/4 - 1:0];
-    integer i;
+    integer i, p, w;
     assign o_wb_stall = 0; // never stall
 
     initial begin //initialize memory to zero
@@ -673,7 +949,11 @@ module main_memory #(parameter MEMORY_DEPTH=1024) ( //Instruction and Data memor
     always @(posedge i_clk) begin 
         o_ack_inst <= i_stb_inst; //go high next cycle after receiving request (data o_inst_out is also sent at next cycle)
         o_wb_ack <= i_wb_stb && i_wb_cyc;
-        o_inst_out <= memory_regfile[{i_inst_addr>>2}]; //read instruction 
+        for(p = 0; p < INST_PORTS; p = p + 1) begin //each hart has its own instruction read port
+            for(w = 0; w < INST_WORDS; w = w + 1) begin
+                o_inst_out[32*(INST_WORDS*p + w) +: 32] <= memory_regfile[(i_inst_addr[32*p +: $clog2(MEMORY_DEPTH)] >> 2) / INST_WORDS * INST_WORDS + w]; //read instruction 
+            end
+        end
         o_wb_data <= memory_regfile[i_wb_addr[$clog2(MEMORY_DEPTH)-1:2]]; //read data    
     end
 
@@ -1192,8 +1472,9 @@ module rv32i_clint #( //Core Logic Interrupt
     parameter CLK_FREQ_MHZ = 12, //input clock frequency in MHz
     // A MTIMER device has two separate base addresses: one for the MTIME register and another for the MTIMECMP registers. 
     parameter MTIME_BASE_ADDRESS = 8008,
-              MTIMECMP_BASE_ADDRESS = 8016,
-              MSIP_BASE_ADDRESS = 8024
+              MTIMECMP_BASE_ADDRESS = 8016, //mtimecmp of hart h is at MTIMECMP_BASE_ADDRESS + 8*h
+              MSIP_BASE_ADDRESS = 8024, //msip of hart h is at MSIP_BASE_ADDRESS + 4*h
+              HARTS = 1 //number of harts connected to the CLINT
 )(
         input wire clk,
         input wire rst_n,
@@ -1206,9 +1487,9 @@ module rv32i_clint #( //Core Logic Interrupt
         output reg o_wb_ack,
         output wire o_wb_stall,
         output reg[31:0] o_wb_data,
-        // Interrupts
-        output wire o_timer_interrupt,
-        output wire o_software_interrupt
+        // Interrupts (one per hart)
+        output wire[HARTS-1:0] o_timer_interrupt,
+        output wire[HARTS-1:0] o_software_interrupt
 );
     // This is based from RISC-V Advanced Core Local Interruptor
     // Specification: https://github.com/riscv/riscv-aclint/blob/main/riscv-aclint.adoc
@@ -1219,8 +1500,9 @@ module rv32i_clint #( //Core Logic Interrupt
     // It has a single fixed-frequency monotonic time counter (MTIME) register and a time 
     // compare register (MTIMECMP) for each HART connected to the MTIMER device.
     reg[63:0] mtime = 0;
-    reg[63:0] mtimecmp = {64{1'b1}};   
-    reg msip = 0; //Inter-processor (or software) interrupts
+    reg[63:0] mtimecmp[HARTS-1:0];   
+    reg[HARTS-1:0] msip = 0; //Inter-processor (or software) interrupts
+    integer h;
     assign o_wb_stall = 0;
 
    //READ memory-mapped registers 
@@ -1233,9 +1515,11 @@ module rv32i_clint #( //Core Logic Interrupt
             if(i_wb_stb && i_wb_cyc && !i_wb_we) begin //read the memory-mapped register
                 if(i_wb_addr == MTIME_BASE_ADDRESS) o_wb_data <= mtime[31:0]; //first half 
                 else if(i_wb_addr == MTIME_BASE_ADDRESS + 4) o_wb_data <= mtime[63:32]; //second half
-                if(i_wb_addr == MTIMECMP_BASE_ADDRESS) o_wb_data <= mtimecmp[31:0]; //first half
-                else if(i_wb_addr == MTIMECMP_BASE_ADDRESS + 4) o_wb_data <= mtimecmp[63:32]; //second half
-                if(i_wb_addr == MSIP_BASE_ADDRESS) o_wb_data <= {31'b0, msip}; //machine software interrupt
+                for(h = 0; h < HARTS; h = h + 1) begin
+                    if(i_wb_addr == MTIMECMP_BASE_ADDRESS + 8*h) o_wb_data <= mtimecmp[h][31:0]; //first half
+                    else if(i_wb_addr == MTIMECMP_BASE_ADDRESS + 8*h + 4) o_wb_data <= mtimecmp[h][63:32]; //second half
+                    if(i_wb_addr == MSIP_BASE_ADDRESS + 4*h) o_wb_data <= {31'b0, msip[h]}; //machine software interrupt
+                end
             end
             o_wb_ack <= i_wb_stb && i_wb_cyc; //wishbone protocol stb-ack mechanism
         end
@@ -1246,17 +1530,21 @@ module rv32i_clint #( //Core Logic Interrupt
     always @(posedge clk, negedge rst_n) begin
         if(!rst_n) begin
             mtime <= 64'd0;
-            mtimecmp <= {64{1'b1}}; //timer interrupt will be triggered unintentionally if reset at 0 (equal to mtime) 
-                                  //thus we set it at highest value (all 1s)
+            for(h = 0; h < HARTS; h = h + 1) begin
+                mtimecmp[h] <= {64{1'b1}}; //timer interrupt will be triggered unintentionally if reset at 0 (equal to mtime) 
+                                         //thus we set it at highest value (all 1s)
+            end
             msip <= 0;
         end
         else begin
             if(i_wb_stb && i_wb_cyc && i_wb_we) begin //write to the memory-mapped registers
                 if(i_wb_addr == MTIME_BASE_ADDRESS)  mtime[31:0] <= i_wb_data; //first half 
                 else if(i_wb_addr == MTIME_BASE_ADDRESS + 4) mtime[63:32] <= i_wb_data; //second half
-                if(i_wb_addr == MTIMECMP_BASE_ADDRESS) mtimecmp[31:0] <= i_wb_data; //first half
-                else if(i_wb_addr == MTIMECMP_BASE_ADDRESS + 4) mtimecmp[63:32] <= i_wb_data; //second half
-                if(i_wb_addr == MSIP_BASE_ADDRESS) msip <= i_wb_data[0]; //machine software interrupt
+                for(h = 0; h < HARTS; h = h + 1) begin
+                    if(i_wb_addr == MTIMECMP_BASE_ADDRESS + 8*h) mtimecmp[h][31:0] <= i_wb_data; //first half
+                    else if(i_wb_addr == MTIMECMP_BASE_ADDRESS + 8*h + 4) mtimecmp[h][63:32] <= i_wb_data; //second half
+                    if(i_wb_addr == MSIP_BASE_ADDRESS + 4*h) msip[h] <= i_wb_data[0]; //machine software interrupt
+                end
             end
             mtime <= mtime + 1'b1; //increment every clock tick (so timer freq is same as cpu clock freq)
         end
@@ -1266,7 +1554,12 @@ module rv32i_clint #( //Core Logic Interrupt
     //A machine timer interrupt becomes pending whenever mtime contains a value greater than or equal to mtimecmp, 
     //treating the values as unsigned integers. The interrupt remains posted until mtimecmp becomes greater than
     //mtime (typically as a result of writing mtimecmp). 
-    assign o_timer_interrupt = (mtime >= mtimecmp);
+    genvar g;
+    generate
+        for(g = 0; g < HARTS; g = g + 1) begin : timer_interrupt
+            assign o_timer_interrupt[g] = (mtime >= mtimecmp[g]);
+        end
+    endgenerate
 
     //Each MSIP register is a 32-bit wide WARL register where the upper 31 bits are wired to zero.
     //The least significant bit is reflected in MSIP of the mip CSR. A machine-level software interrupt 
@@ -1355,3 +1648,78 @@ endmodule
 
 
 
+
+
+
+module cop_accelerator ( //example coprocessor for custom instructions (CRC-32 and multiply-accumulate)
+        input wire clk,
+        input wire rst_n,
+        // Coprocessor Interface
+        input wire i_req_valid, //request from core
+        output wire o_req_ready, //request is accepted
+        input wire i_custom1, //opcode of custom instruction (0 = custom-0, 1 = custom-1)
+        input wire[2:0] i_funct3, //funct3 of custom instruction
+        input wire[6:0] i_funct7, //funct7 of custom instruction
+        input wire[31:0] i_rs1, //rs1 value of custom instruction
+        input wire[31:0] i_rs2, //rs2 value of custom instruction
+        output reg o_rsp_valid, //response to core
+        output reg[31:0] o_rsp_data //value to be written to rd
+    );
+    // custom-0 (funct7 = 0): rd = CRC-32 (reflected, polynomial 0xEDB88320) of rs1 updated with the
+    //      byte (funct3 = 0), halfword (funct3 = 1), or word (funct3 = 2) at rs2, one bit per clock cycle
+    //      (no initial value and final XOR, these are done by software)
+    // custom-1 (funct7 = 0): funct3 = 0: accumulator = accumulator + rs1*rs2, rd = new accumulator value (one clock cycle)
+    //                        funct3 = 1: accumulator = rs1, rd = old accumulator value (one clock cycle)
+    // other custom instructions write 0 to rd
+    localparam CRC32_POLY = 32'hEDB88320;
+    reg busy; //CRC computation is ongoing (next request is not accepted)
+    reg[5:0] count; //remaining bits of CRC computation
+    reg[31:0] crc; 
+    reg[31:0] data; //bits to be shifted to CRC
+    reg[31:0] acc; //accumulator
+    wire[31:0] crc_d = (crc >> 1) ^ (CRC32_POLY & {32{crc[0] ^ data[0]}}); //CRC after shifting in one bit (LSB first)
+    wire[31:0] mac_d = acc + i_rs1*i_rs2;
+    assign o_req_ready = !busy;
+
+    always @(posedge clk, negedge rst_n) begin
+        if(!rst_n) begin
+            busy <= 0;
+            o_rsp_valid <= 0;
+            acc <= 0;
+        end
+        else begin
+            o_rsp_valid <= 0;
+            if(busy) begin 
+                crc <= crc_d;
+                data <= data >> 1;
+                count <= count - 1;
+                if(count == 1) begin //last bit: send the response
+                    busy <= 0;
+                    o_rsp_valid <= 1;
+                    o_rsp_data <= crc_d;
+                end
+            end
+            else if(i_req_valid) begin
+                if(!i_custom1 && i_funct7 == 0 && i_funct3 <= 3'd2) begin //CRC-32 takes 8, 16, or 32 clock cycles 
+                    busy <= 1;
+                    crc <= i_rs1;
+                    data <= i_rs2;
+                    count <= 6'd8 << i_funct3;
+                end
+                else begin //respond at next clock cycle
+                    o_rsp_valid <= 1;
+                    o_rsp_data <= 0;
+                    if(i_custom1 && i_funct7 == 0 && i_funct3 == 3'd0) begin //multiply-accumulate
+                        acc <= mac_d;
+                        o_rsp_data <= mac_d;
+                    end
+                    if(i_custom1 && i_funct7 == 0 && i_funct3 == 3'd1) begin //swap accumulator
+                        acc <= i_rs1;
+                        o_rsp_data <= acc;
+                    end
+                end
+            end
+        end
+    end
+
+endmodule
@@ -4,11 +4,24 @@
 //`define HALT_ON_ILLEGAL_INSTRUCTION // stop core when instruction is illegal
  //`define HALT_ON_EBREAK // halt core on ebreak
 // `define HALT_ON_ECALL // halt core on ecall
+// `define HALT_ON_EXIT // halt core only when a7 holds the exit code 93
 `include "rv32i_header.vh"
 
 module rv32i_soc_TB;
     parameter MEMORY="memory.mem";
     parameter ZICSR_EXTENSION = 1;
+    parameter HARTS = 1; //number of harts (hart 0 decides when the test ends)
+    parameter THREADS = 1; //number of hardware threads of each hart (thread 0 of hart 0 decides when the test ends)
+    parameter ICACHE_WAYS = 0; //instruction cache of each hart (0 = none, 1 = direct-mapped, 2 = 2-way set-associative)
+    parameter DCACHE_WAYS = 0; //data cache of each hart (0 = none, 1 = direct-mapped, 2 = 2-way set-associative)
+    parameter M_EXTENSION = 1; //multiply/divide instructions (RV32M)
+    parameter ZB_EXTENSION = 1; //Zba/Zbb bit-manipulation instructions
+    parameter C_EXTENSION = 1; //compressed instructions (RV32C)
+    parameter A_EXTENSION = 1; //atomic instructions (RV32A)
+    parameter SHADOW_REGS = 0; //shadow register bank for trap handlers
+    parameter CLIC = 0; //CLIC interrupt mode
+    parameter DUAL_ISSUE = 0; //dual issue (needs C_EXTENSION = 0)
+    parameter DEEP_PIPELINE = 0; //6-stage pipeline
     /******************************* MODIFY ****************************************/
     localparam MEMORY_DEPTH = 81920, //number of memory bytes
                DATA_START_ADDR = 32'h1004; //starting address of data memory to be displayed
@@ -17,9 +30,12 @@ module rv32i_soc_TB;
     reg clk,rst_n;
     reg temp;
     integer i,j;          
+    wire alu_valid = uut.m0.memoryaccess_ce && !uut.m0.memoryaccess_flush; //instruction from the ALU stage is neither a bubble nor flushed (wrong-path ecall/ebreak must not halt the core)
     
     
-    rv32i_soc #(.PC_RESET(32'h00_00_00_00), .MEMORY_DEPTH(MEMORY_DEPTH), .CLK_FREQ_MHZ(100), .TRAP_ADDRESS(32'h00000004), .ZICSR_EXTENSION(ZICSR_EXTENSION)) uut (
+    rv32i_soc #(.PC_RESET(32'h00_00_00_00), .MEMORY_DEPTH(MEMORY_DEPTH), .CLK_FREQ_MHZ(100), .TRAP_ADDRESS(32'h00000004), .ZICSR_EXTENSION(ZICSR_EXTENSION), .HARTS(HARTS), .THREADS(THREADS),
+                .ICACHE_WAYS(ICACHE_WAYS), .DCACHE_WAYS(DCACHE_WAYS), .M_EXTENSION(M_EXTENSION), .ZB_EXTENSION(ZB_EXTENSION),
+                .C_EXTENSION(C_EXTENSION), .A_EXTENSION(A_EXTENSION), .SHADOW_REGS(SHADOW_REGS), .CLIC(CLIC), .DUAL_ISSUE(DUAL_ISSUE), .DEEP_PIPELINE(DEEP_PIPELINE)) uut (
         .i_clk(clk),
         .i_rst(!rst_n)
         );
@@ -69,11 +85,13 @@ module rv32i_soc_TB;
         while(  `ifdef HALT_ON_ILLEGAL_INSTRUCTION
                     uut.iaddr < MEMORY_DEPTH-4 && !(uut.m0.zicsr.m6.i_is_inst_illegal && uut.m0.zicsr.m6.i_ce) //exception testing (halt core only when instruction is illegal)
                 `elsif HALT_ON_EBREAK
-                    !uut.m0.alu_exception[`EBREAK] //ebreak test (halt core on ebreak)
+                    !(alu_valid && uut.m0.alu_exception[`EBREAK]) //ebreak test (halt core on ebreak)
                 `elsif HALT_ON_ECALL
-                    !uut.m0.alu_exception[`ECALL] //ecall test (halt core on ecall)
+                    !(alu_valid && uut.m0.alu_exception[`ECALL]) //ecall test (halt core on ecall)
+                `elsif HALT_ON_EXIT
+                    uut.m0.m0.base_regfile[17] != 32'h5d //trap test with ecall/ebreak in the middle (halt core once a7 is set to 93)
                 `else
-                    !uut.m0.alu_exception[`ECALL] && !uut.m0.alu_exception[`EBREAK] //normal test (halt core on ebreak/ecall)
+                    !(alu_valid && (uut.m0.alu_exception[`ECALL] || uut.m0.alu_exception[`EBREAK])) //normal test (halt core on ebreak/ecall)
                 `endif
              ) begin
              
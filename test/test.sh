@@ -13,7 +13,7 @@ MEMORY=memory.mem   # memory file name (extracted text and data sections from th
 LINKER_SCRIPT=rv32i_linkerscript.ld # linkerscript used by linker to allow user to have control over the layout and memory usage of the program
 ENTRY_CODE=entry.s  # contains the "_start" symbol and initialzes the program (setting the stack pointer and then specify jumping to "main")
 FPIC="-fpic"        # enable PIC (Position Independent Code)
-MARCH="rv32i_zicsr" # specifies the target RISC-V architecture, including the instruction set extensions and microarchitecture features.
+MARCH="rv32i_zicsr" # specifies the target RISC-V architecture, including the instruction set extensions and microarchitecture features (extended by soc_parameters with the extensions enabled on rv32i_soc).
 MABI="ilp32" # specifies the ABI (Application Binary Interface) that should be used when generating code. 
              # The ABI defines how function calls, stack frames, and other low-level details are handled,
 library_files="./lib/*.c" # all custom library files
@@ -49,6 +49,18 @@ then
 elif [ "$1" == "rv32mi" ]
 then
     testfiles="./riscv-tests/isa/rv32mi/*.S"  # RV32 machine-level, integer only [CSRs,system instructions, and exception handling] 
+
+elif [ "$1" == "rv32um" ]
+then
+    testfiles="./riscv-tests/isa/rv32um/*.S"  # RV32 user-level, integer multiplication and division [M extension]
+
+elif [ "$1" == "rv32uc" ]
+then
+    testfiles="./riscv-tests/isa/rv32uc/*.S"  # RV32 user-level, compressed instructions [C extension]
+
+elif [ "$1" == "rv32ua" ]
+then
+    testfiles="./riscv-tests/isa/rv32ua/*.S"  # RV32 user-level, atomic instructions [A extension]
     
 elif [ "$1" == "extra" ]
 then
@@ -56,11 +68,11 @@ then
  
 elif [ "$1" == "all" ]
 then
-    testfiles="./riscv-tests/isa/rv32ui/*.S ./riscv-tests/isa/rv32mi/*.S ./extra/*.s ./extra/*.c" # Combination of rv32ui, rv32mi, and mytest
+    testfiles="./riscv-tests/isa/rv32ui/*.S ./riscv-tests/isa/rv32mi/*.S ./riscv-tests/isa/rv32um/*.S ./riscv-tests/isa/rv32uc/*.S ./riscv-tests/isa/rv32ua/*.S ./extra/*.s ./extra/*.c" # Combination of rv32ui, rv32mi, rv32um, rv32uc, rv32ua, and mytest
     
 elif [ "$1" == "" ]
 then
-    testfiles="./riscv-tests/isa/rv32ui/*.S ./riscv-tests/isa/rv32mi/*.S" # Combination of rv32ui and rv32mi tests
+    testfiles="./riscv-tests/isa/rv32ui/*.S ./riscv-tests/isa/rv32mi/*.S ./riscv-tests/isa/rv32um/*.S ./riscv-tests/isa/rv32uc/*.S ./riscv-tests/isa/rv32ua/*.S" # Combination of rv32ui, rv32mi, rv32um, rv32uc, and rv32ua tests
 fi
 
 
@@ -71,11 +83,17 @@ fi
 rtlfiles="../rtl/rv32i_forwarding.v
           ../rtl/rv32i_basereg.v 
           ../rtl/rv32i_fetch.v
+          ../rtl/rv32i_expander.v
           ../rtl/rv32i_decoder.v 
           ../rtl/rv32i_alu.v 
           ../rtl/rv32i_memoryaccess.v 
           ../rtl/rv32i_writeback.v
           ../rtl/rv32i_csr.v
+          ../rtl/rv32i_icache.v
+          ../rtl/rv32i_dcache.v
+          ../rtl/rv32i_operand.v
+          ../rtl/rv32i_skid.v
+          ../rtl/rv32i_threads.v
           ../rtl/rv32i_core.v
           ../test/rv32i_soc.v
           ../test/rv32i_soc_TB.v"
@@ -89,6 +107,116 @@ countmissing=0  # stores total number of missing testfiles
 failedlist=""   # stores lists of testfiles that FAILED
 unknownlist=""  # stores lists of testfiles that has UNKNOWN output
 missinglist=""  # stores list of testfiles that are missing
+
+# set the rv32i_soc parameters for testfile $1: chosen by the words on the testfile name, and by the 
+# configuration $2 (optional second argument of the regression tests) which applies to all testfiles
+soc_parameters () {
+    HARTS=1
+    if (( $(grep "smp" -c <<< $1) != 0 )) # if current testfile name has word "smp" then that testfile runs on a 2-hart rv32i_soc
+    then
+        HARTS=2
+    fi
+    THREADS=1
+    if (( $(grep "threads" -c <<< $1) != 0 )) # if current testfile name has word "threads" then that testfile runs on a 2-thread rv32i_soc
+    then
+        THREADS=2
+    fi
+    ICACHE_WAYS=0
+    DCACHE_WAYS=0
+    if (( $(grep "fence_i" -c <<< $1) != 0 )) # if current testfile name has word "fence_i" then that testfile runs with 2-way instruction and data caches
+    then
+        ICACHE_WAYS=2
+        DCACHE_WAYS=2
+    fi
+    if (( $(grep "dcache" -c <<< $1) != 0 )) # if current testfile name has word "dcache" then that testfile runs with a 2-way data cache
+    then
+        DCACHE_WAYS=2
+    fi
+    SHADOW_REGS=0
+    if (( $(grep "shadow" -c <<< $1) != 0 )) # if current testfile name has word "shadow" then that testfile runs with the shadow register bank
+    then
+        SHADOW_REGS=1
+    fi
+    CLIC=0
+    if (( $(grep "clic" -c <<< $1) != 0 )) # if current testfile name has word "clic" then that testfile runs with the CLIC interrupt mode
+    then
+        CLIC=1
+    fi
+    M_EXTENSION=1
+    ZB_EXTENSION=1
+    A_EXTENSION=1
+    C_EXTENSION=1 # compressed code is only generated by testfiles with ".option rvc" (no "c" on MARCH)
+    DUAL_ISSUE=0
+    if (( $(grep "dual" -c <<< $1) != 0 )) # if current testfile name has word "dual" then that testfile runs with dual issue
+    then
+        DUAL_ISSUE=1
+    fi
+    DEEP_PIPELINE=0
+    if (( $(grep "deep" -c <<< $1) != 0 )) # if current testfile name has word "deep" then that testfile runs on the 6-stage pipeline
+    then
+        DEEP_PIPELINE=1
+    fi
+
+    if [ "$2" == "icache1" ] # direct-mapped instruction cache
+    then
+        ICACHE_WAYS=1
+    elif [ "$2" == "icache2" ] # 2-way set-associative instruction cache
+    then
+        ICACHE_WAYS=2
+    elif [ "$2" == "dcache1" ] # direct-mapped data cache
+    then
+        DCACHE_WAYS=1
+    elif [ "$2" == "dcache2" ] # 2-way set-associative data cache
+    then
+        DCACHE_WAYS=2
+    elif [ "$2" == "dual" ] # dual issue
+    then
+        DUAL_ISSUE=1
+    elif [ "$2" == "deep" ] # 6-stage pipeline
+    then
+        DEEP_PIPELINE=1
+    elif [ "$2" != "" ]
+    then
+        printf "\e[31mUNKNOWN CONFIGURATION: $2\n\e[0m"
+        exit 1
+    fi
+    if (( $HARTS > 1 )) # data caches are not coherent between harts (harts share data)
+    then
+        DCACHE_WAYS=0
+    fi
+    if (( $DUAL_ISSUE != 0 )) # dual issue needs 4-byte aligned instructions
+    then
+        C_EXTENSION=0
+    fi
+
+    # target architecture of the RISC-V toolchain follows the extensions enabled on rv32i_soc
+    MARCH="rv32i"
+    if (( $M_EXTENSION != 0 ))
+    then
+        MARCH+="m"
+    fi
+    if (( $A_EXTENSION != 0 ))
+    then
+        MARCH+="a"
+    fi
+    MARCH+="_zicsr"
+    if (( $ZB_EXTENSION != 0 ))
+    then
+        MARCH+="_zba_zbb"
+    fi
+    GCC_FLAGS="${GCC_FLAGS#* }" # remove the -march option (first word of GCC_FLAGS)
+    GCC_FLAGS="-march=${MARCH} -DHARTS=$((HARTS*THREADS)) ${GCC_FLAGS#-DHARTS=* }" # replace the -march option and the number of harts of the C library (every thread is a hart)
+
+    # parameters of rv32i_soc_TB for Icarus Verilog (-P) and Modelsim (-G)
+    SOC_PARAMETERS="HARTS=${HARTS} THREADS=${THREADS} ICACHE_WAYS=${ICACHE_WAYS} DCACHE_WAYS=${DCACHE_WAYS} M_EXTENSION=${M_EXTENSION} ZB_EXTENSION=${ZB_EXTENSION} C_EXTENSION=${C_EXTENSION} A_EXTENSION=${A_EXTENSION} SHADOW_REGS=${SHADOW_REGS} CLIC=${CLIC} DUAL_ISSUE=${DUAL_ISSUE} DEEP_PIPELINE=${DEEP_PIPELINE}"
+    IVERILOG_PARAMETERS=""
+    VSIM_PARAMETERS=""
+    for parameter in $SOC_PARAMETERS
+    do
+        IVERILOG_PARAMETERS+="-Prv32i_soc_TB.${parameter} "
+        VSIM_PARAMETERS+="-G ${parameter} "
+    done
+}
  
 start_time=$SECONDS
 
@@ -112,11 +240,17 @@ then
     rtl="../rtl/rv32i_forwarding.v
           ../rtl/rv32i_basereg.v 
           ../rtl/rv32i_fetch.v
+          ../rtl/rv32i_expander.v
           ../rtl/rv32i_decoder.v 
           ../rtl/rv32i_alu.v 
           ../rtl/rv32i_memoryaccess.v 
           ../rtl/rv32i_writeback.v
           ../rtl/rv32i_csr.v
+          ../rtl/rv32i_icache.v
+          ../rtl/rv32i_dcache.v
+          ../rtl/rv32i_operand.v
+          ../rtl/rv32i_skid.v
+          ../rtl/rv32i_threads.v
           ../rtl/rv32i_core.v"
           
     verilator -Wall -I"../rtl/"  -DICARUS --lint-only $rtl
@@ -133,7 +267,7 @@ then
     fi
 
 
-elif [ "$1" == "rv32ui" ] || [ "$1" == "rv32mi" ] || [ "$1" == "extra" ] || [ "$1" == "all" ] || [ "$1" == "" ] # regression tests
+elif [ "$1" == "rv32ui" ] || [ "$1" == "rv32mi" ] || [ "$1" == "rv32um" ] || [ "$1" == "rv32uc" ] || [ "$1" == "rv32ua" ] || [ "$1" == "extra" ] || [ "$1" == "all" ] || [ "$1" == "" ] # regression tests
 then
     printf "\n"
     for testfile in $testfiles      #iterate through all testfiles
@@ -148,6 +282,7 @@ then
                 countpassed=$((countpassed+1)) # increment number of PASSED (skip is considered pass)
                 continue
             fi
+            soc_parameters $testfile $2
             
             ########################################## COMPILE TESTFILE WITH RISC-V TOOLCHAIN ##########################################
             printf "\tcompiling assembly file....."
@@ -233,23 +368,29 @@ then
                 elif (( $(grep "sbreak" -c <<< $testfile) != 0 )) # if current testfile name has word "sbreak" then that testfile will halt only on ecall
                 then
                     vlog -quiet +incdir+../rtl/ +define+HALT_ON_ECALL ${rtlfiles} # halt core on ecall
+                elif (( $(grep "trap" -c <<< $testfile) != 0 )) # if current testfile name has word "trap" then that testfile has ecall/ebreak in the middle and halts only at the exit code
+                then
+                    vlog -quiet +incdir+../rtl/ +define+HALT_ON_EXIT ${rtlfiles} # halt core only at the exit code
                 else
                     vlog -quiet +incdir+../rtl/ ${rtlfiles} # current testfile will halt on both ebreak/ecall 
                 fi
                 
-                a=$(vsim -quiet -batch -G MEMORY="${MEMORY}" rv32i_soc_TB -do "run -all;exit" | grep "PASS:\|FAIL:\|UNKNOWN:" -A1)
+                a=$(vsim -quiet -batch -G MEMORY="${MEMORY}" ${VSIM_PARAMETERS} rv32i_soc_TB -do "run -all;exit" | grep "PASS:\|FAIL:\|UNKNOWN:" -A1)
             else
                 printf "\tsimulating with Icarus Verilog....."
                 rm -f testbench.vvp # remove previous occurence of vvp file  
 
                 if (( $(grep "exception" -c <<< $testfile) != 0 )) # if current testfile name has word "exception" then that testfile will not halt on ebreak/ecall
                 then
-                    iverilog -I "../rtl/" -o testbench.vvp -DHALT_ON_ILLEGAL_INSTRUCTION -DICARUS $rtlfiles # current testfile will halt on illegal instruction only
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DHALT_ON_ILLEGAL_INSTRUCTION -DICARUS $rtlfiles # current testfile will halt on illegal instruction only
                 elif (( $(grep "sbreak" -c <<< $testfile) != 0 )) # if current testfile name has word "sbreak" then that testfile will halt only on ecall
                 then
-                    iverilog -I "../rtl/" -o testbench.vvp -DHALT_ON_ECALL -DICARUS $rtlfiles # halt core on ecall
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DHALT_ON_ECALL -DICARUS $rtlfiles # halt core on ecall
+                elif (( $(grep "trap" -c <<< $testfile) != 0 )) # if current testfile name has word "trap" then that testfile has ecall/ebreak in the middle and halts only at the exit code
+                then
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DHALT_ON_EXIT -DICARUS $rtlfiles # halt core only at the exit code
                 else
-                    iverilog -I "../rtl/" -o testbench.vvp -DICARUS $rtlfiles
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DICARUS $rtlfiles
                 fi
                 a=$(vvp -n testbench.vvp | grep "PASS:\|FAIL:\|UNKNOWN:" -A1)
             fi
@@ -289,15 +430,28 @@ then
     elif [ "$1" == "rv32mi" ] 
     then
         printf " [rv32mi] "
+    elif [ "$1" == "rv32um" ] 
+    then
+        printf " [rv32um] "
+    elif [ "$1" == "rv32uc" ] 
+    then
+        printf " [rv32uc] "
+    elif [ "$1" == "rv32ua" ] 
+    then
+        printf " [rv32ua] "
     elif [ "$1" == "extra" ] 
     then
         printf " [extra] "
     elif [ "$1" == "all" ] 
     then
-        printf " [rv32ui][rv32mi][extra] "
+        printf " [rv32ui][rv32mi][rv32um][rv32uc][rv32ua][extra] "
     elif [ "$1" == "" ]
     then
-        printf " [rv32ui][rv32mi] "
+        printf " [rv32ui][rv32mi][rv32um][rv32uc][rv32ua] "
+    fi
+    if [ "$2" != "" ]
+    then
+        printf "[$2] "
     fi
     
     if (($countpassed == $countfile))     # print names of testfiles that FAILED if > 0
@@ -437,6 +591,7 @@ else    # DEBUG MODE: first argument given is the assembly file to be tested and
     printf "\nPROCESSING: $1\n"
     if [ -f "${INDIVIDUAL_TESTDIR}/${1}" ]   # true if testfile (first argument) exists
     then   
+        soc_parameters $1
         ########################################## COMPILE TESTFILE WITH RISC-V TOOLCHAIN ##########################################
         printf "\tcompiling assembly file....."
 
@@ -533,11 +688,14 @@ else    # DEBUG MODE: first argument given is the assembly file to be tested and
                 elif (( $(grep "sbreak" -c <<< $1) != 0 )) # if current testfile name has word "sbreak" then that testfile will halt only on ecall
                 then
                     vlog -quiet +incdir+../rtl/ +define+HALT_ON_ECALL ${rtlfiles} # halt core on ecall
+                elif (( $(grep "trap" -c <<< $1) != 0 )) # if current testfile name has word "trap" then that testfile has ecall/ebreak in the middle and halts only at the exit code
+                then
+                    vlog -quiet +incdir+../rtl/ +define+HALT_ON_EXIT ${rtlfiles} # halt core only at the exit code
                 else
                     vlog -quiet +incdir+../rtl/ ${rtlfiles} # current testfile will halt on both ebreak/ecall 
                 fi
-                vsim $2 -G MEMORY="${MEMORY}" rv32i_soc_TB -do "do wave.do;run -all"
-                a=$(vsim -batch -G MEMORY="${MEMORY}" rv32i_soc_TB -do "run -all;exit" | grep "PASS:\|FAIL:\|UNKNOWN:" -A1)
+                vsim $2 -G MEMORY="${MEMORY}" ${VSIM_PARAMETERS} rv32i_soc_TB -do "do wave.do;run -all"
+                a=$(vsim -batch -G MEMORY="${MEMORY}" ${VSIM_PARAMETERS} rv32i_soc_TB -do "run -all;exit" | grep "PASS:\|FAIL:\|UNKNOWN:" -A1)
             else
                 printf "\tsimulating with Icarus Verilog.....\n"
                 printf "\n##############################################################\n"
@@ -545,12 +703,15 @@ else    # DEBUG MODE: first argument given is the assembly file to be tested and
 
                 if (( $(grep "exception" -c <<< $1) != 0 ))
                 then
-                    iverilog -I "../rtl/" -o testbench.vvp -DHALT_ON_ILLEGAL_INSTRUCTION -DICARUS $rtlfiles # current testfile will halt on illegal instruction only
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DHALT_ON_ILLEGAL_INSTRUCTION -DICARUS $rtlfiles # current testfile will halt on illegal instruction only
                 elif (( $(grep "sbreak" -c <<< $1) != 0 )) # if current testfile name has word "sbreak" then that testfile will halt only on ecall
                 then
-                    iverilog -I "../rtl/" -o testbench.vvp -DHALT_ON_ECALL -DICARUS $rtlfiles # halt core on ecall
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DHALT_ON_ECALL -DICARUS $rtlfiles # halt core on ecall
+                elif (( $(grep "trap" -c <<< $1) != 0 )) # if current testfile name has word "trap" then that testfile has ecall/ebreak in the middle and halts only at the exit code
+                then
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DHALT_ON_EXIT -DICARUS $rtlfiles # halt core only at the exit code
                 else
-                    iverilog -I "../rtl/" -o testbench.vvp -DICARUS $rtlfiles # current testfile will halt on both ebreak/ecall 
+                    iverilog -I "../rtl/" -o testbench.vvp ${IVERILOG_PARAMETERS} -DICARUS $rtlfiles # current testfile will halt on both ebreak/ecall 
                 fi
                 vvp -n testbench.vvp
                 if [ "$2" == "-gui" ]
@@ -589,12 +750,15 @@ fi
 
 
 # HOW TO USE
-# $ ./test.sh = use the official tests from RISCV [rv32ui and rv32mi]
+# $ ./test.sh = use the official tests from RISCV [rv32ui, rv32mi, rv32um, rv32uc, and rv32ua]
 # $ ./test.sh compile = compile-only the rtl files
 # $ ./test.sh rv32ui = test only the rv32ui official test
 # $ ./test.sh rv32mi = test only the rv32mi official test
+# $ ./test.sh rv32um = test only the rv32um official test (M extension)
+# $ ./test.sh rv32uc = test only the rv32uc official test (C extension)
+# $ ./test.sh rv32ua = test only the rv32ua official test (A extension)
 # $ ./test.sh extra = test only the assembly files inside extra folder [contains tests for interrupts which the official tests don't have]
-# $ ./test.sh all = test rv32ui, rv32mi, and mytest
+# $ ./test.sh all = test rv32ui, rv32mi, rv32um, rv32uc, rv32ua, and mytest
 # $ ./test.sh add.S = test and debug testfile "add.S" which is located at INDIVIDUAL_TESTDIR
 # $ ./test.sh add.S -gui = test and debug testfile "add.S" and open wave in Icarus
 # $ ./test.sh add.S -nosim = compile and debug testfile "add.S" without simulating it